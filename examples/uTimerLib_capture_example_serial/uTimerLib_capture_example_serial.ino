@@ -0,0 +1,66 @@
+/**
+ * uTimerLib example
+ *
+ * Measures a signal frequency using timer input capture.
+ * Pin: 8 on UNO (define UTIMERLIB_AVR_TIMER1 in uTimerLib.h), 13 on Leonardo; see uTimerLibCapture.h for other devices.
+ * On AVR, this sketch owns timer capture and overflow interrupt vectors unless UTIMERLIB_CAPTURE_HANDLER is defined.
+ *
+ * @author Naguissa
+ * @url https://www.github.com/Naguissa/uTimerLib
+ * @url https://www.foroelectro.net
+ */
+
+#include "Arduino.h"
+#include "uTimerLib.h"
+#include "uTimerLibCapture.h"
+
+#define CAPTURE_PIN 8
+
+uint32_t captures[32];
+uTimerLibCapture capture(captures, 32);
+
+#if defined(UTIMERLIB_CAPTURE_AVR) && !defined(UTIMERLIB_CAPTURE_HANDLER)
+	// uTimerLib doesn't own timer capture and overflow vectors: this sketch does, and calls capture hooks from them
+	#ifdef __AVR_ATmega32U4__
+		ISR(TIMER3_CAPT_vect) {
+			uTimerLibCapture::captureHandler();
+		}
+		ISR(TIMER3_OVF_vect) {
+			uTimerLibCapture::overflowHandler();
+		}
+	#else
+		ISR(TIMER1_CAPT_vect) {
+			uTimerLibCapture::captureHandler();
+		}
+		ISR(TIMER1_OVF_vect) {
+			uTimerLibCapture::overflowHandler();
+		}
+	#endif
+#endif
+
+void setup() {
+	Serial.begin(57600);
+	if (!capture.begin(CAPTURE_PIN, RISING)) {
+		Serial.println("Input capture not available on this pin");
+	}
+	#if defined(UTIMERLIB_CAPTURE_AVR) && !defined(UTIMERLIB_CAPTURE_HANDLER)
+		// Vectors are this sketch ones, so it enables their interrupts
+		#ifdef __AVR_ATmega32U4__
+			TIMSK3 |= (1 << ICIE3) | (1 << TOIE3);
+		#else
+			TIMSK1 |= (1 << ICIE1) | (1 << TOIE1);
+		#endif
+	#endif
+}
+
+void loop() {
+	uint32_t batch[16];
+	uint16_t count = capture.read(batch, 16);
+
+	Serial.print(count);
+	Serial.print(" edges, ");
+	Serial.print(capture.getFrequency(10));
+	Serial.print(" Hz, lost: ");
+	Serial.println(capture.getLost());
+	delay(1000);
+}
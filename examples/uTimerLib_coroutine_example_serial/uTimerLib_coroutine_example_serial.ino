@@ -0,0 +1,56 @@
+/**
+ * uTimerLib example
+ *
+ * @author Naguissa
+ * @url https://www.github.com/Naguissa/uTimerLib
+ * @url https://www.foroelectro.net
+ */
+
+#include "Arduino.h"
+#include "uTimerLib.h"
+#include "uTimerLibCoroutine.h"
+
+#if defined(UTIMERLIB_COROUTINES)
+
+	// Two sequential tasks sharing TimerLib
+	uTimerLibTask blink() {
+		pinMode(LED_BUILTIN, OUTPUT);
+		for (;;) {
+			digitalWrite(LED_BUILTIN, HIGH);
+			co_await TimerLib.sleep_us(100000);
+			digitalWrite(LED_BUILTIN, LOW);
+			co_await TimerLib.sleep_us(900000);
+		}
+	}
+
+	uTimerLibTask countdown(unsigned int from) {
+		for (unsigned int i = from; i > 0; i--) {
+			Serial.println(i);
+			co_await TimerLib.sleep_us(1000000);
+		}
+		Serial.println("Done");
+	}
+
+	void setup() {
+		Serial.begin(57600);
+		blink();
+		if (!countdown(10)) {
+			Serial.println("No free coroutine frame");
+		}
+	}
+
+	void loop() {
+		uTimerLibTask::run();
+	}
+
+#else
+
+	void setup() {
+		Serial.begin(57600);
+		Serial.println("This toolchain doesn't support C++20 coroutines");
+	}
+
+	void loop() {
+	}
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * uTimerLib example
+ *
+ * @author Naguissa
+ * @url https://www.github.com/Naguissa/uTimerLib
+ * @url https://www.foroelectro.net
+ */
+
+#include "Arduino.h"
+#include "uTimerLib.h"
+#include "uTimerLibExecutive.h"
+
+// Base tick: 10ms; hyperperiod: 100 ticks (1s), two bytes each (table in use and one built aside)
+uint8_t frames[200];
+uTimerLibExecutive executive(frames, sizeof(frames));
+
+volatile unsigned long int count10ms = 0;
+volatile unsigned long int count100ms = 0;
+volatile unsigned long int count1s = 0;
+
+void task10ms() {
+	count10ms++;
+}
+
+void task100ms() {
+	count100ms++;
+}
+
+void task1s() {
+	count1s++;
+}
+
+void setup() {
+	Serial.begin(57600);
+	executive.addTask(task10ms, 1);
+	executive.addTask(task100ms, 10);
+	executive.addTask(task1s, 100);
+	if (!executive.begin(10000)) {
+		Serial.println("Frame table too small");
+	}
+}
+
+void loop() {
+	Serial.print(count10ms);
+	Serial.print(" ");
+	Serial.print(count100ms);
+	Serial.print(" ");
+	Serial.println(count1s);
+	delay(1000);
+}
@@ -0,0 +1,64 @@
+/**
+ * uTimerLib example: timer interrupt cost, in CPU cycles, measured on the board
+ *
+ * Counts loop iterations during one second with timer stopped, and again with a short interval running.
+ * CPU time lost, divided by interrupts done, is the cost of each interrupt, callback included:
+ * first on interrupt fast path, then on regular path (an overrun policy leaves fast path).
+ *
+ * Result has some noise from other interrupts (millis), so run it a few times.
+ *
+ * @author Naguissa
+ * @url https://www.github.com/Naguissa/uTimerLib
+ * @url https://www.foroelectro.net
+ */
+
+#include "Arduino.h"
+#include "uTimerLib.h"
+
+// Interval, in microseconds: shorter gives more interrupts to measure, but it has to be longer than the interrupt itself
+#define PERIOD_US 100
+
+volatile unsigned long int calls = 0;
+unsigned long int idleLoops = 0;
+
+void timed_function() {
+	calls++;
+}
+
+unsigned long int countLoops() {
+	unsigned long int loops = 0;
+	unsigned long int start = millis();
+	while (millis() - start < 1000) {
+		loops++;
+	}
+	return loops;
+}
+
+void measure(const char *name, unsigned char policy) {
+	TimerLib.setOverrunPolicy(policy);
+	TimerLib.setInterval_us(timed_function, PERIOD_US);
+	calls = 0;
+	unsigned long int loops = countLoops();
+	unsigned long int done = calls;
+	TimerLib.clearTimer();
+
+	Serial.print(name);
+	Serial.print(": ");
+	Serial.print(done);
+	Serial.print(" interrupts, ");
+	Serial.print((float) (idleLoops - loops) / idleLoops * F_CPU / done);
+	Serial.println(" cycles each");
+}
+
+void setup() {
+	Serial.begin(57600);
+	delay(2000);
+}
+
+void loop() {
+	idleLoops = countLoops();
+	measure("Fast path", UTIMERLIB_OVERRUN_NONE);
+	measure("Regular path", UTIMERLIB_OVERRUN_SKIP);
+	Serial.println();
+	delay(1000);
+}
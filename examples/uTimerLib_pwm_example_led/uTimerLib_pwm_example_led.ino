@@ -0,0 +1,35 @@
+/**
+ * uTimerLib example
+ *
+ * @author Naguissa
+ * @url https://www.github.com/Naguissa/uTimerLib
+ * @url https://www.foroelectro.net
+ */
+
+#include "Arduino.h"
+#include "uTimerLib.h"
+#include "uTimerLibPWM.h"
+
+// 4 LEDs on any pins, 10ms period (100Hz)
+#define PERIOD 10000
+
+uint8_t pins[] = {2, 3, 4, 5};
+uTimerLibPWM pwm;
+
+unsigned long int duty = 0;
+
+void setup() {
+	for (uint8_t i = 0; i < sizeof(pins); i++) {
+		pwm.attach(pins[i]);
+	}
+	pwm.begin(PERIOD);
+}
+
+void loop() {
+	// Each LED fades with a different phase; new duties are applied at next period start
+	for (uint8_t i = 0; i < sizeof(pins); i++) {
+		pwm.setDuty_us(pins[i], (duty + i * PERIOD / 4) % PERIOD);
+	}
+	duty = (duty + 100) % PERIOD;
+	delay(20);
+}
@@ -0,0 +1,88 @@
+/**
+ * uTimerLib example
+ *
+ * Plays a 1kHz triangle wave on DAC (A0) by DMA, one sample each 20us, refilling each buffer half when it has been sent.
+ * Only SAMD21 and SAMD51: needs UTIMERLIB_USE_DMA defined (uncomment it in uTimerLib.h or add it to your build flags).
+ *
+ * @author Naguissa
+ * @url https://www.github.com/Naguissa/uTimerLib
+ * @url https://www.foroelectro.net
+ */
+
+#include "Arduino.h"
+#include "uTimerLib.h"
+#include "uTimerLibStream.h"
+
+#if defined(UTIMERLIB_USE_DMA) && (defined(_SAMD21_) || defined(__SAMD51__))
+
+	#define SAMPLES 100 // 50 each half: one wave period
+	#ifdef _SAMD21_
+		#define DAC_MAX 1023
+		uTimerLibStream stream(&DAC->DATA.reg, 2);
+	#else
+		#define DAC_MAX 4095
+		uTimerLibStream stream(&DAC->DATA[0].reg, 2);
+	#endif
+
+	uint16_t samples[SAMPLES];
+	volatile unsigned long int halves = 0;
+
+	/**
+	 * Called from DMAC interrupt when a half has been sent: refill it
+	 */
+	void refill(uint8_t half) {
+		uint16_t *s = samples + half * (SAMPLES / 2);
+		for (uint8_t i = 0; i < SAMPLES / 2; i++) {
+			s[i] = (i < SAMPLES / 4 ? i : SAMPLES / 2 - i) * (DAC_MAX / (SAMPLES / 4));
+		}
+		halves++;
+	}
+
+	#if !defined(UTIMERLIB_DMA_HANDLER)
+		// uTimerLib doesn't own DMAC interrupt handler: this sketch does, and calls stream hook from it
+		#ifdef _SAMD21_
+			void DMAC_Handler() {
+				uTimerLibStream::dmaHandler();
+			}
+		#else
+			void DMAC_0_Handler() {
+				uTimerLibStream::dmaHandler();
+			}
+		#endif
+	#endif
+
+	void setup() {
+		Serial.begin(57600);
+		analogWriteResolution(DAC_MAX == 1023 ? 10 : 12);
+		analogWrite(A0, 0); // Sets up DAC
+		refill(0);
+		refill(1);
+		#if !defined(UTIMERLIB_DMA_HANDLER)
+			#ifdef _SAMD21_
+				NVIC_EnableIRQ(DMAC_IRQn);
+			#else
+				NVIC_EnableIRQ(DMAC_0_IRQn);
+			#endif
+		#endif
+		if (!stream.begin(samples, SAMPLES, 20, refill)) {
+			Serial.println("Stream not started");
+		}
+	}
+
+	void loop() {
+		Serial.print("Halves sent: ");
+		Serial.println(halves);
+		delay(1000);
+	}
+
+#else
+
+	void setup() {
+		Serial.begin(57600);
+		Serial.println("UTIMERLIB_USE_DMA is not defined, or board is not SAMD21 nor SAMD51");
+	}
+
+	void loop() {
+	}
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * uTimerLib example
+ *
+ * @author Naguissa
+ * @url https://www.github.com/Naguissa/uTimerLib
+ * @url https://www.foroelectro.net
+ */
+
+#include "Arduino.h"
+#include "uTimerLib.h"
+
+// Needs UTIMERLIB_TRACE defined (uncomment it at the top of uTimerLib.h or add it to your build flags)
+#if defined(UTIMERLIB_TRACE)
+
+	volatile unsigned long int count = 0;
+
+	void timed_function() {
+		count++;
+		delayMicroseconds(count % 8 == 0 ? 1500 : 100); // Some slow calls, to see overruns
+	}
+
+	void setup() {
+		Serial.begin(57600);
+		TimerLib.setOverrunPolicy(UTIMERLIB_OVERRUN_SKIP);
+		TimerLib.setInterval_us(timed_function, 1000);
+	}
+
+	void loop() {
+		delay(2000);
+		// Decode Serial log with: python3 extras/uTimerLibTrace.py serial.log -o trace.json
+		TimerLib.traceDump(Serial);
+	}
+
+#else
+
+	void setup() {
+		Serial.begin(57600);
+		Serial.println("UTIMERLIB_TRACE is not defined");
+	}
+
+	void loop() {
+	}
+
+#endif
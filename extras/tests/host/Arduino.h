@@ -0,0 +1,102 @@
+/**
+ * Host build of Arduino API for uTimerLib tests: an ESP32 board, with FreeRTOS tasks and esp_timer on POSIX threads.
+ * With HOST_STM32 defined it's an STM32 board instead (Roger Clark core, Timer3 in HardwareTimer.h), with STM32FreeRTOS.
+ * With HOST_AVR it's an UNO (ATmega328P registers in avr.h), and with HOST_SAMD21 or HOST_SAMD51 a Zero or an M4 (samd.h).
+ * With HOST_SAM it's a Due (TC registers in sam.h), and with HOST_ESP8266 an ESP8266 board (Ticker.h).
+ *
+ * Implemented in host.cpp. Timer is not run by itself: each test calls timer interrupt from its own threads,
+ * as esp_timer task, other core or other interrupts would do.
+ *
+ * @file Arduino.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostArduino_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostArduino_
+
+	#include <stdint.h>
+	#include <stddef.h>
+
+	#if defined(HOST_STM32)
+		#define _VARIANT_ARDUINO_STM32_ 1
+		#define F_CPU 72000000UL
+
+		/**
+		 * \brief Interrupts are masked with a mutex shared by all threads; as on hardware, it doesn't nest
+		 */
+		void noInterrupts();
+		void interrupts();
+	#elif defined(HOST_AVR)
+		#define ARDUINO_ARCH_AVR 1
+		#define F_CPU 16000000UL
+
+		#include "avr.h"
+	#elif defined(HOST_SAMD21)
+		#define _SAMD21_ 1
+		#define F_CPU 48000000UL
+
+		#include "samd.h"
+	#elif defined(HOST_SAMD51)
+		#define __SAMD51__ 1
+		#define F_CPU 120000000UL
+
+		#include "samd.h"
+	#elif defined(HOST_SAM)
+		#define ARDUINO_ARCH_SAM 1
+		#define F_CPU 84000000UL
+		#define VARIANT_MCK 84000000UL
+
+		#include "sam.h"
+	#elif defined(HOST_ESP8266)
+		#define ARDUINO_ARCH_ESP8266 1
+		#define F_CPU 80000000UL
+
+		/**
+		 * \brief Interrupts are masked with a mutex shared by all threads; previous level is 15 or 0
+		 */
+		void noInterrupts();
+		void interrupts();
+		uint32_t xt_rsil(uint32_t);
+		void xt_wsr_ps(uint32_t);
+		uint64_t micros64();
+	#else
+		#define ARDUINO_ARCH_ESP32 1
+		#define F_CPU 240000000UL
+
+		#include "freertos/FreeRTOS.h"
+		#include "freertos/task.h"
+	#endif
+
+	typedef uint8_t byte;
+
+	#define LOW 0
+	#define HIGH 1
+	#define INPUT 0
+	#define OUTPUT 1
+	#define FALLING 2
+	#define RISING 3
+	#define HEX 16
+	#define DEC 10
+
+	void pinMode(uint8_t, uint8_t);
+	void digitalWrite(uint8_t, uint8_t);
+	int digitalRead(uint8_t);
+	unsigned long micros();
+	unsigned long millis();
+
+	class Print {
+		public:
+			virtual size_t write(uint8_t) = 0;
+			size_t write(const char *);
+			size_t print(const char *);
+			size_t print(unsigned long, int = DEC);
+			size_t println(const char * = "");
+	};
+
+#endif
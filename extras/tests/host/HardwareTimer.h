@@ -0,0 +1,61 @@
+/**
+ * Host Timer3 of Roger Clark Arduino STM32 core for uTimerLib tests: only its set up is recorded,
+ * tests call timer interrupt. Implemented in host.cpp.
+ *
+ * @file HardwareTimer.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostHardwareTimer_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostHardwareTimer_
+
+	#include <stdint.h>
+
+	typedef uint32_t uint32;
+	typedef uint16_t uint16;
+
+	typedef enum {
+		TIMER_DISABLED,
+		TIMER_OUTPUTCOMPARE
+	} timer_mode;
+
+	#define TIMER_CH1 1
+	#define TIMER_SR_CC1IF (1 << 1)
+
+	typedef struct {
+		volatile uint32 SR;
+	} timer_gen_reg_map;
+
+	typedef struct {
+		struct {
+			timer_gen_reg_map *gen;
+		} regs;
+	} timer_dev;
+
+	/**
+	 * \brief No constructor, so it's ready before TimerLib constructor clears it
+	 */
+	class HardwareTimer {
+		public:
+			void pause();
+			void resume();
+			void refresh();
+			void setMode(int, timer_mode);
+			uint16 setPeriod(uint32);
+			void setCompare(int, uint16);
+			void setCount(uint16);
+			void attachInterrupt(int, void (*)());
+			timer_dev *c_dev();
+
+			void (*handler)();	// Attached interrupt
+			bool running;
+			uint32 period;		// Microseconds
+	};
+
+#endif
@@ -0,0 +1,20 @@
+/**
+ * Host STM32FreeRTOS library for uTimerLib tests: same FreeRTOS tasks on POSIX threads as host ESP32 board.
+ *
+ * @file STM32FreeRTOS.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostSTM32FreeRTOS_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostSTM32FreeRTOS_
+
+	#include "freertos/FreeRTOS.h"
+	#include "freertos/task.h"
+
+#endif
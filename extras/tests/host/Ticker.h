@@ -0,0 +1,28 @@
+/**
+ * Host Ticker of ESP8266 Arduino core for uTimerLib tests: only its period is recorded, tests call its callback. Implemented in host.cpp.
+ *
+ * @file Ticker.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostTicker_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostTicker_
+
+	#include <stdint.h>
+
+	class Ticker {
+		public:
+			void attach_ms(uint32_t, void (*)());
+			void detach();
+
+			void (*callback)() = nullptr;
+			uint32_t ms = 0;	// 0 if detached
+	};
+
+#endif
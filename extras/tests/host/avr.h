@@ -0,0 +1,88 @@
+/**
+ * Host ATmega328P (UNO) registers for uTimerLib tests: plain variables, so library sets them up and tests run timer
+ * from them (see test_cycles.cpp). Defined in host.cpp. Included by Arduino.h with HOST_AVR.
+ *
+ * @file avr.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostAvr_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostAvr_
+
+	#include <stdint.h>
+
+	extern volatile uint8_t SREG, CLKPR, ASSR, GTCCR, PORTB, DDRB, PINB;
+	extern volatile uint8_t TIMSK1, TIFR1, TCCR1A, TCCR1B, TCCR1C;
+	extern volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+	extern volatile uint8_t TIMSK2, TIFR2, TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B;
+
+	#define TOIE1 0
+	#define OCIE1A 1
+	#define OCIE1B 2
+	#define ICIE1 5
+	#define TOV1 0
+	#define OCF1A 1
+	#define OCF1B 2
+	#define ICF1 5
+	#define CS10 0
+	#define CS11 1
+	#define CS12 2
+	#define WGM10 0
+	#define WGM11 1
+	#define WGM12 3
+	#define WGM13 4
+	#define ICES1 6
+	#define ICNC1 7
+	#define COM1A0 6
+	#define COM1A1 7
+	#define COM1B0 4
+	#define COM1B1 5
+
+	#define TOIE2 0
+	#define OCIE2A 1
+	#define OCIE2B 2
+	#define TOV2 0
+	#define OCF2A 1
+	#define OCF2B 2
+	#define CS20 0
+	#define CS21 1
+	#define CS22 2
+	#define WGM20 0
+	#define WGM21 1
+	#define WGM22 3
+	#define COM2A0 6
+	#define COM2A1 7
+	#define COM2B0 4
+	#define COM2B1 5
+	#define AS2 5
+
+	#define CLKPCE 7
+
+	/**
+	 * \brief Interrupt vectors are plain functions, called by tests
+	 */
+	#define ISR(vector, ...) extern "C" void vector(void); void vector(void)
+	#define ISR_NAKED
+	#define cli() (SREG &= 0x7F)
+	#define sei() (SREG |= 0x80)
+	#define noInterrupts() cli()
+	#define interrupts() sei()
+
+	#define NOT_ON_TIMER 0
+	#define TIMER1A 3
+	#define TIMER1B 4
+	#define TIMER2A 6
+	#define TIMER2B 7
+	#define PB 2
+	#define PD 4
+	uint8_t digitalPinToTimer(uint8_t);
+	uint8_t digitalPinToPort(uint8_t);
+	uint8_t digitalPinToBitMask(uint8_t);
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * Host esp_timer for uTimerLib tests: timers are only recorded, tests call their callbacks. Implemented in host.cpp.
+ *
+ * @file esp_timer.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostEspTimer_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostEspTimer_
+
+	#include <stdint.h>
+
+	typedef struct esp_timer *esp_timer_handle_t;
+	typedef void (*esp_timer_cb_t)(void *);
+	typedef int esp_err_t;
+	typedef struct {
+		esp_timer_cb_t callback;
+		void *arg;
+	} esp_timer_create_args_t;
+
+	esp_err_t esp_timer_create(const esp_timer_create_args_t *, esp_timer_handle_t *);
+	esp_err_t esp_timer_start_periodic(esp_timer_handle_t, uint64_t);
+	esp_err_t esp_timer_start_once(esp_timer_handle_t, uint64_t);
+	esp_err_t esp_timer_stop(esp_timer_handle_t);
+	esp_err_t esp_timer_delete(esp_timer_handle_t);
+	int64_t esp_timer_get_time();
+
+#endif
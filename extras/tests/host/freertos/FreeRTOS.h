@@ -0,0 +1,52 @@
+/**
+ * Host FreeRTOS for uTimerLib tests: critical sections are a recursive mutex shared by all threads. Implemented in host.cpp.
+ *
+ * @file FreeRTOS.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostFreeRTOS_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostFreeRTOS_
+
+	#include <stdint.h>
+	#include <pthread.h>
+
+	typedef long BaseType_t;
+	typedef unsigned long UBaseType_t;
+	typedef uint32_t TickType_t;
+
+	#define pdFALSE 0
+	#define pdTRUE 1
+	#define pdPASS 1
+	#define portMAX_DELAY 0xFFFFFFFF
+	#define portNUM_PROCESSORS 2
+	#define configMAX_PRIORITIES 25
+	#define tskNO_AFFINITY 0x7FFFFFFF
+
+	/**
+	 * \brief Spinlock shared by both cores; nested on same core as portMUX
+	 */
+	typedef struct {
+		pthread_mutex_t mutex;
+	} portMUX_TYPE;
+	#define portMUX_INITIALIZER_UNLOCKED {PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP}
+	#define portENTER_CRITICAL(mux) pthread_mutex_lock(&(mux)->mutex)
+	#define portEXIT_CRITICAL(mux) pthread_mutex_unlock(&(mux)->mutex)
+	#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+	#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+	#define portENTER_CRITICAL_SAFE(mux) portENTER_CRITICAL(mux)
+	#define portEXIT_CRITICAL_SAFE(mux) portEXIT_CRITICAL(mux)
+
+	/**
+	 * \brief Counts context switches requested from interrupts, to be checked by tests
+	 */
+	void hostYieldFromIsr(BaseType_t);
+	#define portYIELD_FROM_ISR(woken) hostYieldFromIsr(woken)
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * Host FreeRTOS tasks for uTimerLib tests: each task is a thread, with a notification counter. Implemented in host.cpp.
+ *
+ * @file task.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostTask_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostTask_
+
+	#include "FreeRTOS.h"
+
+	typedef struct tskTaskControlBlock *TaskHandle_t;
+	typedef void (*TaskFunction_t)(void *);
+
+	BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *, BaseType_t);
+	BaseType_t xTaskCreate(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *);
+	TaskHandle_t xTaskGetCurrentTaskHandle();
+	UBaseType_t uxTaskPriorityGet(TaskHandle_t);
+	void vTaskPrioritySet(TaskHandle_t, UBaseType_t);
+	BaseType_t xTaskNotifyGive(TaskHandle_t);
+	void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t *);
+	uint32_t ulTaskNotifyTake(BaseType_t, TickType_t);
+
+#endif
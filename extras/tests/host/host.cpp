@@ -0,0 +1,585 @@
+/**
+ * Host Arduino, FreeRTOS and esp_timer (or STM32 Timer3, AVR, SAMD or SAM registers or ESP8266 Ticker, with HOST_STM32, HOST_AVR, HOST_SAMD21,
+ * HOST_SAMD51, HOST_SAM or HOST_ESP8266) for uTimerLib tests, on POSIX threads
+ *
+ * @file host.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "Arduino.h"
+#if defined(HOST_STM32)
+	#include "HardwareTimer.h"
+#elif defined(HOST_ESP8266)
+	#include "Ticker.h"
+#endif
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "host.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Arduino
+
+static std::atomic<uint8_t> _hostPins[256];
+
+void pinMode(uint8_t pin, uint8_t mode) { }
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+	_hostPins[pin] = value;
+}
+
+int digitalRead(uint8_t pin) {
+	return _hostPins[pin];
+}
+
+unsigned long micros() {
+	return (unsigned long) esp_timer_get_time();
+}
+
+unsigned long millis() {
+	return (unsigned long) (esp_timer_get_time() / 1000);
+}
+
+size_t Print::write(const char *s) {
+	size_t n = 0;
+	while (*s) {
+		n += write((uint8_t) *s++);
+	}
+	return n;
+}
+
+size_t Print::print(const char *s) {
+	return write(s);
+}
+
+size_t Print::print(unsigned long value, int base) {
+	char buffer[33];
+	char *p = buffer + sizeof(buffer) - 1;
+	*p = 0;
+	do {
+		*--p = "0123456789abcdef"[value % base];
+		value /= base;
+	} while (value != 0);
+	return write(p);
+}
+
+size_t Print::println(const char *s) {
+	return write(s) + write("\r\n");
+}
+
+#if defined(HOST_STM32) || defined(HOST_SAM) || defined(HOST_ESP8266)
+	// As on hardware, masking doesn't nest: interrupts() unmasks them, however many noInterrupts() calls were done
+	static std::mutex _hostInterrupts;
+	static thread_local bool _hostMasked = false;
+
+	void noInterrupts() {
+		if (!_hostMasked) {
+			_hostInterrupts.lock();
+			_hostMasked = true;
+		}
+	}
+
+	void interrupts() {
+		if (_hostMasked) {
+			_hostMasked = false;
+			_hostInterrupts.unlock();
+		}
+	}
+
+	bool hostMasked() {
+		return _hostMasked;
+	}
+#endif
+
+#if defined(HOST_STM32)
+	// STM32 Timer3: only recorded
+
+	static timer_gen_reg_map _hostTimer3Regs;
+	static timer_dev _hostTimer3Dev = {{&_hostTimer3Regs}};
+	HardwareTimer Timer3;
+
+	void HardwareTimer::pause() {
+		running = false;
+	}
+
+	void HardwareTimer::resume() {
+		running = true;
+	}
+
+	void HardwareTimer::refresh() { }
+
+	void HardwareTimer::setMode(int channel, timer_mode mode) { }
+
+	uint16 HardwareTimer::setPeriod(uint32 us) {
+		period = us;
+		return (uint16) ((uint64_t) us * (F_CPU / 1000000) / ((uint64_t) us * (F_CPU / 1000000) / 65536 + 1)); // Overflow at smallest prescaler
+	}
+
+	void HardwareTimer::setCompare(int channel, uint16 value) { }
+
+	void HardwareTimer::setCount(uint16 value) { }
+
+	void HardwareTimer::attachInterrupt(int channel, void (*function)()) {
+		handler = function;
+	}
+
+	timer_dev *HardwareTimer::c_dev() {
+		return &_hostTimer3Dev;
+	}
+
+	// Timer run: each count lasts set period, in microseconds
+
+	uint64_t hostTick() {
+		return F_CPU / 1000000;
+	}
+
+	uint64_t hostCount() {
+		uint64_t cycles = (uint64_t) Timer3.period * hostTick();
+		Timer3.handler();
+		return cycles;
+	}
+#endif
+
+#if defined(HOST_ESP8266)
+	uint32_t xt_rsil(uint32_t level) {
+		uint32_t state = _hostMasked ? 15 : 0;
+		noInterrupts();
+		return state;
+	}
+
+	void xt_wsr_ps(uint32_t state) {
+		if (state == 0) {
+			interrupts();
+		}
+	}
+
+	uint64_t micros64() {
+		return (uint64_t) esp_timer_get_time();
+	}
+
+	// Ticker: only recorded; timer run, each count lasts its period in miliseconds
+
+	static Ticker *_hostTicker = NULL;
+
+	void Ticker::attach_ms(uint32_t ms, void (*callback)()) {
+		this->ms = ms;
+		this->callback = callback;
+		_hostTicker = this;
+	}
+
+	void Ticker::detach() {
+		ms = 0;
+	}
+
+	uint64_t hostTick() {
+		return F_CPU / 1000;
+	}
+
+	uint64_t hostCount() {
+		uint64_t cycles = (uint64_t) _hostTicker->ms * hostTick();
+		_hostTicker->callback();
+		return cycles;
+	}
+#endif
+
+#if defined(HOST_SAM)
+	// SAM (Due) TC1 registers
+
+	Tc _hostTc1;
+
+	void pmc_set_writeprotect(uint32_t enable) { }
+
+	uint32_t pmc_enable_periph_clk(uint32_t id) {
+		return 0;
+	}
+
+	void TC_Configure(Tc *tc, uint32_t channel, uint32_t mode) {
+		tc->TC_CHANNEL[channel].TC_CMR = mode;
+	}
+
+	void TC_Start(Tc *tc, uint32_t channel) {
+		tc->TC_CHANNEL[channel].TC_CV = 0;
+	}
+
+	void TC_Stop(Tc *tc, uint32_t channel) { }
+
+	void TC_SetRC(Tc *tc, uint32_t channel, uint32_t rc) {
+		tc->TC_CHANNEL[channel].TC_RC = rc;
+	}
+
+	uint32_t TC_GetStatus(Tc *tc, uint32_t channel) {
+		uint32_t status = tc->TC_CHANNEL[channel].TC_SR;
+		tc->TC_CHANNEL[channel].TC_SR = 0;
+		return status;
+	}
+
+	void NVIC_EnableIRQ(IRQn_Type irq) { }
+
+	void NVIC_DisableIRQ(IRQn_Type irq) { }
+
+	void NVIC_ClearPendingIRQ(IRQn_Type irq) { }
+
+	uint32_t NVIC_GetPendingIRQ(IRQn_Type irq) {
+		return 0;
+	}
+
+	void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { }
+
+	// Timer run: counter is reset on RC compare, so each count lasts RC + 1 ticks of MCK / 32
+
+	uint64_t hostTick() {
+		return 32;
+	}
+
+	uint64_t hostCount() {
+		uint64_t cycles = ((uint64_t) TC1->TC_CHANNEL[0].TC_RC + 1) * hostTick();
+		TC1->TC_CHANNEL[0].TC_SR |= TC_SR_CPCS;
+		TC3_Handler();
+		return cycles;
+	}
+#endif
+
+#if defined(HOST_AVR)
+	// ATmega328P registers
+
+	volatile uint8_t SREG, CLKPR, ASSR, GTCCR, PORTB, DDRB, PINB;
+	volatile uint8_t TIMSK1, TIFR1, TCCR1A, TCCR1B, TCCR1C;
+	volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+	volatile uint8_t TIMSK2, TIFR2, TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B;
+
+	bool hostMasked() {
+		return (SREG & 0x80) == 0;
+	}
+
+	uint8_t digitalPinToTimer(uint8_t pin) {
+		return NOT_ON_TIMER;
+	}
+
+	uint8_t digitalPinToPort(uint8_t pin) {
+		return PD;
+	}
+
+	uint8_t digitalPinToBitMask(uint8_t pin) {
+		return 1 << (pin & 7);
+	}
+
+	// Timer run: CTC mode, TOP is OCR, written by interrupt for next count
+
+	#if defined(UTIMERLIB_AVR_TIMER1)
+		#define HOST_TOP OCR1A
+		#define HOST_CS (TCCR1B & 0x07)
+		#define HOST_VECTOR TIMER1_COMPA_vect
+		static const unsigned int _hostDivisors[] = {0, 1, 8, 64, 256, 1024};
+	#else
+		#define HOST_TOP OCR2A
+		#define HOST_CS (TCCR2B & 0x07)
+		#define HOST_VECTOR TIMER2_COMPA_vect
+		static const unsigned int _hostDivisors[] = {0, 1, 8, 32, 64, 128, 256, 1024};
+	#endif
+	extern "C" void HOST_VECTOR(void);
+
+	uint64_t hostTick() {
+		return _hostDivisors[HOST_CS];
+	}
+
+	uint64_t hostCount() {
+		uint64_t cycles = ((uint64_t) HOST_TOP + 1) * hostTick();
+		HOST_VECTOR();
+		return cycles;
+	}
+#endif
+
+#if defined(HOST_SAMD21) || defined(HOST_SAMD51)
+	// SAMD21 or SAMD51 registers
+
+	#if defined(HOST_SAMD21)
+		TcCount16 _hostTc3;
+		HostEic _hostEic;
+		HostPm _hostPm;
+		volatile uint16_t REG_GCLK_CLKCTRL;
+	#else
+		Tc _hostTc1;
+		HostMclk _hostMclk;
+		HostDwt _hostDwt;
+		HostCoreDebug _hostCoreDebug;
+	#endif
+	HostGclk _hostGclk;
+	HostEvsys _hostEvsys;
+
+	const PinDescription g_APinDescription[32] = {
+		#define HOST_PIN(n) {PORTA, n, (EExt_Interrupts) ((n) & 15)}
+		HOST_PIN(0), HOST_PIN(1), HOST_PIN(2), HOST_PIN(3), HOST_PIN(4), HOST_PIN(5), HOST_PIN(6), HOST_PIN(7),
+		HOST_PIN(8), HOST_PIN(9), HOST_PIN(10), HOST_PIN(11), HOST_PIN(12), HOST_PIN(13), HOST_PIN(14), HOST_PIN(15),
+		HOST_PIN(16), HOST_PIN(17), HOST_PIN(18), HOST_PIN(19), HOST_PIN(20), HOST_PIN(21), HOST_PIN(22), HOST_PIN(23),
+		HOST_PIN(24), HOST_PIN(25), HOST_PIN(26), HOST_PIN(27), HOST_PIN(28), HOST_PIN(29), HOST_PIN(30), HOST_PIN(31)
+		#undef HOST_PIN
+	};
+
+	int pinPeripheral(uint32_t pin, EPioType type) {
+		return 0;
+	}
+
+	void NVIC_EnableIRQ(IRQn_Type irq) { }
+
+	void NVIC_DisableIRQ(IRQn_Type irq) { }
+
+	void NVIC_ClearPendingIRQ(IRQn_Type irq) { }
+
+	void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { }
+
+	// Timer run: MFRQ mode, TOP is CC0; on SAMD51 hardware loads next one from CCBUF0
+
+	static const unsigned char _hostShifts[] = {0, 1, 2, 3, 4, 6, 8, 10};
+	#if defined(HOST_SAMD21)
+		#define HOST_TC TC3
+	#else
+		#define HOST_TC (&TC1->COUNT16)
+	#endif
+
+	uint64_t hostTick() {
+		return 1 << _hostShifts[(HOST_TC->CTRLA.reg & TC_CTRLA_PRESCALER_Msk) >> TC_CTRLA_PRESCALER_Pos];
+	}
+
+	uint64_t hostCount() {
+		uint64_t cycles = ((uint64_t) HOST_TC->CC[0].reg + 1) * hostTick();
+		#if defined(HOST_SAMD21)
+			HOST_TC->INTFLAG.bit.MC0 = 1;
+			HOST_TC->INTFLAG.bit.OVF = 1;
+			hostInterrupt(TC3_Handler);
+		#else
+			HOST_TC->CC[0].reg = HOST_TC->CCBUF[0].reg;
+			HOST_TC->INTFLAG.bit.OVF = 1;
+			hostInterrupt(TC1_Handler);
+		#endif
+		return cycles;
+	}
+
+	// Synchronization waits: on hardware each one stalls for some cycles of timer clock, up to tens of microseconds on slow ones
+
+	static bool _hostIsr = false;
+	static unsigned long _hostSyncWaits = 0;
+
+	void hostSyncRead() {
+		if (_hostIsr) {
+			_hostSyncWaits++;
+		}
+	}
+
+	void hostInterrupt(void (*function)()) {
+		bool was = _hostIsr;
+		_hostIsr = true;
+		function();
+		_hostIsr = was;
+	}
+
+	unsigned long hostSyncWaits() {
+		return _hostSyncWaits;
+	}
+#endif
+
+#if defined(HOST_SAMD21)
+	void hostCapture(uint16_t value) {
+		if ((TC3->READREQ.reg & TC_READREQ_RCONT) && TC_READREQ_ADDR(TC3->READREQ.reg) == TC_COUNT16_CC_OFFSET) {
+			TC3->CC[0].reg = value;
+		}
+		TC3->INTFLAG.bit.MC0 = 1;
+		hostInterrupt(TC3_Handler);
+	}
+#endif
+
+// esp_timer: only recorded; on ESP32 board, timer run from last one created
+
+struct esp_timer {
+	esp_timer_cb_t callback;
+	void *arg;
+	std::atomic<uint64_t> period;	// 0 if stopped
+	std::atomic<bool> once;
+};
+
+static esp_timer_handle_t _hostTimer = NULL;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *timer) {
+	*timer = new esp_timer();
+	(*timer)->callback = args->callback;
+	(*timer)->arg = args->arg;
+	_hostTimer = *timer;
+	return 0;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t us) {
+	timer->once = false;
+	timer->period = us;
+	return 0;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t us) {
+	timer->once = true;
+	timer->period = us;
+	return 0;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+	timer->period = 0;
+	return 0;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+	delete timer;
+	return 0;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+	// Each count lasts esp_timer period, in microseconds; a one shot one is stopped
+
+	uint64_t hostTick() {
+		return F_CPU / 1000000;
+	}
+
+	uint64_t hostCount() {
+		uint64_t cycles = _hostTimer->period * hostTick();
+		if (_hostTimer->once) {
+			_hostTimer->period = 0;
+		}
+		_hostTimer->callback(_hostTimer->arg);
+		return cycles;
+	}
+#endif
+
+int64_t esp_timer_get_time() {
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// FreeRTOS tasks
+
+struct tskTaskControlBlock {
+	TaskFunction_t function;
+	void *arg;
+	std::atomic<UBaseType_t> priority;
+	std::mutex mutex;
+	std::condition_variable changed;
+	uint32_t notified = 0;
+	bool waiting = false;	// Blocked in ulTaskNotifyTake
+};
+
+static tskTaskControlBlock _hostMainTask;
+static std::mutex _hostTasksMutex;
+static std::vector<TaskHandle_t> _hostTasks;
+static thread_local TaskHandle_t _hostCurrent = &_hostMainTask;
+static std::atomic<unsigned long> _hostYields(0);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+	return xTaskCreate(function, name, stack, arg, priority, handle);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *handle) {
+	TaskHandle_t task = new tskTaskControlBlock();
+	task->function = function;
+	task->arg = arg;
+	task->priority = priority;
+	if (handle != NULL) {
+		*handle = task;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_hostTasksMutex);
+		_hostTasks.push_back(task);
+	}
+	std::thread([task]() {
+		_hostCurrent = task;
+		task->function(task->arg);
+	}).detach();
+	return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+	return _hostCurrent;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+	return task->priority;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+	task->priority = priority;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+	std::lock_guard<std::mutex> lock(task->mutex);
+	task->notified++;
+	task->changed.notify_one();
+	return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+	xTaskNotifyGive(task);
+	if (woken != NULL && task->priority > _hostCurrent->priority) {
+		*woken = pdTRUE;
+	}
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+	TaskHandle_t task = _hostCurrent;
+	std::unique_lock<std::mutex> lock(task->mutex);
+	task->waiting = true;
+	if (ticks == portMAX_DELAY) {
+		task->changed.wait(lock, [task]() { return task->notified != 0; });
+	} else {
+		task->changed.wait_for(lock, std::chrono::milliseconds(ticks), [task]() { return task->notified != 0; });
+	}
+	task->waiting = false;
+	uint32_t value = task->notified;
+	if (value != 0) {
+		task->notified = clear ? 0 : value - 1;
+	}
+	return value;
+}
+
+void hostYieldFromIsr(BaseType_t woken) {
+	if (woken) {
+		_hostYields++;
+	}
+}
+
+unsigned long hostYields() {
+	return _hostYields;
+}
+
+bool hostIdle() {
+	std::lock_guard<std::mutex> tasks(_hostTasksMutex);
+	for (TaskHandle_t task : _hostTasks) {
+		std::lock_guard<std::mutex> lock(task->mutex);
+		if (!task->waiting || task->notified != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Checks
+
+static std::atomic<int> _hostFailures(0);
+
+void hostCheck(bool ok, const char *what, const char *file, int line) {
+	if (!ok) {
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+		_hostFailures++;
+	}
+}
+
+int hostResult(const char *test) {
+	if (_hostFailures != 0) {
+		fprintf(stderr, "%s: %d checks failed\n", test, (int) _hostFailures);
+		return 1;
+	}
+	printf("%s: ok\n", test);
+	return 0;
+}
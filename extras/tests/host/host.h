@@ -0,0 +1,91 @@
+/**
+ * Host test helpers for uTimerLib tests. Implemented in host.cpp.
+ *
+ * @file host.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHost_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHost_
+
+	#include <stdint.h>
+
+	/**
+	 * \brief Records a failure if condition is false, going on with the test
+	 */
+	#define CHECK(condition) hostCheck((condition), #condition, __FILE__, __LINE__)
+
+	void hostCheck(bool, const char *, const char *, int);
+
+	/**
+	 * \brief Prints test result
+	 *
+	 * @return	Exit code: 0 if all checks passed
+	 */
+	int hostResult(const char *);
+
+	/**
+	 * \brief Context switches requested with portYIELD_FROM_ISR(pdTRUE) so far
+	 */
+	unsigned long hostYields();
+
+	/**
+	 * \brief All created tasks are blocked in ulTaskNotifyTake with no notification pending
+	 *
+	 * Taking their locks, so what they did before is seen by caller, as after a real context switch.
+	 */
+	bool hostIdle();
+
+	/**
+	 * \brief Ends running timer count and calls its interrupt: TOP + 1 ticks of current prescaler on AVR and SAMD, RC + 1 on SAM,
+	 * Timer3 period on STM32, esp_timer period on ESP32 and Ticker period on ESP8266
+	 *
+	 * @return	CPU cycles of that count
+	 */
+	uint64_t hostCount();
+
+	/**
+	 * \brief Timer tick of current prescaler: MCK / 32 on SAM, 1us on STM32 and ESP32 and 1ms on ESP8266, as they're set in those units
+	 *
+	 * @return	CPU cycles
+	 */
+	uint64_t hostTick();
+
+	#if defined(HOST_AVR) || defined(HOST_STM32) || defined(HOST_SAM) || defined(HOST_ESP8266)
+		/**
+		 * \brief Interrupts are masked for calling thread: SREG I bit clear on AVR, noInterrupts() mutex held by it on others
+		 */
+		bool hostMasked();
+	#endif
+
+	#if defined(HOST_SAMD21) || defined(HOST_SAMD51)
+		/**
+		 * \brief Calls a function as an interrupt would: synchronization busy flags it reads are counted
+		 *
+		 * @param	function	Function to call
+		 */
+		void hostInterrupt(void (*)());
+
+		/**
+		 * \brief Synchronization busy flag reads from interrupts (hostCount() or hostInterrupt()) so far
+		 */
+		unsigned long hostSyncWaits();
+	#endif
+
+	#if defined(HOST_SAMD21)
+		/**
+		 * \brief Captures counter on CC0 and calls timer interrupt. CPU reads CC0 synchronized copy: it's only updated if READREQ keeps
+		 * CC0 continuously synchronized, else a read gets previous value, as on hardware
+		 *
+		 * @param	value	Counter value at input edge
+		 */
+		void hostCapture(uint16_t);
+	#endif
+
+#endif
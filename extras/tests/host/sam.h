@@ -0,0 +1,78 @@
+/**
+ * Host SAM (Due) TC1 channel 0 (TC3) registers and core timer functions for uTimerLib tests: plain variables, so library sets them up
+ * and tests run timer from them (see test_cycles.cpp). Defined in host.cpp. Included by Arduino.h with HOST_SAM.
+ *
+ * Only registers, fields and functions used by the library. Reading status clears it, as on hardware.
+ *
+ * @file sam.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostSam_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostSam_
+
+	#include <stdint.h>
+
+	/**
+	 * \brief TC channel registers
+	 */
+	typedef struct {
+		volatile uint32_t TC_CMR;
+		volatile uint32_t TC_CV;
+		volatile uint32_t TC_RC;
+		volatile uint32_t TC_SR;
+		volatile uint32_t TC_IER;
+		volatile uint32_t TC_IDR;
+	} TcChannel;
+
+	/**
+	 * \brief TC block: three channels
+	 */
+	typedef struct {
+		TcChannel TC_CHANNEL[3];
+	} Tc;
+
+	extern Tc _hostTc1;
+	#define TC1 (&_hostTc1)
+
+	#define ID_TC3 30
+	#define TC_CMR_TCCLKS_TIMER_CLOCK3 (0x2u << 0)
+	#define TC_CMR_WAVSEL_UP_RC (0x2u << 13)
+	#define TC_CMR_WAVE (0x1u << 15)
+	#define TC_SR_CPCS (0x1u << 4)
+	#define TC_IER_CPCS (0x1u << 4)
+
+	void pmc_set_writeprotect(uint32_t);
+	uint32_t pmc_enable_periph_clk(uint32_t);
+	void TC_Configure(Tc *, uint32_t, uint32_t);
+	void TC_Start(Tc *, uint32_t);
+	void TC_Stop(Tc *, uint32_t);
+	void TC_SetRC(Tc *, uint32_t, uint32_t);
+	uint32_t TC_GetStatus(Tc *, uint32_t);
+
+	typedef enum {
+		TC3_IRQn = 30
+	} IRQn_Type;
+
+	#define __NVIC_PRIO_BITS 4
+	void NVIC_EnableIRQ(IRQn_Type);
+	void NVIC_DisableIRQ(IRQn_Type);
+	void NVIC_ClearPendingIRQ(IRQn_Type);
+	uint32_t NVIC_GetPendingIRQ(IRQn_Type);
+	void NVIC_SetPriority(IRQn_Type, uint32_t);
+
+	extern "C" void TC3_Handler(void);
+
+	/**
+	 * \brief Interrupts are masked with a mutex shared by all threads; as on hardware, it doesn't nest
+	 */
+	void noInterrupts();
+	void interrupts();
+
+#endif
@@ -0,0 +1,343 @@
+/**
+ * Host SAMD21 (Zero) or SAMD51 (M4) registers for uTimerLib tests: plain variables, so library sets them up and tests run timer
+ * from them (see test_cycles.cpp). Defined in host.cpp. Included by Arduino.h with HOST_SAMD21 or HOST_SAMD51.
+ *
+ * Only registers and fields used by the library. Synchronization is never busy, but its flags count reads from interrupts (see hostSyncWaits());
+ * interrupt flags are cleared writing ones, as on hardware.
+ *
+ * @file samd.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibHostSamd_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibHostSamd_
+
+	#include <stdint.h>
+
+	/**
+	 * \brief Plain register
+	 */
+	template <typename T> struct HostReg {
+		T reg;
+	};
+
+	/**
+	 * \brief Interrupt flags value: writing ones clears them
+	 */
+	struct HostFlags {
+		uint8_t value;
+		operator uint8_t() const volatile {
+			return value;
+		}
+		void operator=(uint8_t clear) volatile {
+			value &= ~clear;
+		}
+	};
+
+	/**
+	 * \brief TC interrupt flags register
+	 */
+	typedef union {
+		struct {
+			uint8_t OVF:1;
+			uint8_t :3;
+			uint8_t MC0:1;
+			uint8_t MC1:1;
+			uint8_t :2;
+		} bit;
+		HostFlags reg;
+	} HostTcIntflag;
+
+	/**
+	 * \brief Counts a synchronization busy flag read, if it's from an interrupt; defined in host.cpp
+	 */
+	void hostSyncRead();
+
+	/**
+	 * \brief Synchronization busy flag or register: never busy, each read counted by hostSyncRead()
+	 */
+	template <typename T> struct HostSyncbusy {
+		operator T() const volatile {
+			hostSyncRead();
+			return 0;
+		}
+	};
+
+	/**
+	 * \brief Status register with its SYNCBUSY bit
+	 */
+	typedef struct {
+		struct {
+			HostSyncbusy<uint8_t> SYNCBUSY;
+		} bit;
+	} HostStatus;
+
+	/**
+	 * \brief SYNCBUSY register
+	 */
+	typedef struct {
+		HostSyncbusy<uint32_t> reg;
+	} HostSyncReg;
+
+	/**
+	 * \brief Control A register with its ENABLE bit
+	 */
+	template <typename T> union HostCtrla {
+		struct {
+			uint8_t :1;
+			uint8_t ENABLE:1;
+		} bit;
+		T reg;
+	};
+
+	typedef enum {
+		NOT_AN_INTERRUPT = -1,
+		EXTERNAL_INT_0 = 0
+	} EExt_Interrupts;
+
+	typedef enum {
+		NOT_A_PORT = -1,
+		PORTA = 0,
+		PORTB = 1
+	} EPortType;
+
+	typedef enum {
+		PIO_EXTINT = 2,
+		PIO_TIMER = 4
+	} EPioType;
+
+	/**
+	 * \brief Arduino pin: all pins are PORTA pin with same number, and external interrupt pin & 15
+	 */
+	typedef struct {
+		EPortType ulPort;
+		uint32_t ulPin;
+		EExt_Interrupts ulExtInt;
+	} PinDescription;
+
+	extern const PinDescription g_APinDescription[];
+	int pinPeripheral(uint32_t, EPioType);
+
+	typedef enum {
+		TC1_IRQn = 1,
+		TC3_IRQn = 3
+	} IRQn_Type;
+
+	#define __NVIC_PRIO_BITS 2
+	void NVIC_EnableIRQ(IRQn_Type);
+	void NVIC_DisableIRQ(IRQn_Type);
+	void NVIC_ClearPendingIRQ(IRQn_Type);
+	void NVIC_SetPriority(IRQn_Type, uint32_t);
+
+	/**
+	 * \brief Single thread: nothing to mask
+	 */
+	#define noInterrupts()
+	#define interrupts()
+
+	#define TC_CTRLA_ENABLE (1 << 1)
+	#define TC_CTRLA_MODE_Msk (3 << 2)
+	#define TC_CTRLA_MODE_COUNT16 (0 << 2)
+	#define TC_CTRLA_PRESCALER_Pos 8
+	#define TC_CTRLA_PRESCALER_Msk (7 << TC_CTRLA_PRESCALER_Pos)
+	#define TC_CTRLA_PRESCALER(value) ((value) << TC_CTRLA_PRESCALER_Pos)
+	#define TC_CTRLA_PRESCALER_DIV16 TC_CTRLA_PRESCALER(4)
+	#define TC_INTFLAG_OVF (1 << 0)
+	#define TC_INTFLAG_MC0 (1 << 4)
+	#define TC_INTENCLR_OVF TC_INTFLAG_OVF
+	#define TC_INTENCLR_MC0 TC_INTFLAG_MC0
+	#define TC_INTENCLR_MC1 (1 << 5)
+	#define TC_INTENSET_OVF TC_INTFLAG_OVF
+	#define TC_INTENSET_MC0 TC_INTFLAG_MC0
+
+	#if defined(_SAMD21_)
+		struct TcCount16 {
+			HostCtrla<uint16_t> CTRLA;
+			HostReg<uint16_t> READREQ;
+			HostReg<uint8_t> CTRLC;
+			HostReg<uint16_t> EVCTRL;
+			HostReg<uint8_t> INTENCLR;
+			HostReg<uint8_t> INTENSET;
+			HostTcIntflag INTFLAG;
+			HostStatus STATUS;
+			HostReg<uint16_t> COUNT;
+			HostReg<uint16_t> CC[2];
+		};
+
+		struct HostGclk {
+			HostStatus STATUS;
+		};
+
+		struct HostEic {
+			HostCtrla<uint8_t> CTRL;
+			HostStatus STATUS;
+			HostReg<uint32_t> EVCTRL;
+			HostReg<uint32_t> INTENCLR;
+			HostReg<uint32_t> CONFIG[2];
+		};
+
+		struct HostPm {
+			HostReg<uint32_t> APBCMASK;
+		};
+
+		struct HostEvsys {
+			HostReg<uint16_t> USER;
+			HostReg<uint32_t> CHANNEL;
+		};
+
+		extern TcCount16 _hostTc3;
+		extern HostGclk _hostGclk;
+		extern HostEic _hostEic;
+		extern HostPm _hostPm;
+		extern HostEvsys _hostEvsys;
+		extern volatile uint16_t REG_GCLK_CLKCTRL;
+		#define TC3 (&_hostTc3)
+		#define GCLK (&_hostGclk)
+		#define EIC (&_hostEic)
+		#define PM (&_hostPm)
+		#define EVSYS (&_hostEvsys)
+
+		#define TC_CTRLA_WAVEGEN_Msk (3 << 5)
+		#define TC_CTRLA_WAVEGEN_NFRQ (0 << 5)
+		#define TC_CTRLA_WAVEGEN_MFRQ (1 << 5)
+		#define TC_CTRLA_WAVEGEN_MPWM (3 << 5)
+		#define TC_READREQ_RREQ (1 << 15)
+		#define TC_READREQ_RCONT (1 << 14)
+		#define TC_READREQ_ADDR(value) ((value) & 0x1F)
+		#define TC_COUNT16_COUNT_OFFSET 0x10
+		#define TC_COUNT16_CC_OFFSET 0x18
+		#define TC_CTRLC_CPTEN0 (1 << 4)
+		#define TC_EVCTRL_EVACT_Msk (7 << 0)
+		#define TC_EVCTRL_EVACT_OFF (0 << 0)
+		#define TC_EVCTRL_TCEI (1 << 5)
+		#define TC_EVCTRL_MCEO0 (1 << 12)
+
+		#define GCLK_CLKCTRL_ID(value) ((value) & 0x3F)
+		#define GCLK_CLKCTRL_GEN_GCLK0 (0 << 8)
+		#define GCLK_CLKCTRL_CLKEN (1 << 14)
+		#define GCM_EIC 0x05
+		#define GCM_TCC2_TC3 0x1B
+
+		#define EIC_CONFIG_SENSE0_Msk 7
+		#define EIC_CONFIG_SENSE0_RISE_Val 1
+		#define EIC_CONFIG_SENSE0_FALL_Val 2
+
+		#define PM_APBCMASK_EVSYS (1 << 1)
+
+		#define EVSYS_CHANNELS 12
+		#define EVSYS_USERS 31
+		#define EVSYS_USER_USER(value) ((value) & 0x1F)
+		#define EVSYS_USER_CHANNEL(value) (((value) & 0x1F) << 8)
+		#define EVSYS_CHANNEL_CHANNEL(value) ((value) & 0x0F)
+		#define EVSYS_CHANNEL_EVGEN(value) (((value) & 0x7F) << 16)
+		#define EVSYS_CHANNEL_PATH_ASYNCHRONOUS (2 << 24)
+		#define EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT (0 << 26)
+		#define EVSYS_ID_USER_TC3_EVU 0x12
+		#define EVSYS_ID_GEN_EIC_EXTINT_0 0x0C
+		#define EVSYS_ID_GEN_TC3_MCX_0 0x34
+
+		extern "C" void TC3_Handler(void);
+	#else
+		struct TcCount16 {
+			HostCtrla<uint32_t> CTRLA;
+			HostReg<uint16_t> EVCTRL;
+			HostReg<uint8_t> INTENCLR;
+			HostReg<uint8_t> INTENSET;
+			HostTcIntflag INTFLAG;
+			HostReg<uint8_t> WAVE;
+			HostSyncReg SYNCBUSY;
+			HostReg<uint16_t> COUNT;
+			HostReg<uint16_t> CC[2];
+			HostReg<uint16_t> CCBUF[2];
+		};
+
+		struct Tc {
+			TcCount16 COUNT16;
+		};
+
+		struct HostGclk {
+			union {
+				struct {
+					uint32_t GEN:4;
+					uint32_t :2;
+					uint32_t CHEN:1;
+				} bit;
+				uint32_t reg;
+			} PCHCTRL[48];
+			HostSyncReg SYNCBUSY;
+		};
+
+		struct HostMclk {
+			union {
+				struct {
+					uint32_t :14;
+					uint32_t TC1_:1;
+				} bit;
+				uint32_t reg;
+			} APBAMASK;
+			HostReg<uint32_t> APBBMASK;
+		};
+
+		struct HostEvsys {
+			HostReg<uint8_t> USER[67];
+			struct {
+				HostReg<uint32_t> CHANNEL;
+			} Channel[32];
+		};
+
+		/**
+		 * \brief Cortex-M4 DWT cycle counter, for now_ticks(); it doesn't count
+		 */
+		struct HostDwt {
+			volatile uint32_t CTRL;
+			volatile uint32_t CYCCNT;
+		};
+
+		struct HostCoreDebug {
+			volatile uint32_t DEMCR;
+		};
+
+		extern Tc _hostTc1;
+		extern HostGclk _hostGclk;
+		extern HostMclk _hostMclk;
+		extern HostEvsys _hostEvsys;
+		extern HostDwt _hostDwt;
+		extern HostCoreDebug _hostCoreDebug;
+		#define TC1 (&_hostTc1)
+		#define GCLK (&_hostGclk)
+		#define MCLK (&_hostMclk)
+		#define EVSYS (&_hostEvsys)
+		#define DWT (&_hostDwt)
+		#define CoreDebug (&_hostCoreDebug)
+
+		#define DWT_CTRL_CYCCNTENA_Msk (1 << 0)
+		#define CoreDebug_DEMCR_TRCENA_Msk (1 << 24)
+
+		#define TC_WAVE_WAVEGEN_MFRQ 1
+		#define TC_EVCTRL_OVFEO (1 << 8)
+		#define TC_INTFLAG_MASK 0x33
+		#define TC_INTENCLR_MASK 0x33
+
+		#define TC1_GCLK_ID 9
+		#define GCLK_PCHCTRL_GEN_GCLK1_Val 1
+		#define GCLK_PCHCTRL_CHEN (1 << 6)
+		#define MCLK_APBBMASK_EVSYS (1 << 7)
+
+		#define EVSYS_CHANNELS 32
+		#define EVSYS_USERS 67
+		#define EVSYS_USER_CHANNEL(value) ((value) & 0x3F)
+		#define EVSYS_CHANNEL_EVGEN(value) ((value) & 0x7F)
+		#define EVSYS_CHANNEL_PATH_ASYNCHRONOUS (2 << 8)
+		#define EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT (0 << 10)
+		#define EVSYS_ID_GEN_TC1_OVF 0x4F
+
+		extern "C" void TC1_Handler(void);
+	#endif
+
+#endif
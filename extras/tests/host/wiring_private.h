@@ -0,0 +1,11 @@
+/**
+ * Host Arduino SAMD core private wiring header for uTimerLib tests: pinPeripheral() is declared in samd.h
+ *
+ * @file wiring_private.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "Arduino.h"
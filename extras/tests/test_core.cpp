@@ -0,0 +1,216 @@
+/**
+ * uTimerLib host test: ESP32 dispatch pinned to a core (setCore), with trace recording (UTIMERLIB_TRACE)
+ *
+ * Timer interrupt is called from main thread, as esp_timer task; _dispatch() hands each tick off to the dispatch task,
+ * which calls callback. Each tick must be recorded as one fire, not once on hand-off and again on dispatch task.
+ * Ticks ended while dispatch task is late are all dispatched: one callback each, or through overrun policy.
+ * Trace is also dumped while records are written, so ThreadSanitizer checks the lock free trace ring.
+ *
+ * @file test_core.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLib.h"
+#include "host.h"
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+static std::atomic<unsigned long> calls(0);
+static std::atomic<bool> hold(false);	// Callback waits while set, making dispatch task late
+static std::atomic<unsigned long> coalesced(0);
+
+void callback() {
+	calls++;
+	while (hold) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void overrun(unsigned long int missed) {
+	coalesced += missed;
+}
+
+/**
+ * \brief Waits for callback to be called some times, up to 1s
+ *
+ * @param	expected	Calls expected
+ */
+static void started(unsigned long expected) {
+	for (int i = 0; i < 1000 && calls < expected; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+/**
+ * \brief Calls timer interrupt, as esp_timer task would
+ *
+ * @param	times	Interrupts
+ */
+static void fire(unsigned long times) {
+	for (unsigned long i = 0; i < times; i++) {
+		uTimerLib::interrupt(&TimerLib);
+	}
+}
+
+/**
+ * \brief Waits for dispatch task to call callback some times and block again, up to 1s
+ *
+ * @param	expected	Calls expected
+ * @return	false on timeout
+ */
+static bool wait(unsigned long expected) {
+	for (int i = 0; i < 1000 && (calls < expected || !hostIdle()); i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return calls == expected;
+}
+
+/**
+ * \brief Trace dump, kept as text
+ */
+class Dump : public Print {
+	public:
+		std::string text;
+		size_t write(uint8_t c) {
+			text += (char) c;
+			return 1;
+		}
+};
+
+/**
+ * \brief Checks trace records while ticks are dispatched: only fires, callbacks with no argument and overruns
+ *
+ * @return	false if a record is not well formed
+ */
+static bool wellFormed() {
+	Dump dump;
+	TimerLib.traceDump(dump);
+	size_t start = dump.text.find("\r\n") + 2, end;
+	while ((end = dump.text.find("\r\n", start)) != std::string::npos) {
+		std::string line = dump.text.substr(start, end - start);
+		start = end + 2;
+		if (line == "uTimerLib trace end") {
+			return true;
+		}
+		unsigned long event = strtoul(line.substr(8, 2).c_str(), NULL, 16), arg = strtoul(line.substr(10, 2).c_str(), NULL, 16);
+		if (line.size() != 12 || event < UTIMERLIB_TRACE_FIRE || event > UTIMERLIB_TRACE_OVERRUN
+			|| ((event == UTIMERLIB_TRACE_CB_START || event == UTIMERLIB_TRACE_CB_END) && arg != 0)) {
+			return false;
+		}
+	}
+	return false;
+}
+
+/**
+ * \brief Counts trace records of an event
+ *
+ * @param	event	UTIMERLIB_TRACE_* event
+ * @return	Records
+ */
+static unsigned long traced(unsigned char event) {
+	Dump dump;
+	TimerLib.traceDump(dump);
+	unsigned long count = 0;
+	size_t start = 0, end;
+	while ((end = dump.text.find("\r\n", start)) != std::string::npos) {
+		std::string line = dump.text.substr(start, end - start);
+		if (line.size() == 12 && strtoul(line.substr(8, 2).c_str(), NULL, 16) == event) {
+			count++;
+		}
+		start = end + 2;
+	}
+	return count;
+}
+
+int main() {
+	// Each tick handed off to core 1 task: one fire and one callback each
+	TimerLib.setInterval_us(callback, 1000);
+	CHECK(TimerLib.setCore(1));
+	TimerLib.traceClear();
+	for (unsigned long i = 1; i <= 10; i++) {
+		fire(1);
+		CHECK(wait(i));
+	}
+	CHECK(traced(UTIMERLIB_TRACE_FIRE) == 10);
+	CHECK(traced(UTIMERLIB_TRACE_CB_START) == 10);
+
+	// Dispatch task late: ticks ended meanwhile are called each
+	calls = 0;
+	hold = true;
+	fire(1);
+	started(1);
+	fire(4);
+	hold = false;
+	CHECK(wait(5));
+
+	// Same with coalesce policy (10s period, so no time overrun): next tick dispatched, one overrun call for late ones
+	TimerLib.setInterval_s(callback, 10);
+	TimerLib.setOverrunPolicy(UTIMERLIB_OVERRUN_COALESCE, overrun);
+	calls = 0;
+	hold = true;
+	fire(1);
+	started(1);
+	fire(4);
+	hold = false;
+	CHECK(wait(2));
+	CHECK(coalesced == 3);
+	CHECK(TimerLib.getOverruns() == 3);
+
+	// Ticks of a cleared timer are not dispatched on the next one
+	TimerLib.setOverrunPolicy(UTIMERLIB_OVERRUN_NONE);
+	calls = 0;
+	hold = true;
+	fire(1);
+	started(1);
+	fire(3);
+	TimerLib.setInterval_s(callback, 10);
+	fire(1);
+	hold = false;
+	CHECK(wait(2));
+
+	// Back to esp_timer task: same records, callback called right away
+	TimerLib.setInterval_us(callback, 1000);
+	CHECK(TimerLib.setCore(tskNO_AFFINITY));
+	TimerLib.traceClear();
+	calls = 0;
+	fire(5);
+	CHECK(calls == 5);
+	CHECK(traced(UTIMERLIB_TRACE_FIRE) == 5);
+
+	// Cleared timer: nothing fires
+	TimerLib.clearTimer();
+	TimerLib.traceClear();
+	fire(1);
+	CHECK(traced(UTIMERLIB_TRACE_FIRE) == 0);
+
+	// Dumped while records are written from esp_timer and dispatch tasks: ThreadSanitizer checks seq publishing, and fire time
+	// written by esp_timer task while dispatch task reads it for overruns
+	TimerLib.setInterval_us(callback, 1000);
+	TimerLib.setOverrunPolicy(UTIMERLIB_OVERRUN_COALESCE, overrun);
+	CHECK(TimerLib.setCore(1));
+	TimerLib.traceClear();
+	calls = 0;
+	std::atomic<bool> done(false);
+	std::thread ticks([&done]() {
+		fire(2000);
+		done = true;
+	});
+	do {
+		CHECK(wellFormed());
+	} while (!done);
+	ticks.join();
+	for (int i = 0; i < 1000 && !hostIdle(); i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK(TimerLib.setCore(tskNO_AFFINITY));
+	TimerLib.setOverrunPolicy(UTIMERLIB_OVERRUN_NONE);
+	TimerLib.clearTimer();
+
+	return hostResult("test_core");
+}
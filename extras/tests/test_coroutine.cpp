@@ -0,0 +1,130 @@
+/**
+ * uTimerLib host test: uTimerLibTask coroutines sleeping on TimerLib
+ *
+ * Needs C++20 coroutines (built with -std=gnu++20 if compiler takes it); otherwise it's skipped. Library is built for host ESP32,
+ * with esp_timer timeouts run from test (hostCount()) and time from host clock. All pool frames are taken by tasks sleeping
+ * at once, each one for its own time: every sleep must be done, not shorter than asked, with no free frame left for another task.
+ * Meanwhile a coroutine that is not an uTimerLibTask (frame from heap) must get false from co_await, not sleeping, and must not
+ * take a task sleep. Once tasks end, their frames must be free again.
+ *
+ * @file test_coroutine.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibCoroutine.h"
+#include "host.h"
+#include <stdio.h>
+
+#if defined(UTIMERLIB_COROUTINES)
+	#include <chrono>
+	#include <thread>
+
+	#define SLEEPS 3
+
+	static unsigned long woken[UTIMERLIB_COROUTINE_FRAMES];
+	static uint8_t ended = 0;
+	static bool early = false;
+
+	/**
+	 * \brief Task sleeping SLEEPS times, for 1ms plus n quarters of ms
+	 */
+	static uTimerLibTask sleeper(uint8_t n) {
+		unsigned long int us = 1000 + n * 250;
+		for (uint8_t i = 0; i < SLEEPS; i++) {
+			uint64_t from = uTimerLib::now_us();
+			bool slept = co_await TimerLib.sleep_us(us);
+			if (!slept || uTimerLib::now_us() - from < us) {
+				early = true;
+			}
+			woken[n]++;
+		}
+		ended++;
+	}
+
+	static bool zeroSlept = false;
+
+	/**
+	 * \brief Task doing a 0 sleep: not suspended, but it's a sleep done
+	 */
+	static uTimerLibTask zero() {
+		zeroSlept = co_await TimerLib.sleep_us(0);
+	}
+
+	/**
+	 * \brief Coroutine type other than uTimerLibTask: frame from heap
+	 */
+	struct Plain {
+		struct promise_type {
+			Plain get_return_object() noexcept {
+				return Plain();
+			}
+			std::suspend_never initial_suspend() noexcept {
+				return {};
+			}
+			std::suspend_never final_suspend() noexcept {
+				return {};
+			}
+			void return_void() noexcept {}
+			void unhandled_exception() noexcept {}
+		};
+	};
+
+	static bool plainSlept = true;
+	static bool plainEnded = false;
+
+	static Plain plain() {
+		plainSlept = co_await TimerLib.sleep_us(1000);
+		plainEnded = true;
+	}
+
+	/**
+	 * \brief Runs timeouts and resumes tasks, as loop() would, until n tasks have ended or 1s has passed
+	 */
+	static void loop(uint8_t n) {
+		uint64_t until = uTimerLib::now_us() + 1000000;
+		while (ended < n && uTimerLib::now_us() < until) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			hostCount();
+			uTimerLibTask::run();
+		}
+	}
+
+	int main() {
+		for (uint8_t n = 0; n < UTIMERLIB_COROUTINE_FRAMES; n++) {
+			CHECK((bool) sleeper(n));
+		}
+		CHECK(!(bool) sleeper(0));
+
+		// All slots have sleeping tasks: not a task, so it's not suspended and told so
+		plain();
+		CHECK(plainEnded);
+		CHECK(!plainSlept);
+
+		loop(UTIMERLIB_COROUTINE_FRAMES);
+		CHECK(ended == UTIMERLIB_COROUTINE_FRAMES);
+		for (uint8_t n = 0; n < UTIMERLIB_COROUTINE_FRAMES; n++) {
+			CHECK(woken[n] == SLEEPS);
+		}
+		CHECK(!early);
+
+		// Frames free again
+		CHECK((bool) zero());
+		CHECK(zeroSlept);
+		ended = 0;
+		woken[0] = 0;
+		CHECK((bool) sleeper(0));
+		loop(1);
+		CHECK(ended == 1 && woken[0] == SLEEPS);
+
+		TimerLib.clearTimer();
+		return hostResult("test_coroutine");
+	}
+#else
+	int main() {
+		printf("test_coroutine: skipped, no C++20 coroutines\n");
+		return 0;
+	}
+#endif
@@ -0,0 +1,139 @@
+/**
+ * uTimerLib host test: timer set up math of each device (_prescale, _ticks, _fraction and its compares split), from 1us to weeks
+ *
+ * Library is built for a host board with plain variables as timer registers (HOST_AVR, with or without UTIMERLIB_AVR_TIMER1,
+ * HOST_SAMD21, HOST_SAMD51 or HOST_SAM), or recording Timer3, esp_timer or Ticker periods (HOST_STM32, ESP32 host board, HOST_ESP8266).
+ * Timer is run from them: each compare lasts TOP + 1 ticks of current prescaler (RC + 1 on SAM, set period on others), then its interrupt
+ * is called (hostCount()). Time to each callback, summed over some periods, must be requested cycles, rounded down to less than one tick;
+ * so each compares split (overflows of whole TOP counts plus remaining one) and fraction tick add up.
+ * SAM, STM32, ESP32 and ESP8266 round timings to their tick (MCK / 32, microseconds, miliseconds) with no fraction,
+ * and STM32 splits long ones in equal periods, so there each timer count may be off by less than one tick, either way.
+ *
+ * @file test_cycles.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLib.h"
+#include "host.h"
+#include <stdio.h>
+
+#if defined(HOST_AVR)
+	#if defined(UTIMERLIB_AVR_TIMER1)
+		#define TEST_NAME "test_cycles_avr_timer1"
+	#else
+		#define TEST_NAME "test_cycles_avr"
+	#endif
+#elif defined(HOST_SAMD21)
+	#define TEST_NAME "test_cycles_samd21"
+#elif defined(HOST_SAMD51)
+	#define TEST_NAME "test_cycles_samd51"
+#else
+	#if defined(HOST_SAM)
+		#define TEST_NAME "test_cycles_sam"
+	#elif defined(HOST_STM32)
+		#define TEST_NAME "test_cycles_stm32"
+	#elif defined(HOST_ESP8266)
+		#define TEST_NAME "test_cycles_esp8266"
+	#else
+		#define TEST_NAME "test_cycles_esp32"
+	#endif
+	/**
+	 * \brief Timings are rounded to timer tick on each count, not kept exact with a fraction
+	 */
+	#define TEST_ROUNDED
+#endif
+
+#define US(cycles) ((cycles) / (F_CPU / 1000000))
+
+static unsigned long calls = 0;
+
+void callback() {
+	calls++;
+}
+
+/**
+ * \brief Runs timer up to some callbacks, checking time to each one
+ *
+ * @param	what		Timing, for failures
+ * @param	num			Period numerator, in CPU cycles
+ * @param	den			Period denominator
+ * @param	periods		Callbacks to run
+ */
+static void run(const char *what, uint64_t num, uint64_t den, unsigned long periods) {
+	calls = 0;
+	uint64_t elapsed = 0, counts = 0;
+	while (calls < periods) {
+		unsigned long done = calls;
+		elapsed += hostCount();
+		counts++;
+		if (calls == done) {
+			continue;
+		}
+		// Requested time of these periods, as num / den can be over 64 bits when multiplied
+		uint64_t whole = num / den * calls, part = num % den * calls;
+		uint64_t expected = whole + part / den;
+		#if defined(TEST_ROUNDED)
+			bool ok = ((elapsed > expected) ? elapsed - expected : expected - elapsed) < counts * hostTick();
+		#else
+			bool ok = elapsed <= expected && expected - elapsed < hostTick();
+		#endif
+		if (!ok) {
+			fprintf(stderr, "%s: period %lu ends at %llu cycles, expected %llu (tick %llu)\n", what, calls,
+					(unsigned long long) elapsed, (unsigned long long) expected, (unsigned long long) hostTick());
+		}
+		CHECK(ok);
+	}
+}
+
+/**
+ * \brief Interval in microseconds, 64 bit
+ *
+ * @param	us		Period
+ */
+static void interval_us(unsigned long long us) {
+	char what[48];
+	snprintf(what, sizeof(what), "setInterval_us64(%llu)", us);
+	TimerLib.setInterval_us64(callback, us);
+	// Longer than a day: one period, as it already counts millions of compares
+	run(what, us * (F_CPU / 1000000), 1, (us > 86400000000ULL) ? 1 : 3);
+}
+
+int main() {
+	// 1us to 2^40us (12.7 days), powers of 2 and their neighbours, in 64 bit cycles
+	for (unsigned char bit = 0; bit <= 40; bit++) {
+		unsigned long long us = 1ULL << bit;
+		if (us > 0xFFFFFFFFFFFFFFFFULL / F_CPU) {
+			break;
+		}
+		interval_us(us);
+		if (bit > 1) {
+			interval_us(us - 1);
+			interval_us(us + 1);
+		}
+	}
+
+	// Past 64 bit cycles, counted from whole miliseconds: 3 weeks
+	interval_us(1814400000000ULL);
+	TimerLib.setInterval_s(callback, 1814400);
+	run("setInterval_s(1814400)", 1814400ULL * F_CPU, 1, 1);
+	TimerLib.setInterval_s(callback, 1);
+	run("setInterval_s(1)", F_CPU, 1, 5);
+
+	// Rates not a whole number of ticks: fraction adds up over many periods
+	TimerLib.setInterval_hz(callback, 44100);
+	run("setInterval_hz(44100)", F_CPU, 44100, 2000);
+	TimerLib.setInterval_hz(callback, 1000, 3);
+	run("setInterval_hz(1000, 3)", (uint64_t) F_CPU * 3, 1000, 100);
+	TimerLib.setInterval_hz(callback, 7, 1);
+	run("setInterval_hz(7)", F_CPU, 7, 20);
+
+	// A timeout: one callback, then timer is cleared
+	TimerLib.setTimeout_us(callback, 100000);
+	run("setTimeout_us(100000)", 100000ULL * (F_CPU / 1000000), 1, 1);
+
+	TimerLib.clearTimer();
+	return hostResult(TEST_NAME);
+}
@@ -0,0 +1,277 @@
+/**
+ * uTimerLib host test: uTimerLibExecutive frame tables switched while running
+ *
+ * Library is built for a host STM32 board, with base ticks run from test (hostCount()). Each call is recorded with its base tick:
+ * tasks must be called fastest first, and tasks already running must keep their phase (called on base ticks multiple of their
+ * period since begin()) when tasks are added and removed, going to longer and shorter hyperperiods, and to ones not multiple
+ * of previous one. A change done from a task must not change current base tick calls, only next ones, and a task that
+ * doesn't fit in frame table must leave running one untouched. Last, a task is added and removed from another thread while base
+ * ticks run, under ThreadSanitizer: tables must be built aside, with no base tick reading one being built.
+ * Batched changes must not be taken until (outer) commit, and then all on the same base tick, with tasks of equal multiple
+ * called in order they were added, also when batches are committed from another thread while base ticks run.
+ *
+ * @file test_executive.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibExecutive.h"
+#include "host.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+#define TICKS 4400
+
+// Two tables of up to 60 base ticks
+static uint8_t frames[120];
+static uTimerLibExecutive executive(frames, sizeof(frames));
+
+// Tasks called on each base tick, in call order
+static char calls[TICKS][UTIMERLIB_EXECUTIVE_MAX_TASKS + 1];
+static unsigned long ticks = 0;
+
+// Base tick where task a removes task b and adds task d
+static unsigned long changeAt = TICKS;
+
+/**
+ * \brief Records a task call on current base tick
+ */
+static void record(char task) {
+	size_t n = strlen(calls[ticks]);
+	if (n < UTIMERLIB_EXECUTIVE_MAX_TASKS) {
+		calls[ticks][n] = task;
+	}
+}
+
+static void taskB() {
+	record('b');
+}
+
+static void taskD() {
+	record('d');
+}
+
+static void taskA() {
+	record('a');
+	if (ticks == changeAt) {
+		CHECK(executive.removeTask(taskB));
+		CHECK(executive.addTask(taskD, 1));
+	}
+}
+
+static void taskC() {
+	record('c');
+}
+
+static void taskE() {
+	record('e');
+}
+
+static void taskF() {
+	record('f');
+}
+
+static void taskG() {
+	record('g');
+}
+
+/**
+ * \brief Runs some base ticks
+ */
+static void run(unsigned long count) {
+	for (; count > 0 && ticks < TICKS - 1; count--) {
+		hostCount();
+		ticks++;
+	}
+}
+
+/**
+ * \brief Checks calls on a range of base ticks
+ *
+ * @param	from		First base tick
+ * @param	to			Base tick after last one
+ * @param	expected	Function returning tasks expected on a base tick, fastest first
+ */
+static void expect(unsigned long from, unsigned long to, const char *(*expected)(unsigned long)) {
+	for (unsigned long t = from; t < to; t++) {
+		const char *e = expected(t);
+		if (strcmp(calls[t], e) != 0) {
+			fprintf(stderr, "base tick %lu: called \"%s\", expected \"%s\"\n", t, calls[t], e);
+			CHECK(strcmp(calls[t], e) == 0);
+		}
+	}
+}
+
+// Expected calls on each stage, by base tick since begin()
+
+static const char *none(unsigned long t) {
+	return "";
+}
+
+static const char *aef(unsigned long t) {
+	return t % 2 == 0 ? "aef" : "";
+}
+
+static const char *af(unsigned long t) {
+	return t % 2 == 0 ? "af" : "";
+}
+
+// Tasks e and g added and removed in batches meanwhile
+static const char *afeg(unsigned long t) {
+	return (t % 2 == 0 && strcmp(calls[t], "af") != 0) ? "afeg" : af(t);
+}
+
+static const char *ab(unsigned long t) {
+	static char s[4];
+	snprintf(s, sizeof(s), "%s%s", t % 2 == 0 ? "a" : "", t % 3 == 0 ? "b" : "");
+	return s;
+}
+
+static const char *abc4(unsigned long t) {
+	static char s[4];
+	snprintf(s, sizeof(s), "%s%s%s", t % 2 == 0 ? "a" : "", t % 3 == 0 ? "b" : "", t % 4 == 0 ? "c" : "");
+	return s;
+}
+
+// Task c added at base tick 24, frame 0 of new table
+static const char *abc5(unsigned long t) {
+	static char s[4];
+	snprintf(s, sizeof(s), "%s%s%s", t % 2 == 0 ? "a" : "", t % 3 == 0 ? "b" : "", (t - 24) % 5 == 0 ? "c" : "");
+	return s;
+}
+
+static const char *ad(unsigned long t) {
+	static char s[4];
+	snprintf(s, sizeof(s), "d%s", t % 2 == 0 ? "a" : "");
+	return s;
+}
+
+/**
+ * \brief Checks calls on a range of base ticks where task c may have been in or not: it must be last one if called
+ */
+static void expectWithC(unsigned long from, unsigned long to, const char *(*expected)(unsigned long)) {
+	for (unsigned long t = from; t < to; t++) {
+		const char *e = expected(t);
+		char called[UTIMERLIB_EXECUTIVE_MAX_TASKS + 1];
+		strcpy(called, calls[t]);
+		size_t n = strlen(called);
+		if (n > 0 && called[n - 1] == 'c') {
+			called[n - 1] = 0;
+		}
+		bool ok = strcmp(called, e) == 0;
+		if (!ok) {
+			fprintf(stderr, "base tick %lu: called \"%s\", expected \"%s\" and maybe c\n", t, calls[t], e);
+			CHECK(ok);
+		}
+	}
+}
+
+int main() {
+	CHECK(executive.addTask(taskB, 3));
+	CHECK(executive.addTask(taskA, 2));
+	CHECK(executive.begin(1000));
+
+	// Hyperperiod 6, fastest first
+	run(4);
+	expect(0, 4, ab);
+
+	// 6 to 12: frame 4 kept, task c aligned to it
+	CHECK(executive.addTask(taskC, 4));
+	run(6);
+	expect(4, 10, abc4);
+
+	// 12 to 6: frame 10 goes to 4, a and b keep phase
+	CHECK(executive.removeTask(taskC));
+	run(14);
+	expect(10, 24, ab);
+
+	// 6 to 30, not a multiple of 5: a and b keep phase, c starts at frame 0
+	CHECK(executive.addTask(taskC, 5));
+	run(40);
+	expect(24, 64, abc5);
+
+	// Doesn't fit (210 base ticks): rejected, running table untouched
+	CHECK(!executive.addTask(taskE, 7));
+	run(20);
+	expect(64, 84, abc5);
+
+	// 30 to 6, from frame 0
+	CHECK(executive.removeTask(taskC));
+	run(12);
+	expect(84, 96, ab);
+
+	// Changed from a task, on a base tick where both a and b are due: b still called on it, d only from next one
+	changeAt = 96;
+	run(10);
+	CHECK(strcmp(calls[96], "ab") == 0);
+	expect(97, 106, ad);
+
+	// Task c added and removed from other thread while base ticks run: tables are built aside, so each base tick reads a whole one
+	std::atomic<bool> done(false);
+	std::thread other([&done]() {
+		while (!done) {
+			CHECK(executive.addTask(taskC, 4));
+			std::this_thread::yield();
+			CHECK(executive.removeTask(taskC));
+		}
+	});
+	run(2000);
+	done = true;
+	other.join();
+	expectWithC(106, 2106, ad);
+
+	// Batch: not taken by a base tick run inside it, then all at once, equal multiples in order they were added
+	CHECK(executive.batch([]() {
+		CHECK(executive.addTask(taskE, 2));
+		CHECK(executive.removeTask(taskD));
+		CHECK(executive.addTask(taskF, 2));
+		run(1);
+	}));
+	expect(2106, 2107, ad);
+	run(9);
+	expect(2107, 2116, aef);
+
+	// Nested batch: taken on outer commit
+	executive.beginBatch();
+	executive.beginBatch();
+	CHECK(executive.removeTask(taskE));
+	CHECK(executive.commitBatch());
+	run(2);
+	expect(2116, 2118, aef);
+	CHECK(executive.commitBatch());
+	run(2);
+	expect(2118, 2120, af);
+
+	// Batches from other thread while base ticks run: each one taken on a single base tick, never half of it
+	done = false;
+	std::thread batches([&done]() {
+		while (!done) {
+			CHECK(executive.batch([]() {
+				CHECK(executive.addTask(taskE, 2));
+				CHECK(executive.addTask(taskG, 2));
+			}));
+			std::this_thread::yield();
+			CHECK(executive.batch([]() {
+				CHECK(executive.removeTask(taskE));
+				CHECK(executive.removeTask(taskG));
+			}));
+		}
+	});
+	run(2000);
+	done = true;
+	batches.join();
+	expect(2120, 4120, afeg);
+
+	// Removing last task stops it
+	CHECK(!executive.removeTask(taskB));
+	CHECK(executive.removeTask(taskF));
+	CHECK(executive.removeTask(taskA));
+	run(4);
+	expect(4120, 4124, none);
+
+	return hostResult("test_executive");
+}
@@ -0,0 +1,91 @@
+/**
+ * uTimerLib host test: timer cleared and restarted from other core and interrupts while it fires, under ThreadSanitizer
+ *
+ * One thread is esp_timer task, calling timer interrupt in a loop. Other one is the other core, restarting and clearing
+ * the timer, and a third one an interrupt on it clearing the timer too. ThreadSanitizer reports any unsynchronized
+ * access to shared timer state, like a plain _generation increment. A timeout can't be called more times than it's armed.
+ *
+ * @file test_generation.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLib.h"
+#include "host.h"
+#include <atomic>
+#include <thread>
+
+#define ROUNDS 20000
+
+static std::atomic<unsigned long> calls(0);
+static std::atomic<bool> running(true);
+
+void callback() {
+	calls++;
+}
+
+/**
+ * \brief esp_timer task: fires timer until stopped
+ */
+static void fire() {
+	while (running) {
+		uTimerLib::interrupt(&TimerLib);
+	}
+}
+
+/**
+ * \brief Interrupt on other core: clears timer until stopped
+ */
+static void cancel() {
+	while (running) {
+		TimerLib.clearTimer();
+		std::this_thread::yield();
+	}
+}
+
+/**
+ * \brief Runs a timing while it's restarted and cleared from other threads
+ *
+ * @param	timeout		Timing is a timeout; if not, an interval
+ */
+static void stress(bool timeout) {
+	calls = 0;
+	running = true;
+	if (timeout) {
+		TimerLib.setTimeout_us(callback, 1000);
+	} else {
+		TimerLib.setInterval_us(callback, 1000);
+	}
+	std::thread timer(fire);
+	std::thread other(cancel);
+	unsigned long armed = 1;
+	for (unsigned long i = 0; i < ROUNDS; i++) {
+		TimerLib.restart();
+		armed++;
+		if ((i & 3) == 0) {
+			TimerLib.clearTimer();
+		}
+	}
+	running = false;
+	timer.join();
+	other.join();
+
+	CHECK(calls > 0);
+	if (timeout) {
+		CHECK(calls <= armed);
+	}
+
+	// Cleared: nothing is called any more
+	TimerLib.clearTimer();
+	unsigned long done = calls;
+	uTimerLib::interrupt(&TimerLib);
+	CHECK(calls == done);
+}
+
+int main() {
+	stress(true);
+	stress(false);
+	return hostResult("test_generation");
+}
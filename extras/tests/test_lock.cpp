@@ -0,0 +1,61 @@
+/**
+ * uTimerLib host test: library critical sections nest, restoring previous interrupts state
+ *
+ * Library is built for a host board whose interrupts state is SREG (HOST_AVR), PS level (HOST_ESP8266) or a mutex that, as on
+ * hardware, doesn't nest (HOST_STM32 and HOST_SAM, whose state is not read: nesting is counted). After an inner _unlock()
+ * interrupts must still be masked, and after the outer one they must be as before. Where state is read, a critical section
+ * entered with interrupts masked, as in an interrupt, must leave them masked.
+ *
+ * @file test_lock.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLib.h"
+#include "host.h"
+#include <stdio.h>
+
+#if defined(HOST_AVR)
+	#define TEST_NAME "test_lock_avr"
+#elif defined(HOST_ESP8266)
+	#define TEST_NAME "test_lock_esp8266"
+#elif defined(HOST_SAM)
+	#define TEST_NAME "test_lock_sam"
+#else
+	#define TEST_NAME "test_lock_stm32"
+#endif
+
+/**
+ * \brief Nests three critical sections, checking interrupts are masked until outer one ends
+ */
+static void nest() {
+	bool before = hostMasked();
+	unsigned long int outer = uTimerLib::_lock();
+	CHECK(hostMasked());
+	unsigned long int middle = uTimerLib::_lock();
+	unsigned long int inner = uTimerLib::_lock();
+	uTimerLib::_unlock(inner);
+	CHECK(hostMasked());
+	uTimerLib::_unlock(middle);
+	CHECK(hostMasked());
+	uTimerLib::_unlock(outer);
+	CHECK(hostMasked() == before);
+}
+
+int main() {
+	interrupts();
+	nest();
+	CHECK(!hostMasked());
+
+	#if defined(HOST_AVR) || defined(HOST_ESP8266)
+		// As in an interrupt
+		noInterrupts();
+		nest();
+		CHECK(hostMasked());
+		interrupts();
+	#endif
+
+	return hostResult(TEST_NAME);
+}
@@ -0,0 +1,125 @@
+/**
+ * uTimerLib host test: FreeRTOS task notification dispatch (setNotifyTask) on an STM32 board, from its timer interrupt
+ *
+ * Library is built for host STM32 board (HOST_STM32), so _dispatch() notifies with vTaskNotifyGiveFromISR and
+ * portYIELD_FROM_ISR. Timer interrupt is called from main thread, as a task of lower priority was interrupted;
+ * notified task counts its ulTaskNotifyTake ticks. Callback must not be called while a task is notified, and
+ * task priority is raised and restored.
+ *
+ * @file test_notify.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLib.h"
+#include "host.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static std::atomic<unsigned long> calls(0);
+static std::atomic<unsigned long> taken(0);
+static std::atomic<bool> running(true);
+static std::atomic<bool> stopped(false);
+
+void callback() {
+	calls++;
+}
+
+/**
+ * \brief Notified task: counts ticks until stopped
+ */
+static void worker(void *arg) {
+	while (running) {
+		taken += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+	stopped = true;
+}
+
+/**
+ * \brief Calls timer interrupt, as Timer3 would
+ *
+ * @param	times	Interrupts
+ */
+static void fire(unsigned long times) {
+	for (unsigned long i = 0; i < times; i++) {
+		Timer3.handler();
+	}
+}
+
+/**
+ * \brief Waits for task to take some ticks, up to 1s
+ *
+ * @param	ticks	Ticks expected
+ * @return	false on timeout
+ */
+static bool wait(unsigned long ticks) {
+	for (int i = 0; i < 1000 && taken < ticks; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return taken == ticks;
+}
+
+int main() {
+	TaskHandle_t task;
+	xTaskCreate(worker, "worker", 1024, NULL, 1, &task);
+
+	// Interval notifies task from interrupt, with its priority raised; higher than interrupted one, so a switch is requested
+	TimerLib.setInterval_us(callback, 1000);
+	TimerLib.setNotifyTask(task, 5);
+	CHECK(uxTaskPriorityGet(task) == 5);
+	unsigned long yields = hostYields();
+	fire(10);
+	CHECK(wait(10));
+	CHECK(calls == 0);
+	CHECK(hostYields() == yields + 10);
+
+	// Interrupted task has higher priority: no switch
+	vTaskPrioritySet(xTaskGetCurrentTaskHandle(), 10);
+	yields = hostYields();
+	fire(3);
+	CHECK(wait(13));
+	CHECK(hostYields() == yields);
+	vTaskPrioritySet(xTaskGetCurrentTaskHandle(), 0);
+
+	// Kept for next timings: a timeout notifies once
+	TimerLib.setTimeout_us(callback, 1000);
+	fire(1);
+	CHECK(wait(14));
+	fire(1);
+	CHECK(taken == 14);
+	CHECK(calls == 0);
+
+	// Cleared timer: nothing
+	TimerLib.setInterval_us(callback, 1000);
+	TimerLib.clearTimer();
+	fire(1);
+	CHECK(taken == 14);
+
+	// Back to callback, with task priority restored
+	TimerLib.clearNotifyTask();
+	CHECK(uxTaskPriorityGet(task) == 1);
+	TimerLib.setInterval_us(callback, 1000);
+	fire(2);
+	CHECK(calls == 2);
+	CHECK(taken == 14);
+
+	// No priority: not changed
+	TimerLib.setNotifyTask(task);
+	CHECK(uxTaskPriorityGet(task) == 1);
+	fire(1);
+	CHECK(wait(15));
+	TimerLib.clearNotifyTask();
+	CHECK(uxTaskPriorityGet(task) == 1);
+
+	TimerLib.clearTimer();
+	running = false;
+	xTaskNotifyGive(task);
+	for (int i = 0; i < 1000 && !stopped; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK(stopped);
+	return hostResult("test_notify");
+}
@@ -0,0 +1,136 @@
+/**
+ * uTimerLib host test: uTimerLibPWM edges counted in timer ticks, with compare reloaded from each one (_reload)
+ *
+ * Library is built for a host board with plain variables as timer registers (HOST_AVR, with or without UTIMERLIB_AVR_TIMER1,
+ * HOST_SAMD21 or HOST_SAMD51), or for host ESP32 with esp_timer restarted on each edge, and run from them (hostCount()). Pins are read after each interrupt: each period must start
+ * a whole number of periods after first one, with no drift, and each channel must go low at its high time, rounded to a tick.
+ * A duty change must be taken at next period start.
+ *
+ * @file test_pwm.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibPWM.h"
+#include "host.h"
+#include <stdio.h>
+
+#if defined(HOST_AVR)
+	#if defined(UTIMERLIB_AVR_TIMER1)
+		#define TEST_NAME "test_pwm_avr_timer1"
+	#else
+		#define TEST_NAME "test_pwm_avr"
+	#endif
+#elif defined(HOST_SAMD21)
+	#define TEST_NAME "test_pwm_samd21"
+#elif defined(HOST_SAMD51)
+	#define TEST_NAME "test_pwm_samd51"
+#else
+	#define TEST_NAME "test_pwm_esp32"
+#endif
+
+#define CHANNELS 4
+
+static const uint8_t pins[CHANNELS] = {2, 3, 4, 5};
+
+/**
+ * \brief Absolute difference
+ */
+static uint64_t diff(uint64_t a, uint64_t b) {
+	return (a > b) ? a - b : b - a;
+}
+
+/**
+ * \brief Runs PWM for some periods, checking its edges
+ *
+ * Channel 0 is always high, channels 1 to 3 go low at high[1] to high[3]; after half of periods, channel 1 high time is changed to change.
+ *
+ * @param	period		Period in microseconds
+ * @param	high		High times in microseconds
+ * @param	change		New channel 1 high time
+ * @param	periods		Periods to run
+ */
+static void run(unsigned long period, const unsigned long *high, unsigned long change, unsigned long periods) {
+	uTimerLibPWM pwm;
+	for (uint8_t i = 0; i < CHANNELS; i++) {
+		CHECK(pwm.attach(pins[i]));
+		CHECK(pwm.setDuty_us(pins[i], high[i]));
+	}
+	unsigned long duty[CHANNELS] = {high[0], high[1], high[2], high[3]};
+	CHECK(pwm.begin(period));
+
+	uint64_t elapsed = 0, first = 0, length = 0, start = 0;
+	unsigned long starts = 0;
+	uint8_t was[CHANNELS] = {0, 0, 0, 0};
+	bool failed = false;
+	while (starts <= periods && !failed) {
+		bool rising = false;
+		for (uint8_t i = 0; i < CHANNELS; i++) {
+			uint8_t now = digitalRead(pins[i]);
+			if (now == was[i]) {
+				continue;
+			}
+			was[i] = now;
+			if (now == HIGH) {
+				rising = true;
+				continue;
+			}
+			// Falling: at high time from period start, rounded to a tick
+			uint64_t at = elapsed - start, expected = (uint64_t) duty[i] * (F_CPU / 1000000);
+			if (diff(at, expected) > hostTick() / 2) {
+				fprintf(stderr, "begin(%lu): period %lu, pin %u low at %llu cycles, expected %llu (tick %llu)\n", period, starts, pins[i],
+						(unsigned long long) at, (unsigned long long) expected, (unsigned long long) hostTick());
+				failed = true;
+			}
+		}
+		CHECK(was[0] == HIGH);
+		if (rising) {
+			// Period start: first one at begin(), next ones a whole number of periods later
+			if (starts == 1) {
+				first = elapsed;
+				length = elapsed;
+				CHECK(diff(length, (uint64_t) period * (F_CPU / 1000000)) <= hostTick() / 2);
+			} else if (starts > 1 && elapsed != first + length * (starts - 1)) {
+				fprintf(stderr, "begin(%lu): period %lu starts at %llu cycles, expected %llu\n", period, starts,
+						(unsigned long long) elapsed, (unsigned long long) (first + length * (starts - 1)));
+				failed = true;
+			}
+			start = elapsed;
+			starts++;
+			if (starts == periods / 2) {
+				CHECK(pwm.setDuty_us(pins[1], change));
+			} else if (starts == periods / 2 + 1) {
+				duty[1] = change; // Taken at this period start
+			}
+		}
+		elapsed += hostCount();
+	}
+	CHECK(!failed);
+	pwm.end();
+	for (uint8_t i = 0; i < CHANNELS; i++) {
+		CHECK(digitalRead(pins[i]) == LOW);
+	}
+}
+
+int main() {
+	// Servo: 20ms period, compares split on 8 bit timer
+	static const unsigned long servo[CHANNELS] = {30000, 1000, 1500, 2000};
+	run(20000, servo, 1700, 50);
+
+	// 1kHz, edges from 50us to 950us
+	static const unsigned long khz[CHANNELS] = {1000, 50, 500, 950};
+	run(1000, khz, 250, 200);
+
+	// 10kHz, edges 25us apart, more than UTIMERLIB_PWM_MIN_GAP_US (closer ones are merged)
+	static const unsigned long fast[CHANNELS] = {100, 25, 50, 75};
+	run(100, fast, 35, 500);
+
+	// Not a whole number of ticks: period and edges rounded, but no drift
+	static const unsigned long odd[CHANNELS] = {4000, 333, 1234, 2777};
+	run(3001, odd, 2000, 100);
+
+	TimerLib.clearTimer();
+	return hostResult(TEST_NAME);
+}
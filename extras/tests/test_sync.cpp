@@ -0,0 +1,143 @@
+/**
+ * uTimerLib host test: no wait for register synchronization from interrupts
+ *
+ * Library is built for a host SAMD board (HOST_SAMD21 or HOST_SAMD51), whose synchronization busy flags count reads done
+ * from interrupts: timer ones (hostCount()) and functions called as one (hostInterrupt()). Everything a callback or another
+ * interrupt may call (now_ticks(), restart(), clearTimer(), a timeout ending, now_ticks() idle count, uTimerLibPWM edges)
+ * is run there, and no flag may have been read; on SAMD21 input capture values must be fresh, not a stale synchronized CC0. Last, a set up called from an interrupt must be counted, so test can fail.
+ *
+ * @file test_sync.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibPWM.h"
+#include "host.h"
+#include <stdio.h>
+
+#if defined(HOST_SAMD21)
+	#define TEST_NAME "test_sync_samd21"
+#else
+	#define TEST_NAME "test_sync_samd51"
+#endif
+
+static unsigned long calls = 0;
+
+/**
+ * \brief Interval callback: reads clock and restarts interval
+ */
+static void restartCallback() {
+	TimerLib.now_ticks();
+	TimerLib.restart();
+	calls++;
+}
+
+/**
+ * \brief Callback ending timer
+ */
+static void clearCallback() {
+	TimerLib.clearTimer();
+	calls++;
+}
+
+/**
+ * \brief Timeout callback: only counts
+ */
+static void countCallback() {
+	calls++;
+}
+
+/**
+ * \brief Reads clock, as from another interrupt
+ */
+static void nowTicks() {
+	TimerLib.now_ticks();
+}
+
+/**
+ * \brief Sets an interval up, as from another interrupt
+ */
+static void setUp() {
+	TimerLib.setInterval_us(countCallback, 1000);
+}
+
+#if defined(HOST_SAMD21)
+	static uint32_t captured = 0;
+
+	/**
+	 * \brief Capture callback: keeps timestamp
+	 */
+	static void captureCallback(uint32_t timestamp) {
+		captured = timestamp;
+	}
+#endif
+
+int main() {
+	// now_ticks() clock started out of interrupts, so it may set timer up
+	TimerLib.now_ticks();
+
+	// Interval restarted from its callback
+	TimerLib.setInterval_us(restartCallback, 1000);
+	for (int i = 0; i < 100; i++) {
+		hostCount();
+	}
+	CHECK(calls == 100);
+
+	// Timeout ending: timer is cleared from interrupt and keeps idle count for now_ticks()
+	calls = 0;
+	TimerLib.setTimeout_us(countCallback, 30000);
+	for (int i = 0; i < 100; i++) {
+		hostCount();
+		hostInterrupt(nowTicks);
+	}
+	CHECK(calls == 1);
+
+	// Interval cleared from its callback
+	calls = 0;
+	TimerLib.setInterval_us(clearCallback, 2000);
+	for (int i = 0; i < 10; i++) {
+		hostCount();
+	}
+	CHECK(calls == 1);
+	hostInterrupt(nowTicks);
+
+	// Software PWM edges
+	uTimerLibPWM pwm;
+	CHECK(pwm.attach(2));
+	CHECK(pwm.attach(3));
+	CHECK(pwm.setDuty_us(2, 300));
+	CHECK(pwm.setDuty_us(3, 700));
+	CHECK(pwm.begin(1000));
+	for (int i = 0; i < 100; i++) {
+		hostCount();
+		hostInterrupt(nowTicks);
+	}
+	pwm.end();
+
+	#if defined(HOST_SAMD21)
+		// Input capture: each value read from CC0 with no wait, and not previous one. Cleared from an interrupt, back to idle count
+		CHECK(TimerLib._attachCapture(4, RISING, captureCallback, &calls));
+		hostCapture(1234);
+		CHECK(captured == 1234);
+		hostCapture(5678);
+		CHECK(captured == 5678);
+		hostInterrupt(nowTicks);
+		hostInterrupt(clearCallback);
+		hostInterrupt(nowTicks);
+		hostCount();
+	#endif
+
+	if (hostSyncWaits() != 0) {
+		fprintf(stderr, "%lu synchronization busy flag reads from interrupts\n", hostSyncWaits());
+	}
+	CHECK(hostSyncWaits() == 0);
+
+	// Test itself: a set up waits for synchronization, so it's counted from an interrupt
+	hostInterrupt(setUp);
+	CHECK(hostSyncWaits() != 0);
+
+	TimerLib.clearTimer();
+	return hostResult(TEST_NAME);
+}
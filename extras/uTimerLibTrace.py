@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+uTimerLib trace decoder
+
+Turns a TimerLib.traceDump(Serial) dump (sketch built with UTIMERLIB_TRACE defined)
+into Chrome trace JSON, to be opened on chrome://tracing or https://ui.perfetto.dev,
+and prints callback duration, dispatch latency and interval jitter.
+
+Usage:
+    python3 uTimerLibTrace.py serial.log [-o trace.json]
+
+Input can be a whole Serial log: last complete dump in it is decoded.
+Dump format is described on uTimerLib::traceDump().
+
+@url https://www.github.com/Naguissa/uTimerLib
+"""
+
+import argparse
+import json
+import sys
+
+HEADER = "uTimerLib trace "
+END = "uTimerLib trace end"
+
+ARM = 1
+CANCEL = 2
+FIRE = 3
+CB_START = 4
+CB_END = 5
+OVERRUN = 6
+
+TYPES = {1: "timeout", 2: "interval"}
+
+# Chrome trace rows
+TID_TIMER = 1
+TID_CALLBACK = 2
+TID_LATENCY = 3
+
+
+def read_dump(lines):
+    """Returns (size, written, hz, records) of last complete dump; records are (time, event, arg)
+
+    Format 1 (micros() timestamps) has no hz: 1000000.
+    """
+    dump = None
+    current = None
+    for line in lines:
+        line = line.strip()
+        if line == END:
+            if current is not None:
+                dump = current
+            current = None
+        elif line.startswith(HEADER):
+            fields = line[len(HEADER):].split()
+            if fields[:1] == ["1"] and len(fields) == 3:
+                fields.append("F4240")
+            if len(fields) != 4 or fields[0] not in ("1", "2"):
+                current = None
+                continue
+            current = (int(fields[1], 16), int(fields[2], 16), int(fields[3], 16), [])
+        elif current is not None:
+            if len(line) != 12:
+                current = None  # Garbled line: drop this dump
+                continue
+            current[3].append((int(line[0:8], 16), int(line[8:10], 16), int(line[10:12], 16)))
+    return dump
+
+
+def unwrap(records, hz):
+    """Extends 32 bit tick times, relative to first record, to microseconds; a small step back is kept (ESP32 cores)"""
+    result = []
+    now = 0
+    previous = None
+    for time, event, arg in records:
+        if previous is not None:
+            delta = (time - previous) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            now += delta
+        previous = time
+        result.append((now * 1000000.0 / hz, event, arg))
+    return result
+
+
+def stats(values):
+    if not values:
+        return "-"
+    return "min %.1f avg %.1f max %.1f us (%d)" % (min(values), sum(values) / len(values), max(values), len(values))
+
+
+def decode(records):
+    events = [
+        {"ph": "M", "pid": 1, "tid": TID_TIMER, "name": "thread_name", "args": {"name": "timer"}},
+        {"ph": "M", "pid": 1, "tid": TID_CALLBACK, "name": "thread_name", "args": {"name": "callback"}},
+        {"ph": "M", "pid": 1, "tid": TID_LATENCY, "name": "thread_name", "args": {"name": "fire to callback"}},
+    ]
+    durations = []
+    latencies = []
+    intervals = []
+    overruns = 0
+    dropped = 0
+
+    fire = None  # (time, generation) of last fire not dispatched yet
+    last_fire = None
+    start = None
+
+    def instant(time, name, args):
+        events.append({"ph": "i", "s": "t", "pid": 1, "tid": TID_TIMER, "ts": time, "name": name, "args": args})
+
+    for time, event, arg in records:
+        if event == ARM:
+            instant(time, "arm", {"type": TYPES.get(arg, arg)})
+            if fire is not None:
+                dropped += 1
+            fire = None
+            last_fire = None
+        elif event == CANCEL:
+            instant(time, "cancel", {"generation": arg})
+            if fire is not None:
+                dropped += 1
+            fire = None
+            last_fire = None
+        elif event == FIRE:
+            if fire is not None:
+                dropped += 1
+            instant(time, "fire", {"generation": arg})
+            if last_fire is not None:
+                intervals.append(time - last_fire)
+            fire = (time, arg)
+            last_fire = time
+        elif event == CB_START:
+            start = time
+            if fire is not None:
+                latency = time - fire[0]
+                latencies.append(latency)
+                events.append({"ph": "X", "pid": 1, "tid": TID_LATENCY, "ts": fire[0], "dur": latency, "name": "latency"})
+            fire = None
+        elif event == CB_END:
+            if start is not None:
+                duration = time - start
+                durations.append(duration)
+                events.append({"ph": "X", "pid": 1, "tid": TID_CALLBACK, "ts": start, "dur": duration, "name": "callback"})
+            start = None
+        elif event == OVERRUN:
+            instant(time, "overrun", {"missed": arg})
+            overruns += arg
+        else:
+            instant(time, "unknown", {"event": event, "arg": arg})
+
+    summary = [
+        "callback: " + stats(durations),
+        "fire to callback: " + stats(latencies),
+        "fire interval: " + stats(intervals),
+        "overrun ticks: %d" % overruns,
+        "fires with no callback: %d" % dropped,
+    ]
+    return events, summary
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes a uTimerLib trace dump to Chrome trace JSON")
+    parser.add_argument("input", nargs="?", help="Serial log with the dump (stdin if not given)")
+    parser.add_argument("-o", "--output", help="Chrome trace JSON file (stdout if not given)")
+    args = parser.parse_args()
+
+    if args.input:
+        with open(args.input, errors="replace") as f:
+            dump = read_dump(f)
+    else:
+        dump = read_dump(sys.stdin)
+    if dump is None:
+        sys.exit("No complete uTimerLib trace dump found")
+
+    size, written, hz, records = dump
+    events, summary = decode(unwrap(records, hz))
+    trace = {"traceEvents": events, "displayTimeUnit": "ms"}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+        sys.stdout.write("\n")
+
+    sys.stderr.write("records: %d of %d written (ring of %d), %d Hz timestamps\n" % (len(records), written, size, hz))
+    for line in summary:
+        sys.stderr.write(line + "\n")
+
+
+if __name__ == "__main__":
+    main()
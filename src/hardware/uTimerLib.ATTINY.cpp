@@ -48,19 +48,49 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
+		if (us > 0xFFFFFFFFFFFFFFFFULL / _clockHz) { // Cycles don't fit in 64 bits (days): count them from whole miliseconds
+			_attachInterrupt_cycles(us / 1000 * _clockHz, 1000);
+			return;
+		}
+		_attachInterrupt_cycles(us * _clockHz, 1000000);
+	}
 
-		unsigned char CSMask = 0;
-		// For this notes, we asume 16MHz CPU. We recalculate 'us' if not:
-		if (F_CPU != 16000000) {
-			us = F_CPU / 16000000 * us;
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	s		Desired timing in seconds
+	 */
+	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
+		if (s == 0) { // Not valid
+			return;
 		}
+		_attachInterrupt_cycles((unsigned long long int) s * _clockHz, 1);
+	}
+
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for num / den CPU cycles
+	 *
+	 * Prescaler is the smallest one that fits timing in one count, for best resolution; if none, largest one counting overflows.
+	 * Fraction of a tick left is added by _fraction() on each period.
+	 * Delays on table are for 16MHz; real ones scale with CPU clock (F_CPU, or current one after clockChanged()).
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	num		Desired timing numerator, in CPU cycles
+	 * @param	den		Desired timing denominator
+	 */
+	void uTimerLib::_attachInterrupt_cycles(unsigned long long int num, unsigned long int den) {
+		unsigned long long int ticks;
 		TIMSK &= ~((1 << TOIE1) | (1 << OCIE1A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
-		cli();
-		// ATTiny, using Timer1. Counts at 16MHz (it other speed is used we recalculate us before)
+		// ATTiny, using Timer1
 		/*
 		Prescaler: TCCR1; 4 last bits, CS10, CS11, CS12 and CS13
 
@@ -82,63 +112,14 @@
 		  1		  1		  1		 0		16MHz		 8192		 512us				131072us
 		  1		  1		  1		 1		16MHz		16384		1024us				262144us
 		*/
-		if (us >= 262144) {
-			CSMask = (1<<CS13) | (1<<CS12) | (1<<CS11) | (1<<CS10);
-			_overflows = us / 262144;
-			_remaining = 256 - ((us % 262144) / 1024 + 0.5); // + 0.5 is round for positive numbers
-		} else {
-			if (us >= 131072) {
-				CSMask = (1<<CS13) | (1<<CS12) | (1<<CS11) | (1<<CS10);
-				_remaining = 256 - (us / 1024 + 0.5); // + 0.5 is round for positive numbers
-			} else if (us >= 65536) {
-				CSMask = (1<<CS13) | (1<<CS12) | (1<<CS11);
-				_remaining = 256 - (us / 512 + 0.5); // + 0.5 is round for positive numbers
-			} else if (us >= 32768) {
-				CSMask = (1<<CS13) | (1<<CS12) | (1<<CS10);
-				_remaining = 256 - (us / 256 + 0.5); // + 0.5 is round for positive numbers
-			} else if (us >= 16384) {
-				CSMask = (1<<CS13) | (1<<CS12);
-				_remaining = 256 - (us / 128 + 0.5); // + 0.5 is round for positive numbers
-			} else if (us >= 8192) {
-				CSMask = (1<<CS13) | (1<<CS11) | (1<<CS10);
-				_remaining = 256 - (us / 64 + 0.5); // + 0.5 is round for positive numbers
-			} else if (us >= 4096) {
-				CSMask = (1<<CS13) | (1<<CS11);
-				_remaining = 256 - (us / 32 + 0.5);
-			} else if (us >= 2048) {
-				CSMask = (1<<CS13) | (1<<CS10);
-				_remaining = 256 - (us / 16 + 0.5);
-			} else if (us >= 1024) {
-				CSMask = (1<<CS13);
-				_remaining = 256 - (us / 8 + 0.5);
-			} else if (us >= 512) {
-				CSMask = (1<<CS12) | (1<<CS11) | (1<<CS10);
-				_remaining = 256 - (us / 4 + 0.5);
-			} else if (us >= 256) {
-				CSMask = (1<<CS12) | (1<<CS11);
-				_remaining = 256 - (us / 2 + 0.5);
-			} else if (us >= 128) {
-				CSMask = (1<<CS12) | (1<<CS10);
-				_remaining = 256 - us;
-			} else if (us >= 64) {
-				CSMask = (1<<CS12);
-				_remaining = 256 - (us * 2);
-			} else if (us >= 32) {
-				CSMask = (1<<CS11) | (1<<CS10);
-				_remaining = 256 - (us * 4);
-			} else if (us >= 16) {
-				CSMask = (1<<CS11);
-				_remaining = 256 - (us * 8);
-			} else {
-				CSMask = (1<<CS10);
-				_remaining = 256 - (us * 16);
-			}
-			_overflows = 0;
-		}
+		static const unsigned char shifts[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
+		unsigned char CSMask = _prescale(num / den, shifts, 15, 256, &ticks);
+		ticks = _ticks(num, (unsigned long long int) den << shifts[CSMask - 1]);
+		_overflows = ticks >> 8;
+		_remaining = 256 - (ticks & 0xFF); // Counter preload for last count; 0 if there's none
 
 		__overflows = _overflows;
 		__remaining = _remaining;
-		_overflows += 1; // Fix interrupt incorrectly firing just after sei()
 
 		PLLCSR &= ~(1<<PCKE); 		// Internal clock
 		// TCCR1A = (1<<COM1A1);	// Normal operation
@@ -146,67 +127,121 @@
 		TCCR1 |= (1 << CTC1);  // clear timer on compare match
 		TCCR1 = TCCR1 & ~((1<<CS13) | (1<<CS12) | (1<<CS11) | (1<<CS10)) | CSMask;	// Sets divisor
 
+		_restart();
+	}
+
+	/**
+	 * \brief Starts counting last timing from now: reloads counter, overflows count and interrupt, with timer clock already set
+	 *
+	 * Last step of setting up the timer, and restart(). Timer interrupt is disabled while counts are loaded, so no lock is needed.
+	 * No loops nor waits: a few dozen instructions.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		TIMSK &= ~(1 << TOIE1);		// Timer interrupt doesn't see counts half loaded
+		_overflows = __overflows + 1; // Fix interrupt incorrectly firing just after being enabled
+		_remaining = __remaining;
 		TCNT1 = 0;				// Clean timer count
 		TIMSK |= (1 << TOIE1);		// Enable overflow interruption when 0
-		sei();
+		return true;
 	}
 
-
 	/**
-	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 * \brief Gives running count of current interval, started on its last compare, a new length in timer ticks
+	 *
+	 * Not available on this device: counts end on overflow of a preloaded counter, so a running one can't be given an exact new length.
 	 *
 	 * Note: This is device-dependant
 	 *
-	 * @param	s		Desired timing in seconds
+	 * @param	ticks	Timer ticks
+	 * @return	false
 	 */
-	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
-		if (s == 0) { // Not valid
-			return;
-		}
-		unsigned char CSMask = 0;
-		// For this notes, we asume 16MHz CPU. We recalculate 'us' if not:
-		if (F_CPU != 16000000) {
-			s = F_CPU / 16000000 * s;
-		}
-		TIMSK &= ~((1 << TOIE1) | (1 << OCIE1A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
-		cli();
-		// ATTiny, using Timer1. Counts at 16MHz (it other speed is used we recalculate us before)
-		/*
-		Prescaler: TCCR1; 4 last bits, CS10, CS11, CS12 and CS13
-
-		CS13	CS12	CS11	CS10	Freq		Divisor		Base Delay		Overflow delay
-		  1		  1		  1		 1		16MHz		16384		1024us				262144us
-		*/
-
-		CSMask = (1<<CS13) | (1<<CS12) | (1<<CS11) | (1<<CS10);
-		_overflows = s * 1000000 / 262144;
-		_remaining = 256 - (((s * 1000000) % 262144) / 1024 + 0.5); // + 0.5 is round for positive numbers
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		return false;
+	}
 
-		__overflows = _overflows;
-		__remaining = _remaining;
-		_overflows += 1; // Fix interrupt incorrectly firing just after sei()
+	/**
+	 * \brief Microseconds in timer ticks of current interval prescaler
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	0, counts can't be reloaded
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		return 0;
+	}
 
-		PLLCSR &= ~(1<<PCKE); 		// Internal clock
-		// TCCR1A = (1<<COM1A1);	// Normal operation
 
-		// All '1', so simplify to next line... TCCR1 = TCCR1 & ~((1<<CS13) | (1<<CS12) | (1<<CS11) | (1<<CS10)) | CSMask;	// Sets divisor
-		TCCR1 = TCCR1 | CSMask;	// Sets divisor
 
-		// Clean counter in normal operation, load remaining when overflows == 0
-		TCNT1 = 0;				// Clean timer count
-		TIMSK |= (1 << TOIE1);		// Enable overflow interruption when 0
-		sei();
+	/**
+	 * \brief Drives pin directly from timer compare output
+	 *
+	 * Not available on this device: timer compare output pins are not routed yet.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false, so pin is toggled by interrupt
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		return false;
 	}
 
 
+	/**
+	 * \brief Sets up timer for input capture on pin
+	 *
+	 * Not available on this device: Timer1 has no input capture unit.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		return false;
+	}
 
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
 	 *
+	 * Preload is added to ticks counted since overflow, so interrupt latency doesn't lengthen last count.
+	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::_loadRemaining() {
-		TCNT1 = _remaining;
+		TCNT1 += _remaining;
+	}
+
+	/**
+	 * \brief Counts interval periods ended while callback ran, from pending overflow flag and counter, and drops them
+	 *
+	 * Called after an interval callback. Counter has no preload while overflow is pending, so its value is time since that period end:
+	 * whole periods in it are missed too, and its remainder is kept when preload is loaded, so next interrupt stays on periods grid.
+	 * Intervals counting several overflows are not checked: a pending one is part of next period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		if (__overflows != 0 || !(TIFR & (1 << TOV1))) {
+			return 0;
+		}
+		unsigned char period = 0 - __remaining; // Preload is 256 - period
+		unsigned char ticks = TCNT1;
+		TCNT1 += __remaining - ticks / period * period; // Ticks counted from read to write are kept
+		TIFR = (1 << TOV1);
+		return 1 + ticks / period;
 	}
 
 	/**
@@ -215,9 +250,11 @@
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
+		unsigned char generation = _cancel();
 		_type = UTIMERLIB_TYPE_OFF;
 
 		TIMSK &= ~(1 << TOIE1);		// Disable overflow interruption when 0
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
 //		SREG = (SREG & 0b01111111); // Disable interrupts without modifiying other interrupts
 
 	}
@@ -229,6 +266,7 @@
 	 * this function implements oferflow control to offer user desired timings.
 	 */
 	void uTimerLib::_interrupt() {
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
 		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
@@ -243,17 +281,21 @@
 		} else if (_overflows == 0 && _remaining == 0) {
 			if (_type == UTIMERLIB_TYPE_TIMEOUT) {
 				clearTimer();
+				generation = _current(); // Own clear, not a cancel
 			} else if (_type == UTIMERLIB_TYPE_INTERVAL) {
 				if (__overflows == 0) {
-					_remaining = __remaining;
+					_remaining = __remaining - _fraction(); // One tick more each time fraction adds up to one: start count one lower
 					_loadRemaining();
 					_remaining = 0;
 				} else {
 					_overflows = __overflows;
 					_remaining = __remaining;
+					if (_fraction() && --_remaining == 0) { // Last count became a complete one
+						_overflows++;
+					}
 				}
 			}
-			_cb();
+			_dispatch(generation);
 		}
 	}
 
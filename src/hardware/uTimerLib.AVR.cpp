@@ -6,7 +6,7 @@
  *		* Atmel ATtiny:		Timer1 (2nd timer) - https://github.com/damellis/attiny and https://github.com/SpenceKonde/Disgispark AVRCore (25, 45 and 85)
  *		* DisgiSpark AVR:	Timer0 (1st timer) - https://github.com/digistump/DigistumpArduino
  *		* Atmel AVR 32U4:	Timer3 (4rd timer)
- *		* Atmel AVR other:	Timer2 (3rd timer)
+ *		* Atmel AVR other:	Timer2 (3rd timer), or Timer1 (2nd timer) when UTIMERLIB_AVR_TIMER1 is defined
  *		* STM32:			Timer3 (3rd timer)
  *		* SAM (Due):		TC3 (Timer1, channel 0)
  *		* ESP8266:			OS Timer, one slot of seven available (Software timer provided by Arduino because ESP8266 has only two hardware timers and one is needed by it normal operation)
@@ -35,6 +35,91 @@
 	#define _uTimerLib_IMP_
 	#include "uTimerLib.cpp"
 
+	// Timer runs in CTC mode: compare register is TOP, and counter restarts from 0 on each compare
+	#ifdef __AVR_ATmega32U4__
+		/**
+		 * \brief Compare register of timer used, TOP in CTC mode
+		 */
+		#define UTIMERLIB_OCR OCR3A
+		/**
+		 * \brief TOP of a complete compare, counted in _overflows
+		 */
+		#define UTIMERLIB_OCR_MAX 0xFFFF
+		/**
+		 * \brief Counter, control registers with their CTC mode bits, interrupt flag and mask registers of timer used
+		 */
+		#define UTIMERLIB_TCNT TCNT3
+		#define UTIMERLIB_TCCRA TCCR3A
+		#define UTIMERLIB_TCCRA_CTC 0
+		#define UTIMERLIB_TCCRB TCCR3B
+		#define UTIMERLIB_TCCRB_CTC (1<<WGM32)
+		#define UTIMERLIB_TIFR TIFR3
+		#define UTIMERLIB_OCF OCF3A
+		#define UTIMERLIB_TIMSK TIMSK3
+		#define UTIMERLIB_OCIE OCIE3A
+		/**
+		 * \brief Fastest prescaler (CS bits) of now_ticks() idle count: CPU clock / 8, 0.5us ticks and a compare each 33ms at 16MHz
+		 */
+		#define UTIMERLIB_NOW_CS 2
+		/**
+		 * \brief Timer prescalers as powers of 2, by CS bits value - 1
+		 */
+		static const unsigned char _uTimerLibShifts[] = {0, 3, 6, 8, 10};
+	#elif defined(UTIMERLIB_AVR_TIMER1)
+		#define UTIMERLIB_OCR OCR1A
+		#define UTIMERLIB_OCR_MAX 0xFFFF
+		#define UTIMERLIB_TCNT TCNT1
+		#define UTIMERLIB_TCCRA TCCR1A
+		#define UTIMERLIB_TCCRA_CTC 0
+		#define UTIMERLIB_TCCRB TCCR1B
+		#define UTIMERLIB_TCCRB_CTC (1<<WGM12)
+		#define UTIMERLIB_TIFR TIFR1
+		#define UTIMERLIB_OCF OCF1A
+		#define UTIMERLIB_TIMSK TIMSK1
+		#define UTIMERLIB_OCIE OCIE1A
+		#define UTIMERLIB_NOW_CS 2 // CPU clock / 8
+		static const unsigned char _uTimerLibShifts[] = {0, 3, 6, 8, 10};
+	#else
+		#define UTIMERLIB_OCR OCR2A
+		#define UTIMERLIB_OCR_MAX 0xFF
+		#define UTIMERLIB_TCNT TCNT2
+		#define UTIMERLIB_TCCRA TCCR2A
+		#define UTIMERLIB_TCCRA_CTC (1<<WGM21)
+		#define UTIMERLIB_TCCRB TCCR2B
+		#define UTIMERLIB_TCCRB_CTC 0
+		#define UTIMERLIB_TIFR TIFR2
+		#define UTIMERLIB_OCF OCF2A
+		#define UTIMERLIB_TIMSK TIMSK2
+		#define UTIMERLIB_OCIE OCIE2A
+		#define UTIMERLIB_NOW_CS 4 // CPU clock / 64: 4us ticks and a compare each 1ms at 16MHz, as Arduino Timer0
+		static const unsigned char _uTimerLibShifts[] = {0, 3, 5, 6, 7, 8, 10};
+	#endif
+
+	#if defined(UTIMERLIB_AVR_NAKED_ISR)
+		/**
+		 * \brief Overflows naked interrupt swallows before calling regular one; a plain symbol, so assembly can use it
+		 */
+		extern "C" {
+			volatile unsigned char _uTimerLibSkip = 0;
+		}
+
+		/**
+		 * \brief Moves overflows with nothing to do to naked interrupt counter, up to 255 at once
+		 *
+		 * It only moves them when counter is empty, so calling it again (e.g. timer set again from callback) is harmless.
+		 *
+		 * Note: This is device-dependant
+		 */
+		void uTimerLib::_skipOverflows() {
+			if (_uTimerLibSkip == 0 && _overflows > 1) { // Last one does something
+				unsigned char skip = (_overflows - 1 > 255) ? 255 : _overflows - 1;
+				_overflows -= skip;
+				_nowSkip = skip;
+				_uTimerLibSkip = skip;
+			}
+		}
+	#endif
+
 
 	/**
 	 * \brief Sets up the timer, calculation variables and interrupts for desired ms microseconds
@@ -43,225 +128,387 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
+		if (us > 0xFFFFFFFFFFFFFFFFULL / _clockHz) { // Cycles don't fit in 64 bits (days): count them from whole miliseconds
+			_attachInterrupt_cycles(us / 1000 * _clockHz, 1000);
+			return;
+		}
+		_attachInterrupt_cycles(us * _clockHz, 1000000);
+	}
+
 
-		unsigned char CSMask = 0;
-		// For this notes, we asume 16MHz CPU. We recalculate 'us' if not:
-		if (F_CPU != 16000000) {
-			us = F_CPU / 16000000 * us;
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	s		Desired timing in seconds
+	 */
+	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
+		if (s == 0) { // Not valid
+			return;
 		}
+		_attachInterrupt_cycles((unsigned long long int) s * _clockHz, 1);
+	}
+
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for num / den CPU cycles
+	 *
+	 * Prescaler is the smallest one that fits timing in one count, for best resolution; if none, largest one counting overflows.
+	 * Fraction of a tick left is added by _fraction() on each period.
+	 * Delays on tables are for 16MHz; real ones scale with CPU clock (F_CPU, or current one after clockChanged()).
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	num		Desired timing numerator, in CPU cycles
+	 * @param	den		Desired timing denominator
+	 */
+	void uTimerLib::_attachInterrupt_cycles(unsigned long long int num, unsigned long int den) {
+		unsigned long long int ticks;
+		unsigned char CSMask;
 
 		// Leonardo and other 32U4 boards
 		#ifdef __AVR_ATmega32U4__
-			TIMSK3 &= ~((1 << TOIE3) | (1 << OCIE3A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
-			cli();
-			// 32U4, using Timer3. Counts at 16MHz
+			// 32U4, using Timer3 (16 bit) in CTC mode, TOP = OCR3A
 			/*
 			Prescaler: TCCR3B; 3 last bits, CS30, CS31 and CS32
 
-			CS32	CS31	CS30	Freq		Divisor		Base Delay	Overflow delay
-			  0		  0		  0		stopped		   -		    -			    -
-			  0		  0		  1		16MHz		   1		0.0625us			   16us
-			  0		  1		  0		2MHz		   8		   0.5us			  128us
-			  0		  1		  1		250KHz		  64		     4us			 1024us
-			  1		  0		  0		62.5KHz		 256		    16us			 4096us
-			  1		  0		  1		15.625KHz	1024		    64us			16384us
+			CS32	CS31	CS30	Divisor		Base Delay	Compare max delay
+			  0		  0		  0		   -		    -			    -
+			  0		  0		  1		   1		0.0625us		   4096us
+			  0		  1		  0		   8		   0.5us		  32768us
+			  0		  1		  1		  64		     4us		 262144us
+			  1		  0		  0		 256		    16us		1048576us
+			  1		  0		  1		1024		    64us		4194304us
+
+			Longer timings count complete 65536 ticks compares in _overflows and load last one in OCR3A
 			*/
-			if (us >= 16384) {
-				CSMask = (1<<CS32) | (1<<CS31) | (1<<CS30);
-				_overflows = us / 16384;
-				_remaining = 256 - ((us % 16384) / 64 + 0.5); // + 0.5 is round for positive numbers
-			} else {
-				if (us >= 4096) {
-					CSMask = (1<<CS32) | (1<<CS30);
-					_remaining = 256 - (us / 64 + 0.5); // + 0.5 is round for positive numbers
-				} else if (us >= 2048) {
-					CSMask = (1<<CS32);
-					_remaining = 256 - (us / 16 + 0.5); // + 0.5 is round for positive numbers
-				} else if (us >= 512) {
-					CSMask = (1<<CS31) | (1<<CS30);
-					_remaining = 256 - (us / 4 + 0.5); // + 0.5 is round for positive numbers
-				} else if (us >= 16) {
-					CSMask = (1<<CS31);
-					_remaining = 256 - us * 2;
-				} else {
-					CSMask = (1<<CS30);
-					_remaining = 256 - (us * 16);
-				}
-				_overflows = 0;
-			}
+			CSMask = _prescale(num / den, _uTimerLibShifts, 5, 65535, &ticks);	// 65535: room for fraction tick in one compare
+			ticks = _ticks(num, (unsigned long long int) den << _uTimerLibShifts[CSMask - 1]);
+			// ticks - 1 = _overflows * 65536 + _remaining; last compare counts _remaining + 1 ticks
+			_overflows = (ticks - 1) >> 16;
+			_remaining = (ticks - 1) & 0xFFFF;
+
+			TIMSK3 &= ~((1 << TOIE3) | (1 << OCIE3A));	// Disable overflow interruption when 0 + Disable interrupt on compare match; after math, as it may count for now_ticks() meanwhile
+			__overflows = _overflows;
+			__remaining = _remaining;
+			TCCR3A = 0;					// Normal port operation, OC3A disconnected; CTC mode, TOP = OCR3A, and divisor are set by _restart()
+		#elif defined(UTIMERLIB_AVR_TIMER1)
+			// AVR, using Timer1 (16 bit) in CTC mode, TOP = OCR1A
+			/*
+			Prescaler: TCCR1B; 3 last bits, CS10, CS11 and CS12
 
+			CS12	CS11	CS10	Divisor		Base Delay	Compare max delay
+			  0		  0		  0		   -		    -			    -
+			  0		  0		  1		   1		0.0625us		   4096us
+			  0		  1		  0		   8		   0.5us		  32768us
+			  0		  1		  1		  64		     4us		 262144us
+			  1		  0		  0		 256		    16us		1048576us
+			  1		  0		  1		1024		    64us		4194304us
+
+			Longer timings count complete 65536 ticks compares in _overflows and load last one in OCR1A
+			*/
+			CSMask = _prescale(num / den, _uTimerLibShifts, 5, 65535, &ticks);	// 65535: room for fraction tick in one compare
+			ticks = _ticks(num, (unsigned long long int) den << _uTimerLibShifts[CSMask - 1]);
+			// ticks - 1 = _overflows * 65536 + _remaining; last compare counts _remaining + 1 ticks
+			_overflows = (ticks - 1) >> 16;
+			_remaining = (ticks - 1) & 0xFFFF;
+
+			TIMSK1 &= ~((1 << TOIE1) | (1 << OCIE1A));	// Disable overflow interruption when 0 + Disable interrupt on compare match; after math, as it may count for now_ticks() meanwhile
 			__overflows = _overflows;
 			__remaining = _remaining;
-			_overflows += 1; // Fix interrupt incorrectly firing just after sei()
-			//ASSR &= ~(1<<AS3); 		// Internal clock - Unique mode for Timer3
-			TCCR3A = (1<<COM3A1);	// Normal operation
-			TCCR3B = TCCR3B & ~((1<<CS32) | (1<<CS31) | (1<<CS30)) | CSMask;	// Sets divisor
-
-			TCNT3 = 0;				// Clean timer count
-			TIMSK3 |= (1 << TOIE3);		// Enable overflow interruption when 0
-			sei();
+			TCCR1A = 0;					// Normal port operation; CTC mode, TOP = OCR1A, and divisor are set by _restart()
 		#else
-			TIMSK2 &= ~((1 << TOIE2) | (1 << OCIE2A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
-			cli();
-			// AVR, using Timer2. Counts at 16MHz
+			// AVR, using Timer2 (8 bit) in CTC mode, TOP = OCR2A
 			/*
 			Prescaler: TCCR2B; 3 last bits, CS20, CS21 and CS22
 
-			CS22	CS21	CS20	Freq		Divisor		Base Delay	Overflow delay
-			  0		  0		  0		stopped		   -		    -			    -
-			  0		  0		  1		16MHz		   1		0.0625us			   16us
-			  0		  1		  0		2MHz		   8		   0.5us			  128us
-			  0		  1		  1		500KHz		  32		     2us			  512us
-			  1		  0		  0		250KHz		  64		     4us			 1024us
-			  1		  0		  1		125KHz		 128		     8us			 2048us
-			  1		  1		  0		62.5KHz		 256		    16us			 4096us
-			  1		  1		  1		15.625KHz	1024		    64us			16384us
+			CS22	CS21	CS20	Divisor		Base Delay	Compare max delay
+			  0		  0		  0		   -		    -			    -
+			  0		  0		  1		   1		0.0625us			   16us
+			  0		  1		  0		   8		   0.5us			  128us
+			  0		  1		  1		  32		     2us			  512us
+			  1		  0		  0		  64		     4us			 1024us
+			  1		  0		  1		 128		     8us			 2048us
+			  1		  1		  0		 256		    16us			 4096us
+			  1		  1		  1		1024		    64us			16384us
+
+			Longer timings count complete 256 ticks compares in _overflows and load last one in OCR2A
 			*/
-			if (us >= 16384) {
-				CSMask = (1<<CS22) | (1<<CS21) | (1<<CS20);
-				_overflows = us / 16384;
-				_remaining = 256 - ((us % 16384) / 64 + 0.5); // + 0.5 is round for positive numbers
-			} else {
-				if (us >= 4096) {
-					CSMask = (1<<CS22) | (1<<CS21) | (1<<CS20);
-					_remaining = 256 - (us / 64 + 0.5); // + 0.5 is round for positive numbers
-				} else if (us >= 2048) {
-					CSMask = (1<<CS22) | (1<<CS21);
-					_remaining = 256 - (us / 16 + 0.5); // + 0.5 is round for positive numbers
-				} else if (us >= 1024) {
-					CSMask = (1<<CS22) | (1<<CS20);
-					_remaining = 256 - (us / 8 + 0.5); // + 0.5 is round for positive numbers
-				} else if (us >= 512) {
-					CSMask = (1<<CS22);
-					_remaining = 256 - (us / 4 + 0.5); // + 0.5 is round for positive numbers
-				} else if (us >= 128) {
-					CSMask = (1<<CS21) | (1<<CS20);
-					_remaining = 256 - (us / 2 + 0.5); // + 0.5 is round for positive numbers
-				} else if (us >= 16) {
-					CSMask = (1<<CS21);
-					_remaining = 256 - us * 2;
-				} else {
-					CSMask = (1<<CS20);
-					_remaining = 256 - (us * 16);
-				}
-				_overflows = 0;
-			}
+			CSMask = _prescale(num / den, _uTimerLibShifts, 7, 255, &ticks);	// 255: room for fraction tick in one compare
+			ticks = _ticks(num, (unsigned long long int) den << _uTimerLibShifts[CSMask - 1]);
+			// ticks - 1 = _overflows * 256 + _remaining; last compare counts _remaining + 1 ticks
+			_overflows = (ticks - 1) >> 8;
+			_remaining = (ticks - 1) & 0xFF;
 
+			TIMSK2 &= ~((1 << TOIE2) | (1 << OCIE2A));	// Disable overflow interruption when 0 + Disable interrupt on compare match; after math, as it may count for now_ticks() meanwhile
 			__overflows = _overflows;
 			__remaining = _remaining;
-			_overflows += 1; // Fix interrupt incorrectly firing just after sei()
 			ASSR &= ~(1<<AS2); 		// Internal clock
-			TCCR2A = (1<<COM2A1);	// Normal operation
-			TCCR2B = TCCR2B & ~((1<<CS22) | (1<<CS21) | (1<<CS20)) | CSMask;	// Sets divisor
-
-			TCNT2 = 0;				// Clean timer count
-			TIMSK2 |= (1 << TOIE2);		// Enable overflow interruption when 0
-			sei();
+			TCCR2A = (1<<WGM21);	// CTC mode, TOP = OCR2A; OC2A and OC2B disconnected; divisor is set by _restart()
 		#endif
+		_cs = CSMask;
+		_restart();
 	}
 
+	/**
+	 * \brief Starts counting last timing from now: reloads prescaler, counter, overflows count and interrupt
+	 *
+	 * Last step of setting up the timer, and restart(). Prescaler is set here, as now_ticks() idle count may have slowed timer down since last timing.
+	 * Timer interrupt is disabled while timing is loaded, so that needs no lock; only now_ticks() clock change is locked, as now_ticks()
+	 * from an interrupt preempting it can't wait for it to end. No loops nor waits: a few dozen instructions, about 20 of them locked
+	 * (plus a now_ticks() counter read).
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		UTIMERLIB_TIMSK &= ~(1 << UTIMERLIB_OCIE);		// Timer interrupt doesn't see timing half loaded
+		_overflows = __overflows;
+		_remaining = __remaining;
+		if (_fraction() && ++_remaining == 0) { // First period takes its fraction tick too, as next ones do on interrupt
+			_overflows++;
+		}
+		_fastPath();				// Single compare: CTC reloads it by itself
+
+		unsigned long int state = _lock(); // now_ticks() sees ticks counted so far, counter restart and new prescaler together
+		_nowFold(); // Ticks counted so far, as counter restarts
+		#if defined(UTIMERLIB_AVR_NAKED_ISR)
+			_uTimerLibSkip = 0; // Overflows left from a running timer
+			_nowSkip = 0;
+		#endif
+		UTIMERLIB_OCR = (_overflows == 0) ? _remaining : UTIMERLIB_OCR_MAX;
+		#if defined(UTIMERLIB_AVR_NAKED_ISR)
+			_skipOverflows();
+		#endif
+		UTIMERLIB_TCCRB = UTIMERLIB_TCCRB_CTC | _cs;	// Sets divisor
+		UTIMERLIB_TCNT = 0;							// Clean timer count
+		UTIMERLIB_TIFR = (1 << UTIMERLIB_OCF);			// Clear pending compare match, if any
+		_nowAcc = 0;
+		_nowShift = _uTimerLibShifts[_cs - 1] + _nowClkps;
+		_nowRun = _nowOn;
+		_nowIdling = false;
+		_unlock(state);
+
+		UTIMERLIB_TIMSK |= (1 << UTIMERLIB_OCIE);		// Enable interrupt on compare match
+		return true;
+	}
 
 	/**
-	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 * \brief Gives count after running one a new length in timer ticks; next counts too
+	 *
+	 * Only next timing is set: interrupt loads it on compare ending running count, as it does for each interval period,
+	 * and CTC restarts counter on that compare, so counts add up with no drift from interrupt latency and counter is never read.
+	 * Longer counts are split in complete compares, as set up does. Fast path is left, as it doesn't load next count.
 	 *
 	 * Note: This is device-dependant
 	 *
-	 * @param	s		Desired timing in seconds
+	 * @param	ticks	Timer ticks, see _reloadTicks()
+	 * @return	false if timer is not an interval
 	 */
-	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
-		if (s == 0) { // Not valid
-			return;
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || ticks == 0) {
+			return false;
 		}
+		unsigned long int state = _lock(); // Multi-byte __overflows and __remaining are read by interrupt
+		_fracRem = 0; // Whole ticks
+		#if defined(__AVR_ATmega32U4__) || defined(UTIMERLIB_AVR_TIMER1)
+			__overflows = (ticks - 1) >> 16;
+			__remaining = (ticks - 1) & 0xFFFF;
+		#else
+			__overflows = (ticks - 1) >> 8;
+			__remaining = (ticks - 1) & 0xFF;
+		#endif
+		_fastCb = NULL;
+		_unlock(state);
+		return true;
+	}
 
-		unsigned char CSMask = 0;
-		// For this notes, we asume 16MHz CPU. We recalculate 's' if not:
-		if (F_CPU != 16000000) {
-			s = F_CPU / 16000000 * s;
+	/**
+	 * \brief Microseconds in timer ticks of current interval prescaler, rounded, at current CPU clock
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	Timer ticks; 0 if timer is not an interval
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL) {
+			return 0;
 		}
+		unsigned char shift = _uTimerLibShifts[_cs - 1];
+		return ((unsigned long long int) us * _clockHz / 1000000 + ((1UL << shift) >> 1)) >> shift;
+	}
+
+
+
+	/**
+	 * \brief Drives pin directly from timer compare output: toggle on compare match or PWM
+	 *
+	 * Pins: OC2A and OC2B (Timer2: 11 and 3 on UNO, 10 and 9 on MEGA), OC1A and OC1B (Timer1: 9 and 10 on UNO, 11 and 12 on MEGA), OC3A (Timer3: 5 on Leonardo).
+	 * PWM: Timer2 uses OCR2A as TOP, so only OC2B can do PWM.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false if pin is not a compare output of timer used or timing doesn't fit in timer
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		uint8_t timer = digitalPinToTimer(pin);
+		unsigned long long int ticks, highTicks = 0;
+		unsigned char CSMask;
+
+		#if defined(__AVR_ATmega32U4__) || defined(UTIMERLIB_AVR_TIMER1)
+			// 16 bit timer, TOP = ICR. Toggle: CTC mode (12), output toggles when counter is 0. PWM: fast PWM mode (14)
+			CSMask = _prescale((unsigned long long int) us * _clockHz / 1000000, _uTimerLibShifts, 5, 65536, &ticks);
+			if (ticks > 65536) {
+				return false;
+			}
+			if (high > 0) {
+				_prescale((unsigned long long int) high * _clockHz / 1000000, _uTimerLibShifts + CSMask - 1, 1, 65536, &highTicks);
+			}
+		#endif
 
-		// Leonardo and other 32U4 boards
 		#ifdef __AVR_ATmega32U4__
+			if (timer != TIMER3A) {
+				return false;
+			}
+			_nowStop(); // now_ticks() pauses while timer drives pin
 			TIMSK3 &= ~((1 << TOIE3) | (1 << OCIE3A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
-			cli();
-
-			/*
-			Using longest mode from _ms function
-			CS32	CS31	CS30	Freq		Divisor		Base Delay	Overflow delay
-			  1		  0		  0		15.625KHz	1024		    64us			16384us
-			*/
-			CSMask = (1<<CS32);
-			if (_overflows > 500000) {
-				_overflows = s / 16384 * 1000000;
+			TCCR3B = 0;
+			TCNT3 = 0;
+			ICR3 = ticks - 1;
+			if (high == 0) {
+				OCR3A = 0;
+				TCCR3A = (1<<COM3A0);									// Toggle OC3A on compare match
+				TCCR3B = (1<<WGM33) | (1<<WGM32) | CSMask;				// CTC mode, TOP = ICR3 + Sets divisor
 			} else {
-				_overflows = s * 1000000 / 16384;
+				OCR3A = highTicks - 1;
+				TCCR3A = (1<<COM3A1) | (1<<WGM31);						// Non-inverting PWM on OC3A
+				TCCR3B = (1<<WGM33) | (1<<WGM32) | CSMask;				// Fast PWM mode, TOP = ICR3 + Sets divisor
 			}
-			// Original: _remaining = 256 - round(((us * 1000000) % 16384) / 64);
-			// Anti-Overflow trick:
-			if (s > 16384) {
-				unsigned long int temp = floor(s / 16384) * 16384;
-				_remaining = 256 - ((((s - temp) * 1000000) % 16384) / 64 + 0.5); // + 0.5 is round for positive numbers
+		#elif defined(UTIMERLIB_AVR_TIMER1)
+			if (timer != TIMER1A && timer != TIMER1B) {
+				return false;
+			}
+			_nowStop(); // now_ticks() pauses while timer drives pin
+			TIMSK1 &= ~((1 << TOIE1) | (1 << OCIE1A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
+			TCCR1B = 0;
+			TCNT1 = 0;
+			ICR1 = ticks - 1;
+			if (high == 0) {
+				OCR1A = 0;
+				OCR1B = 0;
+				TCCR1A = (timer == TIMER1A) ? (1<<COM1A0) : (1<<COM1B0);	// Toggle OC1x on compare match
+				TCCR1B = (1<<WGM13) | (1<<WGM12) | CSMask;				// CTC mode, TOP = ICR1 + Sets divisor
 			} else {
-				_remaining = 256 - (((s * 1000000) % 16384) / 64 + 0.5); // + 0.5 is round for positive numbers
+				OCR1A = highTicks - 1;
+				OCR1B = highTicks - 1;
+				TCCR1A = ((timer == TIMER1A) ? (1<<COM1A1) : (1<<COM1B1)) | (1<<WGM11);	// Non-inverting PWM on OC1x
+				TCCR1B = (1<<WGM13) | (1<<WGM12) | CSMask;				// Fast PWM mode, TOP = ICR1 + Sets divisor
 			}
-
-			__overflows = _overflows;
-			__remaining = _remaining;
-			_overflows += 1;
-
-			//ASSR &= ~(1<<AS3); 		// Internal clock - Unique mode for Timer3
-			TCCR3A = (1<<COM3A1);	// Normal operation
-			TCCR3B = TCCR3B & ~((1<<CS32) | (1<<CS31) | (1<<CS30)) | CSMask;	// Sets divisor
-
-			// Clean counter in normal operation, load remaining when overflows == 0
-			TCNT3 = 0;				// Clean timer count
-			TIMSK3 |= (1 << TOIE3);		// Enable overflow interruption when 0
-			sei();
-
 		#else
-			// Arduino AVR
-			TIMSK2 &= ~((1 << TOIE2) | (1 << OCIE2A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
-			cli();
-
-			/*
-			Using longest mode from _ms function
-			CS22	CS21	CS20	Freq		Divisor		Base Delay	Overflow delay
-			  1		  1		  1		15.625KHz	1024		    64us			16384us
-			*/
-			CSMask = (1<<CS22) | (1<<CS21) | (1<<CS20);
-			if (_overflows > 500000) {
-				_overflows = s / 16384 * 1000000;
-			} else {
-				_overflows = s * 1000000 / 16384;
+			// 8 bit Timer2, TOP = OCR2A. Toggle: CTC mode, OC2B toggles when counter is 0. PWM: fast PWM mode, only OC2B
+			if (timer != TIMER2A && timer != TIMER2B) {
+				return false;
 			}
-			// Original: _remaining = 256 - round(((us * 1000000) % 16384) / 64);
-			// Anti-Overflow trick:
-			if (s > 16384) {
-				unsigned long int temp = floor(s / 16384) * 16384;
-				_remaining = 256 - ((((s - temp) * 1000000) % 16384) / 64 + 0.5); // + 0.5 is round for positive numbers
-			} else {
-				_remaining = 256 - (((s * 1000000) % 16384) / 64 + 0.5); // + 0.5 is round for positive numbers
+			if (high > 0 && timer != TIMER2B) {
+				return false;
+			}
+			CSMask = _prescale((unsigned long long int) us * _clockHz / 1000000, _uTimerLibShifts, 7, 256, &ticks);
+			if (ticks > 256) {
+				return false;
+			}
+			if (high > 0) {
+				_prescale((unsigned long long int) high * _clockHz / 1000000, _uTimerLibShifts + CSMask - 1, 1, 256, &highTicks);
 			}
 
-			__overflows = _overflows;
-			__remaining = _remaining;
-			_overflows += 1;
-
+			_nowStop(); // now_ticks() pauses while timer drives pin
+			TIMSK2 &= ~((1 << TOIE2) | (1 << OCIE2A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
 			ASSR &= ~(1<<AS2); 		// Internal clock
-			TCCR2A = (1<<COM2A1);	// Normal operation
-			TCCR2B = TCCR2B & ~((1<<CS22) | (1<<CS21) | (1<<CS20)) | CSMask;	// Sets divisor
-
-			// Clean counter in normal operation, load remaining when overflows == 0
-			TCNT2 = 0;				// Clean timer count
-			TIMSK2 |= (1 << TOIE2);		// Enable overflow interruption when 0
-			sei();
+			TCCR2B = 0;
+			TCNT2 = 0;
+			OCR2A = ticks - 1;
+			if (high == 0) {
+				OCR2B = 0;
+				TCCR2A = ((timer == TIMER2A) ? (1<<COM2A0) : (1<<COM2B0)) | (1<<WGM21);	// Toggle OC2x on compare match + CTC mode, TOP = OCR2A
+				TCCR2B = CSMask;															// Sets divisor
+			} else {
+				OCR2B = highTicks - 1;
+				TCCR2A = (1<<COM2B1) | (1<<WGM21) | (1<<WGM20);							// Non-inverting PWM on OC2B + Fast PWM mode
+				TCCR2B = (1<<WGM22) | CSMask;												// TOP = OCR2A + Sets divisor
+			}
 		#endif
+		return true;
 	}
 
 
+	/**
+	 * \brief Sets up timer for input capture on pin: 16 bit timer free running at CPU clock / 8, noise canceler on
+	 *
+	 * Pins: ICP3 (Timer3: 13 on Leonardo), ICP1 when UTIMERLIB_AVR_TIMER1 is defined (Timer1: 8 on UNO; not available on MEGA headers).
+	 * Timer2 has no input capture unit.
+	 *
+	 * Capture and overflow interrupts are enabled only with UTIMERLIB_CAPTURE_HANDLER, which defines their vectors; otherwise the
+	 * sketch defines them and enables them after set up (ICIE and TOIE bits), as with no vector an interrupt would reset the board.
+	 * Other timer interrupt enable bits are kept.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false if pin is not input capture pin of timer used
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		#ifdef __AVR_ATmega32U4__
+			// ICP3 is PC7
+			if (digitalPinToPort(pin) != PC || digitalPinToBitMask(pin) != (1 << 7)) {
+				return false;
+			}
+			_nowStop(); // now_ticks() pauses while timer captures
+			TIMSK3 &= ~((1 << ICIE3) | (1 << TOIE3) | (1 << OCIE3A));
+			_cbCapture = cb;
+			_timeType = UTIMERLIB_TYPE_OFF; // Timer set up is lost for restart()
+			_overflows = 0;
+			TCCR3A = 0;																// Normal operation
+			TCCR3B = (1<<ICNC3) | ((edge == RISING) ? (1<<ICES3) : 0) | (1<<CS31);	// Noise canceler + Edge + CPU clock / 8
+			TCNT3 = 0;
+			TIFR3 = (1 << ICF3) | (1 << TOV3);		// Clear pending flags
+			#if defined(UTIMERLIB_CAPTURE_HANDLER)
+				TIMSK3 |= (1 << ICIE3) | (1 << TOIE3);	// Enable capture and overflow interrupts
+			#endif
+		#elif defined(UTIMERLIB_AVR_TIMER1)
+			// ICP1 is PB0
+			if (digitalPinToPort(pin) != PB || digitalPinToBitMask(pin) != (1 << 0)) {
+				return false;
+			}
+			_nowStop(); // now_ticks() pauses while timer captures
+			TIMSK1 &= ~((1 << ICIE1) | (1 << TOIE1) | (1 << OCIE1A));
+			_cbCapture = cb;
+			_timeType = UTIMERLIB_TYPE_OFF; // Timer set up is lost for restart()
+			_overflows = 0;
+			TCCR1A = 0;																// Normal operation
+			TCCR1B = (1<<ICNC1) | ((edge == RISING) ? (1<<ICES1) : 0) | (1<<CS11);	// Noise canceler + Edge + CPU clock / 8
+			TCNT1 = 0;
+			TIFR1 = (1 << ICF1) | (1 << TOV1);		// Clear pending flags
+			#if defined(UTIMERLIB_CAPTURE_HANDLER)
+				TIMSK1 |= (1 << ICIE1) | (1 << TOIE1);	// Enable capture and overflow interrupts
+			#endif
+		#else
+			return false;
+		#endif
+		*hz = _clockHz / 8;
+		return true;
+	}
 
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
@@ -269,29 +516,113 @@
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::_loadRemaining() {
+		UTIMERLIB_OCR = _remaining; // Counter has just restarted from 0: last compare ends _remaining + 1 ticks after previous one
+	}
+
+	/**
+	 * \brief Counts interval periods ended while callback ran, from pending compare flag, and drops them
+	 *
+	 * Called after an interval callback. CTC restarts count by itself, so a pending compare is one period
+	 * and counter is already on periods grid; more than one can't be told apart.
+	 * Intervals counting several compares are not checked: a pending one is part of next period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		if (__overflows != 0) {
+			return 0;
+		}
 		#ifdef __AVR_ATmega32U4__
-			TCNT3 = _remaining;
+			if (!(TIFR3 & (1 << OCF3A))) {
+				return 0;
+			}
+			TIFR3 = (1 << OCF3A);
+		#elif defined(UTIMERLIB_AVR_TIMER1)
+			if (!(TIFR1 & (1 << OCF1A))) {
+				return 0;
+			}
+			TIFR1 = (1 << OCF1A);
 		#else
-			TCNT2 = _remaining;
+			if (!(TIFR2 & (1 << OCF2A))) {
+				return 0;
+			}
+			TIFR2 = (1 << OCF2A);
 		#endif
+		_nowWrap(); // Count of that compare is not in next interrupt
+		return 1;
 	}
 
 	/**
 	 * \brief Clear timer interrupts
 	 *
+	 * If now_ticks() is counting, timer interrupt is kept and next one sets its idle count.
+	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
+		unsigned char generation = _cancel();
 		_type = UTIMERLIB_TYPE_OFF;
 
-		#ifdef __AVR_ATmega32U4__
-			TIMSK3 &= ~(1 << TOIE3);		// Disable overflow interruption when 0
-			SREG = (SREG & 0b01111111); // Disable interrupts without modifiying other interrupts
-		#else
-			TIMSK2 &= ~(1 << TOIE2);		// Disable overflow interruption when 0
-			SREG = (SREG & 0b01111111); // Disable interrupts without modifiying other interrupts
+		UTIMERLIB_TIMSK &= ~(1 << UTIMERLIB_OCIE);	// Disable interrupt on compare match
+		_fastCb = NULL; // Interrupt is already disabled, so it can't see it half written
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
+		#if defined(UTIMERLIB_AVR_NAKED_ISR)
+			_nowSkip -= _uTimerLibSkip; // Those left are counted by regular interrupt
+			_uTimerLibSkip = 0;
 		#endif
+		if (_nowRun) {
+			_nowIdling = true;
+			UTIMERLIB_TIMSK |= (1 << UTIMERLIB_OCIE);	// Timer goes on counting for now_ticks()
+		}
+
+		// Stop input capture
+		if (_cbCapture != NULL) {
+			#ifdef __AVR_ATmega32U4__
+				TIMSK3 &= ~((1 << ICIE3) | (1 << TOIE3));
+			#elif defined(UTIMERLIB_AVR_TIMER1)
+				TIMSK1 &= ~((1 << ICIE1) | (1 << TOIE1));
+			#endif
+			_cbCapture = NULL;
+		}
 
+		// Disconnect compare output pin and back to normal mode
+		if (_outputPin != 0xFF) {
+			#ifdef __AVR_ATmega32U4__
+				TCCR3A = 0;
+				TCCR3B &= ~((1<<WGM33) | (1<<WGM32));
+			#elif defined(UTIMERLIB_AVR_TIMER1)
+				TCCR1A = 0;
+			#else
+				TCCR2A = 0;
+				TCCR2B &= ~(1<<WGM22);
+			#endif
+			_outputPin = 0xFF;
+		}
+
+		if (_nowOn && !_nowRun) { // now_ticks() was paused
+			_nowIdle();
+		}
+	}
+
+	/**
+	 * \brief Interrupt fast path for a pure single compare interval: hardware already cleared interrupt flag
+	 *
+	 * CTC restarts count by itself on compare, so nothing is written to timer and interrupt latency doesn't add to period.
+	 * Once selected, _interrupt() state is kept as it would be after a callback, so fast path can be left at any time.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	false if timer is not in fast path, so _interrupt() has to be called
+	 */
+	inline bool uTimerLib::_fastInterrupt() {
+		void (*cb)() = _fastCb;
+		if (cb == NULL) {
+			return false;
+		}
+		cb();
+		return true;
 	}
 
 	/**
@@ -301,34 +632,177 @@
 	 * this function implements oferflow control to offer user desired timings.
 	 */
 	void uTimerLib::_interrupt() {
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
+		if (_nowIdling) { // No timing: timer only counts for now_ticks()
+			_nowIdle();
+			return;
+		}
 		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
+		// Count complete compares first (TOP at UTIMERLIB_OCR_MAX), then last one with _remaining + 1 ticks
 		if (_overflows > 0) {
 			_overflows--;
-		}
-		if (_overflows == 0 && _remaining > 0) {
-				// Load remaining count to counter
+			if (_overflows == 0) {
 				_loadRemaining();
-				// And clear remaining count
-				_remaining = 0;
-		} else if (_overflows == 0 && _remaining == 0) {
-			if (_type == UTIMERLIB_TYPE_TIMEOUT) {
-				clearTimer();
-			} else if (_type == UTIMERLIB_TYPE_INTERVAL) {
-				if (__overflows == 0) {
-					_remaining = __remaining;
-					_loadRemaining();
-					_remaining = 0;
-				} else {
-					_overflows = __overflows;
-					_remaining = __remaining;
+			}
+			#if defined(UTIMERLIB_AVR_NAKED_ISR)
+				_skipOverflows();
+			#endif
+			return;
+		}
+		if (_type == UTIMERLIB_TYPE_TIMEOUT) {
+			clearTimer();
+			generation = _current(); // Own clear, not a cancel
+		} else if (_type == UTIMERLIB_TYPE_INTERVAL) {
+			if (__overflows == 0) {
+				UTIMERLIB_OCR = __remaining + _fraction(); // One tick more each time fraction adds up to one
+			} else {
+				_overflows = __overflows;
+				_remaining = __remaining;
+				if (_fraction() && ++_remaining == 0) { // Last compare became a complete one, plus one tick
+					_overflows++;
+				}
+				UTIMERLIB_OCR = UTIMERLIB_OCR_MAX;
+				#if defined(UTIMERLIB_AVR_NAKED_ISR)
+					_skipOverflows();
+				#endif
+			}
+		}
+		_dispatch(generation);
+	}
+
+
+	/**
+	 * \brief Timer ticks counted for now_ticks() since last fold: ended counts, counter and a compare pending meanwhile
+	 *
+	 * Interrupts are masked, or now_ticks() reads it again if timer interrupt ran meanwhile (it also uses 16 bit registers TEMP byte).
+	 * Compare flag is read before and after counter: if it's set between them, counter is read again. Naked interrupt doesn't
+	 * change clock state, so its swallowed overflows are read before and after too.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Timer ticks
+	 */
+	uint64_t uTimerLib::_nowCount() {
+		#if defined(UTIMERLIB_AVR_NAKED_ISR)
+			unsigned char skip;
+			bool pending;
+			unsigned long int count;
+			do {
+				skip = _uTimerLibSkip;
+				pending = UTIMERLIB_TIFR & (1 << UTIMERLIB_OCF);
+				count = UTIMERLIB_TCNT;
+				if (!pending && (UTIMERLIB_TIFR & (1 << UTIMERLIB_OCF))) {
+					pending = true;
+					count = UTIMERLIB_TCNT;
 				}
+			} while (skip != _uTimerLibSkip);
+			count += (unsigned long int) (unsigned char) (_nowSkip - skip) * (UTIMERLIB_OCR_MAX + 1UL); // Swallowed ones
+		#else
+			bool pending = UTIMERLIB_TIFR & (1 << UTIMERLIB_OCF);
+			unsigned long int count = UTIMERLIB_TCNT;
+			if (!pending && (UTIMERLIB_TIFR & (1 << UTIMERLIB_OCF))) {
+				pending = true;
+				count = UTIMERLIB_TCNT;
 			}
-			_cb();
+		#endif
+		if (pending) { // Counter has restarted from 0
+			count += (unsigned long int) UTIMERLIB_OCR + 1;
 		}
+		return (unsigned long int) (_nowAcc + count);
 	}
 
+	/**
+	 * \brief Adds count just ended to now_ticks() clock, called on each timer compare before anything else
+	 *
+	 * Ended counts are moved to _nowBase each 2^30 ticks, long before they overflow (each 67s at 16MHz with no prescaler).
+	 *
+	 * Note: This is device-dependant
+	 */
+	inline void uTimerLib::_nowWrap() {
+		#if defined(UTIMERLIB_AVR_NAKED_ISR)
+			unsigned long int skipped = (unsigned long int) _nowSkip * (UTIMERLIB_OCR_MAX + 1UL);
+			_nowSkip = 0;
+		#endif
+		if (_nowRun) {
+			_nowAcc += (unsigned long int) UTIMERLIB_OCR + 1;
+			#if defined(UTIMERLIB_AVR_NAKED_ISR)
+				_nowAcc += skipped;
+			#endif
+			if (_nowAcc >= 0x40000000) {
+				_nowBase += _nowScale(_nowAcc);
+				_nowAcc = 0;
+			}
+		}
+		_nowSeq++;
+	}
+
+	/**
+	 * \brief Starts now_ticks() clock on its first call: on a running timing if there's one, else with idle count
+	 *
+	 * Interrupts must be masked. If timer drives a pin or captures, clock starts when they're cleared.
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::_nowStart() {
+		if (UTIMERLIB_TIMSK & (1 << UTIMERLIB_OCIE)) {
+			_nowAcc -= _nowCount();
+			_nowRun = true;
+			_nowSeq++;
+			_fastCb = NULL; // Clock counts on regular path; its state is kept as after a callback, so it's left at once
+		} else if (_type == UTIMERLIB_TYPE_OFF && _outputPin == 0xFF && _cbCapture == NULL) {
+			_nowIdle();
+		}
+	}
+
+	/**
+	 * \brief Keeps timer counting for now_ticks() when there's no timing: longest count, at UTIMERLIB_NOW_CS prescaler or slower
+	 *
+	 * A slower prescaler left by last timing is kept, so there's no clock change. Called from timer interrupt after clearTimer(),
+	 * or when timer is free again.
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::_nowIdle() {
+		unsigned long int state = _lock(); // Clock state changes together, also from timer interrupt
+		if (_nowRun && (UTIMERLIB_TCCRB & 0x07) >= UTIMERLIB_NOW_CS) {
+			UTIMERLIB_OCR = UTIMERLIB_OCR_MAX; // Counter has just restarted from 0
+		} else {
+			_nowFold();
+			UTIMERLIB_TIMSK &= ~(1 << UTIMERLIB_OCIE);
+			#if !defined(__AVR_ATmega32U4__) && !defined(UTIMERLIB_AVR_TIMER1)
+				ASSR &= ~(1<<AS2); // Internal clock
+			#endif
+			UTIMERLIB_TCCRA = UTIMERLIB_TCCRA_CTC;
+			UTIMERLIB_TCCRB = UTIMERLIB_TCCRB_CTC | UTIMERLIB_NOW_CS;
+			UTIMERLIB_OCR = UTIMERLIB_OCR_MAX;
+			UTIMERLIB_TCNT = 0;
+			UTIMERLIB_TIFR = (1 << UTIMERLIB_OCF);
+			UTIMERLIB_TIMSK |= (1 << UTIMERLIB_OCIE);
+			_nowAcc = 0;
+			_nowShift = _uTimerLibShifts[UTIMERLIB_NOW_CS - 1] + _nowClkps;
+			_nowRun = true;
+		}
+		_nowIdling = true;
+		_unlock(state);
+	}
+
+	/**
+	 * \brief Follows system clock prescaler (CLKPR) on now_ticks() clock, after ticks counted at previous one
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::_nowClock() {
+		#ifdef CLKPR
+			unsigned long int state = _lock(); // Ticks counted at previous clock are moved together with new shift
+			signed char clkps = (signed char) (CLKPR & 0x0F) - _clkpsBoot;
+			_nowFold();
+			_nowShift += clkps - _nowClkps;
+			_nowClkps = clkps;
+			_unlock(state);
+		#endif
+	}
 
 	/**
 	 * \brief Preinstantiate Object
@@ -341,20 +815,81 @@
 
 
 
+	#if defined(UTIMERLIB_AVR_NAKED_ISR)
+		#ifdef __AVR_HAVE_JMP_CALL__
+			#define UTIMERLIB_JMP "jmp "
+		#else
+			#define UTIMERLIB_JMP "rjmp "
+		#endif
+
+		/**
+		 * \brief Naked interrupt: if _uTimerLibSkip is not 0, decrements it and returns; if it is, jumps to regular interrupt
+		 *
+		 * Only r24 and SREG are used, so only they are saved. Cycles, hand counted from instruction timings (2 byte PC):
+		 *		* Swallowed: response 4 + vector jmp 3 + push 2 + in 1 + push 2 + lds 2 + subi 1 + brcs 1 + sts 2 + pop 2 + out 1 + pop 2 + reti 4 = 27
+		 *		* Due: push 2 + in 1 + push 2 + lds 2 + subi 1 + brcs 2 + pop 2 + out 1 + pop 2 + jmp 3 = 18 more than regular interrupt
+		 * Before, each swallowed overflow was a regular interrupt, about 180 cycles:
+		 *		* Entry and exit: response 4 + vector jmp 3 + prologue 32 (push r0, r1, r18-r27, r30, r31 and SREG, as it calls functions)
+		 *		  + epilogue 31 + reti 4 = 74
+		 *		* _nowWrap(): _nowRun check 4 + 32 bit _nowAcc add of OCR + 1, 24 + fold check 5 + _nowSeq++ 5 = 38
+		 *		* _interrupt() up to its overflow count: call and ret 8 + callee saved registers about 16 + generation, idling and type checks 9
+		 *		  + 32 bit _overflows decrement 24 + remaining checks and return about 10 = ~67
+		 */
+		#define UTIMERLIB_ISR(vector) \
+			extern "C" void __vector_uTimerLib(void) __attribute__ ((signal, used)); \
+			ISR(vector, ISR_NAKED) { \
+				asm volatile( \
+					"push r24\n\t" \
+					"in r24, __SREG__\n\t" \
+					"push r24\n\t" \
+					"lds r24, _uTimerLibSkip\n\t" \
+					"subi r24, 1\n\t" \
+					"brcs 1f\n\t" \
+					"sts _uTimerLibSkip, r24\n\t" \
+					"pop r24\n\t" \
+					"out __SREG__, r24\n\t" \
+					"pop r24\n\t" \
+					"reti\n" \
+					"1:\n\t" \
+					"pop r24\n\t" \
+					"out __SREG__, r24\n\t" \
+					"pop r24\n\t" \
+					UTIMERLIB_JMP "__vector_uTimerLib\n\t" \
+				); \
+			} \
+			void __vector_uTimerLib(void)
+	#else
+		#define UTIMERLIB_ISR(vector) ISR(vector)
+	#endif
+
 	/**
 	 * \brief Attach Interrupts using internal functionality
 	 *
 	 * Note: This is device-dependant
 	 */
 	#ifdef __AVR_ATmega32U4__
-		// Arduino AVR
-		ISR(TIMER3_OVF_vect) {
-			TimerLib._interrupt();
+		// Arduino AVR, Timer3
+		UTIMERLIB_ISR(TIMER3_COMPA_vect) {
+			if (!TimerLib._fastInterrupt()) {
+				TimerLib._nowWrap();
+				TimerLib._interrupt();
+			}
+		}
+	#elif defined(UTIMERLIB_AVR_TIMER1)
+		// Arduino AVR, Timer1
+		UTIMERLIB_ISR(TIMER1_COMPA_vect) {
+			if (!TimerLib._fastInterrupt()) {
+				TimerLib._nowWrap();
+				TimerLib._interrupt();
+			}
 		}
 	#else
-		// Arduino AVR
-		ISR(TIMER2_OVF_vect) {
-			TimerLib._interrupt();
+		// Arduino AVR, Timer2
+		UTIMERLIB_ISR(TIMER2_COMPA_vect) {
+			if (!TimerLib._fastInterrupt()) {
+				TimerLib._nowWrap();
+				TimerLib._interrupt();
+			}
 		}
 	#endif
 
@@ -42,19 +42,49 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
+		if (us > 0xFFFFFFFFFFFFFFFFULL / _clockHz) { // Cycles don't fit in 64 bits (days): count them from whole miliseconds
+			_attachInterrupt_cycles(us / 1000 * _clockHz, 1000);
+			return;
+		}
+		_attachInterrupt_cycles(us * _clockHz, 1000000);
+	}
 
-		unsigned char CSMask = 0;
-		// For this notes, we asume 16MHz CPU. We recalculate 'us' if not:
-		if (F_CPU != 16000000) {
-			us = F_CPU / 16000000 * us;
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	s		Desired timing in seconds
+	 */
+	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
+		if (s == 0) { // Not valid
+			return;
 		}
+		_attachInterrupt_cycles((unsigned long long int) s * _clockHz, 1);
+	}
+
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for num / den CPU cycles
+	 *
+	 * Prescaler is the smallest one that fits timing in one count, for best resolution; if none, largest one counting overflows.
+	 * Fraction of a tick left is added by _fraction() on each period.
+	 * Delays on table are for 16MHz; real ones scale with CPU clock (F_CPU, or current one after clockChanged()).
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	num		Desired timing numerator, in CPU cycles
+	 * @param	den		Desired timing denominator
+	 */
+	void uTimerLib::_attachInterrupt_cycles(unsigned long long int num, unsigned long int den) {
+		unsigned long long int ticks;
 		TIMSK &= ~((1 << TOIE0) | (1 << OCIE1A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
-		cli();
-		// Disgispark AVR, using Timer0. Counts at 16MHz (it other speed is used we recalculate us before)
+		// Disgispark AVR, using Timer0
 		/*
 		Prescaler: TCCR0B; 3 last bits, CS00, CS01 and CS02
 
@@ -66,33 +96,14 @@
 		1		  0		 0		16MHz		  256		  16us				  4096us
 		1		  0		 1		16MHz		 1024		  64us				 16384us
 		*/
-		if (us >= 16384) {
-			CSMask = (1<<CS02) | (1<<CS00);
-			_overflows = us / 16384;
-			_remaining = 256 - ((us % 16384) / 64 + 0.5); // + 0.5 is round for positive numbers
-		} else {
-			if (us >= 4096) {
-				CSMask = (1<<CS02) | (1<<CS00);
-				_remaining = 256 - (us / 64 + 0.5); // + 0.5 is round for positive numbers
-			} else if (us >= 1024) {
-				CSMask = (1<<CS02);
-				_remaining = 256 - (us / 16 + 0.5); // + 0.5 is round for positive numbers
-			} else if (us >= 128) {
-				CSMask = (1<<CS01) | (1<<CS00);
-				_remaining = 256 - (us / 4 + 0.5); // + 0.5 is round for positive numbers
-			} else if (us >= 16) {
-				CSMask = (1<<CS01);
-				_remaining = 256 - (us * 2 + 0.5); // + 0.5 is round for positive numbers
-			} else {
-				CSMask = (1<<CS00);
-				_remaining = 256 - (us * 16);
-			}
-			_overflows = 0;
-		}
+		static const unsigned char shifts[] = {0, 3, 6, 8, 10};
+		unsigned char CSMask = _prescale(num / den, shifts, 5, 256, &ticks);
+		ticks = _ticks(num, (unsigned long long int) den << shifts[CSMask - 1]);
+		_overflows = ticks >> 8;
+		_remaining = 256 - (ticks & 0xFF); // Counter preload for last count; 0 if there's none
 
 		__overflows = _overflows;
 		__remaining = _remaining;
-		_overflows += 1; // Fix interrupt incorrectly firing just after sei()
 
 		PLLCSR &= ~(1<<PCKE); 		// Internal clock
 
@@ -100,65 +111,121 @@
 		// TCCR0B |= (1 << CTC);  // clear timer on compare match
 		TCCR0B = TCCR0B & ~((1<<CS02) | (1<<CS01) | (1<<CS00)) | CSMask;	// Sets divisor
 
+		_restart();
+	}
+
+	/**
+	 * \brief Starts counting last timing from now: reloads counter, overflows count and interrupt, with timer clock already set
+	 *
+	 * Last step of setting up the timer, and restart(). Timer interrupt is disabled while counts are loaded, so no lock is needed.
+	 * No loops nor waits: a few dozen instructions.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		TIMSK &= ~(1 << TOIE0);		// Timer interrupt doesn't see counts half loaded
+		_overflows = __overflows + 1; // Fix interrupt incorrectly firing just after being enabled
+		_remaining = __remaining;
 		TCNT0 = 0;				// Clean timer count
 		TIMSK |= (1 << TOIE0);		// Enable overflow interruption when 0
-		sei();
+		return true;
 	}
 
-
 	/**
-	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 * \brief Gives running count of current interval, started on its last compare, a new length in timer ticks
+	 *
+	 * Not available on this device: counts end on overflow of a preloaded counter, so a running one can't be given an exact new length.
 	 *
 	 * Note: This is device-dependant
 	 *
-	 * @param	s		Desired timing in seconds
+	 * @param	ticks	Timer ticks
+	 * @return	false
 	 */
-	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
-		if (s == 0) { // Not valid
-			return;
-		}
-		unsigned char CSMask = 0;
-		// For this notes, we asume 16MHz CPU. We recalculate 'us' if not:
-		if (F_CPU != 16000000) {
-			s = F_CPU / 16000000 * s;
-		}
-		TIMSK &= ~((1 << TOIE0) | (1 << OCIE1A));	// Disable overflow interruption when 0 + Disable interrupt on compare match
-		cli();
-		// Disgispark AVR, using Timer0. Counts at 16MHz (it other speed is used we recalculate us before)
-		/*
-		Prescaler: TCCR0B; 4 last bits, CS00, CS01, CS02 and CS03
-
-		CS02	CS01	CS00	Freq		Divisor		Base Delay		Overflow delay
-		1		  0		 1		16MHz		 1024		  64us				 16384us
-		*/
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		return false;
+	}
 
-		CSMask = (1<<CS02) | (1<<CS00);
-		_overflows = s * 1000000 / 16384;
-		_remaining = 256 - (((s * 1000000) % 16384) / 64 + 0.5); // + 0.5 is round for positive numbers
+	/**
+	 * \brief Microseconds in timer ticks of current interval prescaler
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	0, counts can't be reloaded
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		return 0;
+	}
 
-		__overflows = _overflows;
-		__remaining = _remaining;
 
-		PLLCSR &= ~(1<<PCKE); 		// Internal clock
-		//		TCCR0A = (1 << WGM01);             //CTC mode
-		// Al 1 except one, so simplify to next line...  TCCR0B = TCCR0B & ~((1<<CS02) | (1<<CS01) | (1<<CS00)) | CSMask;	// Sets divisor
-		TCCR0B = TCCR0B & ~(1<<CS01) | CSMask;	// Sets divisor
 
-		// Clean counter in normal operation, load remaining when overflows == 0
-		TCNT0 = 0;				// Clean timer count
-		TIMSK |= (1 << TOIE0);		// Enable overflow interruption when 0
-		sei();
+	/**
+	 * \brief Drives pin directly from timer compare output
+	 *
+	 * Not available on this device: timer compare output pins are not routed yet.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false, so pin is toggled by interrupt
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		return false;
 	}
 
 
+	/**
+	 * \brief Sets up timer for input capture on pin
+	 *
+	 * Not available on this device: Timer0 has no input capture unit.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		return false;
+	}
 
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
 	 *
+	 * Preload is added to ticks counted since overflow, so interrupt latency doesn't lengthen last count.
+	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::_loadRemaining() {
-		TCNT0 = _remaining;
+		TCNT0 += _remaining;
+	}
+
+	/**
+	 * \brief Counts interval periods ended while callback ran, from pending overflow flag and counter, and drops them
+	 *
+	 * Called after an interval callback. Counter has no preload while overflow is pending, so its value is time since that period end:
+	 * whole periods in it are missed too, and its remainder is kept when preload is loaded, so next interrupt stays on periods grid.
+	 * Intervals counting several overflows are not checked: a pending one is part of next period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		if (__overflows != 0 || !(TIFR & (1 << TOV0))) {
+			return 0;
+		}
+		unsigned char period = 0 - __remaining; // Preload is 256 - period
+		unsigned char ticks = TCNT0;
+		TCNT0 += __remaining - ticks / period * period; // Ticks counted from read to write are kept
+		TIFR = (1 << TOV0);
+		return 1 + ticks / period;
 	}
 
 	/**
@@ -167,9 +234,11 @@
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
+		unsigned char generation = _cancel();
 		_type = UTIMERLIB_TYPE_OFF;
 
 		TIMSK &= ~(1 << TOIE0);		// Disable overflow interruption when 0
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
 //		SREG = (SREG & 0b01111111); // Disable interrupts without modifiying other interrupts
 
 	}
@@ -181,6 +250,7 @@
 	 * this function implements oferflow control to offer user desired timings.
 	 */
 	void uTimerLib::_interrupt() {
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
 		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
@@ -195,17 +265,21 @@
 		} else if (_overflows == 0 && _remaining == 0) {
 			if (_type == UTIMERLIB_TYPE_TIMEOUT) {
 				clearTimer();
+				generation = _current(); // Own clear, not a cancel
 			} else if (_type == UTIMERLIB_TYPE_INTERVAL) {
 				if (__overflows == 0) {
-					_remaining = __remaining;
+					_remaining = __remaining - _fraction(); // One tick more each time fraction adds up to one: start count one lower
 					_loadRemaining();
 					_remaining = 0;
 				} else {
 					_overflows = __overflows;
 					_remaining = __remaining;
+					if (_fraction() && --_remaining == 0) { // Last count became a complete one
+						_overflows++;
+					}
 				}
 			}
-			_cb();
+			_dispatch(generation);
 		}
 	}
 
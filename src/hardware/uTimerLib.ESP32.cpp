@@ -41,17 +41,88 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
-		clearTimer();
 		__overflows = _overflows = __remaining = _remaining = 0;
-		 const esp_timer_create_args_t timer_args = {
-			.callback = (esp_timer_cb_t) &uTimerLib::interrupt
-		};
-		esp_timer_create(&timer_args, &_timer);
-		esp_timer_start_periodic(_timer, us);
+		_timerUs = us;
+		_reloadUs = 0;
+		esp_timer_handle_t timer = _timer;
+		if (timer == NULL) { // First use
+			 const esp_timer_create_args_t timer_args = {
+				.callback = (esp_timer_cb_t) &uTimerLib::interrupt,
+				.arg = this
+			};
+			esp_timer_create(&timer_args, &timer);
+			esp_timer_handle_t created = NULL;
+			if (!__atomic_compare_exchange_n(&_timer, &created, timer, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) { // Other core created it meanwhile
+				esp_timer_delete(timer);
+			}
+		}
+		_restart();
+	}
+
+
+	/**
+	 * \brief Starts counting last timing from now: stops esp_timer and starts it again, with no allocation
+	 *
+	 * Last step of setting up the timer, and restart(). esp_timer is already created, as a timing has been set.
+	 * Timeouts are one shot, so esp_timer stops by itself and _interrupt() doesn't have to stop it.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		esp_timer_handle_t timer = _timer;
+		if (timer == NULL) { // Not created: no memory
+			return true;
+		}
+		esp_timer_stop(timer); // Error if it isn't running, nothing to stop then
+		if (_reloadUs != 0) { // Period from _reload() starts now
+			_timerUs = _reloadUs;
+			_reloadUs = 0;
+		}
+		if (_type == UTIMERLIB_TYPE_TIMEOUT) {
+			esp_timer_start_once(timer, _timerUs);
+		} else {
+			esp_timer_start_periodic(timer, _timerUs);
+		}
+		return true;
+	}
+
+	/**
+	 * \brief Gives period after running one a new length in timer ticks (microseconds); next periods too
+	 *
+	 * esp_timer has no compare to reload: it's started again on running period end, from _interrupt(), so callback latency adds up.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	ticks	Microseconds
+	 * @return	false if timer is not an interval
+	 */
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || ticks == 0) {
+			return false;
+		}
+		_reloadUs = ticks;
+		return true;
+	}
+
+	/**
+	 * \brief Microseconds in timer ticks of esp_timer: microseconds too
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	Timer ticks; 0 if timer is not an interval
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL) {
+			return 0;
+		}
+		return us;
 	}
 
 
@@ -66,17 +137,45 @@
 		if (s == 0) { // Not valid
 			return;
 		}
-		clearTimer();
-		__overflows = _overflows = __remaining = _remaining = 0;
-		 const esp_timer_create_args_t timer_args = {
-			.callback = (esp_timer_cb_t) &uTimerLib::interrupt
-		};
-		esp_timer_create(&timer_args, &_timer);
-		esp_timer_start_periodic(_timer, s * 1000000);
+		_attachInterrupt_us((unsigned long long int) s * 1000000);
 	}
 
 
 
+	/**
+	 * \brief Drives pin directly from timer compare output
+	 *
+	 * Not available on this device: esp_timer is a software timer with no output pin.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false, so pin is toggled by interrupt
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		return false;
+	}
+
+
+	/**
+	 * \brief Sets up timer for input capture on pin
+	 *
+	 * Not available on this device: esp_timer is a software timer with no input capture.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		return false;
+	}
+
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
 	 *
@@ -84,18 +183,42 @@
 	 */
 	void uTimerLib::_loadRemaining() { }
 
+	/**
+	 * \brief Counts interval periods ended while callback ran, from esp_timer time, and drops them
+	 *
+	 * Called after an interval callback. esp_timer would run missed periods late, back to back, so it's started again from now.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		unsigned long int state = _lock(); // 64 bits, written by esp_timer task while dispatch may run on other core
+		int64_t fireTime = _fireTime;
+		_unlock(state);
+		unsigned long int missed = (esp_timer_get_time() - fireTime) / _timerUs;
+		if (missed > 0) {
+			_restart();
+		}
+		return missed;
+	}
+
 	/**
 	 * \brief Clear timer interrupts
 	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
-		if (_timer) {
-			esp_timer_stop(_timer);
-			esp_timer_delete(_timer);
-			_type = UTIMERLIB_TYPE_OFF;
-			_timer = NULL;
+		unsigned long int state = _lock(); // _interrupt() on other core reads both together
+		unsigned char generation = _cancel();
+		_type = UTIMERLIB_TYPE_OFF;
+		_unlock(state);
+		// Timer is kept for next use; esp_timer_stop can be called from both cores or the callback at same time
+		esp_timer_handle_t timer = _timer;
+		if (timer) {
+			esp_timer_stop(timer); // A running callback is not affected; it's cancelled by _generation
 		}
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
 	}
 	/**
 	 * \brief Internal intermediate function to control timer interrupts
@@ -104,13 +227,91 @@
 	 * this function implements oferflow control to offer user desired timings.
 	 */
 	void uTimerLib::_interrupt() {
-		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
+		// Other core may clear or set timer meanwhile: type and generation are read, a timeout cleared and fire time set, in one critical section
+		unsigned long int state = _lock();
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
+		unsigned char type = _type;
+		if (type == UTIMERLIB_TYPE_TIMEOUT) { // One shot esp_timer, already stopped
+			generation = _cancel(); // Own clear, not a cancel
+			_type = UTIMERLIB_TYPE_OFF;
+		}
+		_fireTime = esp_timer_get_time(); // Read by _missed() on dispatch core, so it's not torn
+		_unlock(state);
+		if (type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
-		if (_type == UTIMERLIB_TYPE_TIMEOUT) {
-			clearTimer();
+		if (type == UTIMERLIB_TYPE_TIMEOUT) {
+			_trace(UTIMERLIB_TRACE_CANCEL, generation);
+		}
+		if (type == UTIMERLIB_TYPE_INTERVAL && _reloadUs != 0) {
+			_restart();
+		}
+		_dispatch(generation);
+	}
+
+
+	/**
+	 * \brief Pins callback (or task notification) to a core, so it never migrates or contends with the other core
+	 *
+	 * esp_timer runs its callbacks in its own task, on core 0. With a core set, it only wakes a dispatch task
+	 * pinned to that core, which calls callback. E.g. a 10kHz control loop on core 1 while WiFi runs on core 0.
+	 * Dispatch tasks are created on first use and kept. It's kept for next setXXX calls.
+	 *
+	 * If dispatch task is late, e.g. callback takes longer than period, ticks ended meanwhile are all taken on next run:
+	 * with no overrun policy callback is called once per tick; with one they're overruns (see setOverrunPolicy).
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	core		Core to run callback on, 0 or 1; tskNO_AFFINITY to go back to esp_timer task
+	 * @param	priority	Dispatch task priority; highest by default
+	 * @return	false if core is not valid or dispatch task can't be created
+	 */
+	bool uTimerLib::setCore(BaseType_t core, UBaseType_t priority) {
+		if (core == tskNO_AFFINITY) {
+			_coreTask = NULL;
+			return true;
+		}
+		if (core < 0 || core >= portNUM_PROCESSORS) {
+			return false;
+		}
+		if (_coreTasks[core] == NULL) {
+			if (xTaskCreatePinnedToCore(uTimerLib::_coreLoop, "uTimerLib", UTIMERLIB_ESP32_CORE_STACK, this, priority, &_coreTasks[core], core) != pdPASS) {
+				_coreTasks[core] = NULL;
+				return false;
+			}
+		} else {
+			vTaskPrioritySet(_coreTasks[core], priority);
+		}
+		_coreTask = _coreTasks[core];
+		return true;
+	}
+
+	/**
+	 * \brief Dispatch task pinned to a core: waits for timer ticks and dispatches them
+	 *
+	 * Ticks are counted on hand-off (_corePending), not from notification count, so ticks of a cleared timer
+	 * are not dispatched on the new one. One run takes all of them: first is dispatched, the others as late.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	arg		uTimerLib instance
+	 */
+	void uTimerLib::_coreLoop(void *arg) {
+		uTimerLib *timer = (uTimerLib *) arg;
+		for (;;) {
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			if (timer->_coreTask != xTaskGetCurrentTaskHandle()) {
+				continue;
+			}
+			unsigned long int state = _lock();
+			unsigned char generation = timer->_coreGeneration;
+			unsigned long int ticks = timer->_corePending;
+			timer->_corePending = 0;
+			_unlock(state);
+			if (ticks > 0) { // Else already taken on a previous notification
+				timer->_dispatch(generation, ticks - 1);
+			}
 		}
-		_cb();
 	}
 
 
@@ -128,7 +329,7 @@
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::interrupt(void* arg) {
-		TimerLib._interrupt();
+		((uTimerLib *) arg)->_interrupt();
 	}
 
 #endif
@@ -34,6 +34,11 @@
 	#define _uTimerLib_IMP_
 	#include "uTimerLib.cpp"
 
+	/**
+	 * \brief Longest period armed on os_timer, in miliseconds (SDK limit is 6870947); longer ones are counted in periods of this
+	 */
+	#define UTIMERLIB_ESP8266_MAX_MS 3600000
+
 
 	/**
 	 * \brief Sets up the timer, calculation variables and interrupts for desired ms microseconds
@@ -42,16 +47,67 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
-		unsigned long int ms = (us / 1000) + 0.5;
+		unsigned long long int ms = (us + 500) / 1000; // +500 is same as round
 		if (ms == 0) {
 			ms = 1;
 		}
-		__overflows = _overflows = __remaining = _remaining = 0;
-		_ticker.attach_ms(ms, uTimerLib::interrupt);
+		if (ms <= UTIMERLIB_ESP8266_MAX_MS) {
+			__overflows = __remaining = 0;
+			_tickerMs = ms;
+		} else { // Longer than os_timer can arm: count complete periods, then last one
+			__overflows = ms / UTIMERLIB_ESP8266_MAX_MS;
+			__remaining = ms % UTIMERLIB_ESP8266_MAX_MS;
+			_tickerMs = UTIMERLIB_ESP8266_MAX_MS;
+		}
+		_restart();
+	}
+
+
+	/**
+	 * \brief Starts counting last timing from now: arms Ticker again and resets periods count
+	 *
+	 * Last step of setting up the timer, and restart(). No loops nor waits: an os_timer disarm and arm.
+	 * No lock: Ticker callbacks run in system task, which neither preempts nor is preempted by loop(), so interrupt can't see it half done.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		_overflows = __overflows;
+		_remaining = __remaining;
+		_ticker.attach_ms(_tickerMs, uTimerLib::interrupt);
+		return true;
+	}
+
+	/**
+	 * \brief Gives running count of current interval, started on its last compare, a new length in timer ticks
+	 *
+	 * Not available on this device: Ticker has millisecond resolution.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	ticks	Timer ticks
+	 * @return	false
+	 */
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		return false;
+	}
+
+	/**
+	 * \brief Microseconds in timer ticks of current interval prescaler
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	0, counts can't be reloaded
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		return 0;
 	}
 
 
@@ -67,12 +123,45 @@
 			return;
 		}
 
-		__overflows = _overflows = __remaining = _remaining = 0;
-		_ticker.attach(s, uTimerLib::interrupt);
+		_attachInterrupt_us((unsigned long long int) s * 1000000);
 	}
 
 
 
+	/**
+	 * \brief Drives pin directly from timer compare output
+	 *
+	 * Not available on this device: Ticker is a software timer with no output pin.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false, so pin is toggled by interrupt
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		return false;
+	}
+
+
+	/**
+	 * \brief Sets up timer for input capture on pin
+	 *
+	 * Not available on this device: Ticker is a software timer with no input capture.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		return false;
+	}
+
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
 	 *
@@ -80,13 +169,37 @@
 	 */
 	void uTimerLib::_loadRemaining() { }
 
+	/**
+	 * \brief Counts interval periods ended while callback ran, from micros64(), and drops them
+	 *
+	 * Called after an interval callback. Ticker is armed again from now, so next period is a whole one.
+	 * Intervals longer than UTIMERLIB_ESP8266_MAX_MS, counting several periods, are not checked.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		if (__overflows != 0) {
+			return 0;
+		}
+		unsigned long int missed = (micros64() - _fireTime) / (_tickerMs * 1000);
+		if (missed > 0) {
+			_restart();
+		}
+		return missed;
+	}
+
 	/**
 	 * \brief Clear timer interrupts
 	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
+		unsigned char generation = _cancel();
+		_type = UTIMERLIB_TYPE_OFF;
 		_ticker.detach();
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
 	}
 
 	/**
@@ -96,13 +209,33 @@
 	 * this function implements oferflow control to offer user desired timings.
 	 */
 	void uTimerLib::_interrupt() {
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
 		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
+		if (_overflows > 0) { // Long timing, counting complete periods
+			_overflows--;
+			if (_overflows > 0) {
+				return;
+			}
+			if (_remaining > 0) { // Last one
+				_ticker.attach_ms(_remaining, uTimerLib::interrupt);
+				_remaining = 0;
+				return;
+			}
+		}
 		if (_type == UTIMERLIB_TYPE_TIMEOUT) {
 			clearTimer();
+			generation = _current(); // Own clear, not a cancel
+		} else if (__overflows > 0) {
+			_overflows = __overflows;
+			_remaining = __remaining;
+			if (_remaining > 0) { // Back from last one
+				_ticker.attach_ms(UTIMERLIB_ESP8266_MAX_MS, uTimerLib::interrupt);
+			}
 		}
-		_cb();
+		_fireTime = micros64();
+		_dispatch(generation);
 	}
 
 
@@ -45,7 +45,7 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
@@ -80,28 +80,93 @@
 		For simplify things, we'll use always TC_CMR_TCCLKS_TIMER_CLOCK32,as has enougth resolution for us.
 		*/
 
-		if (us > 1636178017) {
-			__overflows = _overflows = us / 1636178017.523809524;
-			__remaining = _remaining = (us - (1636178017.523809524 * _overflows)) / 0.380952381 + 0.5; // +0.5 is same as round
-		} else {
-			__overflows = _overflows = 0;
-			__remaining = _remaining = (us / 0.380952381 + 0.5); // +0.5 is same as round
+		// 2.625 ticks each us, in 64 bits so weeks don't overflow; complete 32 bit counts in _overflows
+		unsigned long long int ticks = (us * 21 + 4) / 8; // +4 is same as round
+		if (ticks == 0) {
+			ticks = 1;
 		}
+		__overflows = ticks >> 32;
+		__remaining = ticks & 0xFFFFFFFF;
+		_nowStop(); // TC_Configure stops counter: now_ticks() pauses until _restart()
 		pmc_set_writeprotect(false); // Enable write
 		pmc_enable_periph_clk(ID_TC3); // Enable TC1 - channel 0 peripheral
 		TC_Configure(TC1, 0, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK3); // Configure clock; prescaler = 32
+		_restart();
+	}
 
+	/**
+	 * \brief Starts counting last timing from now: reloads compare value, overflows count and interrupt, with timer clock already set
+	 *
+	 * Last step of setting up the timer, and restart(). No loops nor waits: some register writes.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		unsigned long int state = _lock(); // Timer interrupt, and now_ticks() from others, see timing and clock reloaded together
+		_nowFold(); // Ticks counted so far, as counter restarts
+		_overflows = __overflows;
+		_remaining = __remaining;
 		if (__overflows == 0) {
 			_loadRemaining();
 			_remaining = 0;
 		} else {
 			TC_SetRC(TC1, 0, 4294967295); // Int on last number
 		}
+		_fastPath();
 
-		TC_Start(TC1, 0);
+		TC_Start(TC1, 0);						// Counter is reset by software trigger
+		TC_GetStatus(TC1, 0);					// Clear pending compare, if any
+		NVIC_ClearPendingIRQ(TC3_IRQn);
 		TC1->TC_CHANNEL[0].TC_IER = TC_IER_CPCS;
 		TC1->TC_CHANNEL[0].TC_IDR = ~TC_IER_CPCS;
 		NVIC_EnableIRQ(TC3_IRQn);
+
+		_nowAcc = 0;
+		_nowRun = _nowOn;
+		_nowIdling = false;
+		_unlock(state);
+		return true;
+	}
+
+	/**
+	 * \brief Gives count after running one a new length in timer ticks; next counts too
+	 *
+	 * Only next timing is set: interrupt loads RC on compare ending running count, as it does for each interval period,
+	 * and RC compare restarts counter, so counts add up with no drift from interrupt latency and counter is never read.
+	 * Fast path is left, as it doesn't load next count.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	ticks	Timer ticks, see _reloadTicks()
+	 * @return	false if timer is not an interval
+	 */
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || ticks == 0) {
+			return false;
+		}
+		unsigned long int state = _lock(); // __overflows and __remaining are read together by interrupt
+		__overflows = 0;
+		__remaining = ticks;
+		_fastCb = NULL;
+		_unlock(state);
+		return true;
+	}
+
+	/**
+	 * \brief Microseconds in timer ticks of current interval prescaler, rounded (MCK / 32 at 84MHz, as set up)
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	Timer ticks; 0 if timer is not an interval
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL) {
+			return 0;
+		}
+		return ((unsigned long long int) us * 21 + 4) / 8; // +4 is same as round
 	}
 
 
@@ -116,60 +181,130 @@
 		if (s == 0) { // Not valid
 			return;
 		}
+		_attachInterrupt_us((unsigned long long int) s * 1000000);
+	}
 
-		/*
-		See _ms functions for detailed info; here only selected points
-
-				Name				Prescaler	Freq	Base Delay		Overflow delay
-		TC_CMR_TCCLKS_TIMER_CLOCK4	128		656.25KHz	1,523809524us	6544712070,913327104us, 6544,712070913327104s
 
-		For simplify things, we'll use always TC_CMR_TCCLKS_TIMER_CLOCK32,as has enougth resolution for us.
-		*/
-		if (s > 6544) {
-			__overflows = _overflows = s / 6544.712070913327104;
-			__remaining = _remaining = (s - (6544.712070913327104 * _overflows) / 0.000001523809524 + 0.5); // +0.5 is same as round
-		} else {
-			__overflows = _overflows = 0;
-			__remaining = _remaining = (s / 0.000001523809524 + 0.5); // +0.5 is same as round
-		}
-
-		pmc_set_writeprotect(false); // Enable write
-		//pmc_enable_periph_clk((uint32_t) TC3_IRQn); // Enable TC1 - channel 0 peripheral
-		pmc_enable_periph_clk(ID_TC3); // Enable TC1 - channel 0 peripheral
-		TC_Configure(TC1, 0, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK4); // Configure clock; prescaler = 128
+	/**
+	 * \brief Drives pin directly from timer compare output
+	 *
+	 * Not available on this device: TC3 (TC1 channel 0) TIOA3/TIOB3 pins are not available on Arduino Due headers.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false, so pin is toggled by interrupt
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		return false;
+	}
 
-		if (__overflows == 0) {
-			_loadRemaining();
-			_remaining = 0;
-		} else {
-			TC_SetRC(TC1, 0, 4294967295); // Int on last number
-		}
 
-		TC1->TC_CHANNEL[0].TC_IER=TC_IER_CPCS;
-		TC1->TC_CHANNEL[0].TC_IDR=~TC_IER_CPCS;
-		NVIC_EnableIRQ(TC3_IRQn);
-		TC_Start(TC1, 0);
+	/**
+	 * \brief Sets up timer for input capture on pin
+	 *
+	 * Not available on this device: TC3 (TC1 channel 0) TIOA3 pin is not available on Arduino Due headers.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		return false;
 	}
 
-
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
 	 *
+	 * Counter restarts on RC compare, so a count lasts RC + 1 ticks: _remaining (at least 1) ticks is RC = _remaining - 1.
+	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::_loadRemaining() {
-		TC_SetRC(TC1, 0, _remaining);
+		TC_SetRC(TC1, 0, _remaining - 1);
+	}
+
+	/**
+	 * \brief Counts interval periods ended while callback ran, from pending RC compare flag, and drops them
+	 *
+	 * Called after an interval callback. RC compare restarts count by itself, so counter is already on periods grid;
+	 * hardware has one pending flag, so a callback longer than two periods is counted as one missed period.
+	 * Intervals counting several compares are not checked: a pending one is part of next period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		if (__overflows != 0 || !(TC_GetStatus(TC1, 0) & TC_SR_CPCS)) { // Reading status clears it
+			return 0;
+		}
+		NVIC_ClearPendingIRQ(TC3_IRQn);
+		_nowWrap(); // Count of that compare is not in next interrupt
+		return 1;
+	}
+
+	/**
+	 * \brief Sets timer interrupt NVIC priority, so it can preempt communication stacks (USB, SERCOM...) or be preempted by them
+	 *
+	 * It's kept for next setXXX calls. With UTIMERLIB_BASEPRI, library critical sections only mask up to this priority.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	priority	NVIC priority, 0 is highest; up to 15
+	 */
+	void uTimerLib::setPriority(uint8_t priority) {
+		if (priority >= (1 << __NVIC_PRIO_BITS)) {
+			priority = (1 << __NVIC_PRIO_BITS) - 1;
+		}
+		_priority = priority;
+		NVIC_SetPriority(TC3_IRQn, priority);
 	}
 
 	/**
 	 * \brief Clear timer interrupts
 	 *
+	 * If now_ticks() is counting, interrupt is kept and next one sets its idle count.
+	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
+		unsigned char generation = _cancel();
 		_type = UTIMERLIB_TYPE_OFF;
 
-        NVIC_DisableIRQ(TC3_IRQn);
+		if (_nowRun) {
+			_nowIdling = true; // Timer goes on counting for now_ticks()
+		} else {
+			NVIC_DisableIRQ(TC3_IRQn);
+		}
+		_fastCb = NULL;
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
+
+		if (_nowOn && !_nowRun) { // now_ticks() was paused
+			_nowIdle();
+		}
+	}
+
+	/**
+	 * \brief Interrupt fast path for a pure single compare interval: RC compare reloads by itself
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	false if timer is not in fast path, so _interrupt() has to be called
+	 */
+	inline bool uTimerLib::_fastInterrupt() {
+		void (*cb)() = _fastCb;
+		if (cb == NULL) {
+			return false;
+		}
+		cb();
+		return true;
 	}
 
 	/**
@@ -179,6 +314,11 @@
 	 * this function implements oferflow control to offer user desired timings.
 	 */
 	void uTimerLib::_interrupt() {
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
+		if (_nowIdling) { // No timing: timer only counts for now_ticks()
+			_nowIdle();
+			return;
+		}
 		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
@@ -194,6 +334,7 @@
 		} else if (_overflows == 0 && _remaining == 0) {
 			if (_type == UTIMERLIB_TYPE_TIMEOUT) {
 				clearTimer();
+				generation = _current(); // Own clear, not a cancel
 			} else if (_type == UTIMERLIB_TYPE_INTERVAL) {
 				if (__overflows == 0) {
 					_remaining = __remaining;
@@ -206,13 +347,94 @@
 					TC_SetRC(TC1, 0, 4294967295);
 				}
 			}
-			_cb();
+			_dispatch(generation);
 		} else if (_overflows > 0) { // Reload for SAM
 			TC_SetRC(TC1, 0, 4294967295);
 		}
 	}
 
 
+	/**
+	 * \brief Timer ticks counted for now_ticks() since last fold: ended counts, counter and a compare pending meanwhile
+	 *
+	 * Interrupts are masked, or now_ticks() reads it again if timer interrupt ran meanwhile. Status register clears compare flag
+	 * when read, so pending interrupt is checked before and after counter instead: if it's set between them, counter is read again.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Timer ticks
+	 */
+	uint64_t uTimerLib::_nowCount() {
+		bool pending = NVIC_GetPendingIRQ(TC3_IRQn);
+		uint64_t count = TC1->TC_CHANNEL[0].TC_CV;
+		if (!pending && NVIC_GetPendingIRQ(TC3_IRQn)) {
+			pending = true;
+			count = TC1->TC_CHANNEL[0].TC_CV;
+		}
+		if (pending) { // Counter has restarted from 0
+			count += (uint64_t) TC1->TC_CHANNEL[0].TC_RC + 1;
+		}
+		return _nowAcc + count;
+	}
+
+	/**
+	 * \brief Adds count just ended to now_ticks() clock, called on each RC compare before anything else, while RC is still the one of that count
+	 *
+	 * Note: This is device-dependant
+	 */
+	inline void uTimerLib::_nowWrap() {
+		if (_nowRun) {
+			_nowAcc += (uint64_t) TC1->TC_CHANNEL[0].TC_RC + 1;
+		}
+		_nowSeq++;
+	}
+
+	/**
+	 * \brief Starts now_ticks() clock on its first call: on a running timing if there's one, else with idle count
+	 *
+	 * Interrupts must be masked.
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::_nowStart() {
+		if (_type != UTIMERLIB_TYPE_OFF) {
+			_nowAcc -= _nowCount();
+			_nowRun = true;
+			_nowSeq++;
+			_fastCb = NULL; // Clock counts on regular path; its state is kept as after a callback, so it's left at once
+		} else {
+			_nowIdle();
+		}
+	}
+
+	/**
+	 * \brief Keeps timer counting for now_ticks() when there's no timing: longest count (1636s)
+	 *
+	 * Called from timer interrupt after clearTimer(), or on first now_ticks() call with no timing.
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::_nowIdle() {
+		unsigned long int state = _lock(); // Clock state changes together, also from timer interrupt
+		TC_SetRC(TC1, 0, 4294967295); // Called from interrupt, counter has just restarted from 0
+		if (!_nowRun) {
+			pmc_set_writeprotect(false); // Enable write
+			pmc_enable_periph_clk(ID_TC3); // Enable TC1 - channel 0 peripheral
+			TC_Configure(TC1, 0, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK3); // Same clock as timings: prescaler = 32
+			TC_Start(TC1, 0);
+			TC_GetStatus(TC1, 0);
+			NVIC_ClearPendingIRQ(TC3_IRQn);
+			TC1->TC_CHANNEL[0].TC_IER = TC_IER_CPCS;
+			TC1->TC_CHANNEL[0].TC_IDR = ~TC_IER_CPCS;
+			NVIC_EnableIRQ(TC3_IRQn);
+			_nowAcc = 0;
+			_nowRun = true;
+			_nowSeq++;
+		}
+		_nowIdling = true;
+		_unlock(state);
+	}
+
 	/**
 	 * \brief Preinstantiate Object
 	 *
@@ -228,7 +450,13 @@
 	 * Note: This is device-dependant
 	 */
 	void TC3_Handler() {
-		TC_GetStatus(TC1, 0); // reset interrupt
+		uint32_t status = TC_GetStatus(TC1, 0); // Reading status resets interrupt
+		if (TimerLib._fastInterrupt()) {
+			return;
+		}
+		if (status & TC_SR_CPCS) {
+			TimerLib._nowWrap();
+		}
 		TimerLib._interrupt();
 	}
 
@@ -33,6 +33,39 @@
 #ifndef _uTimerLib_IMP_
 	#define _uTimerLib_IMP_
 	#include "uTimerLib.cpp"
+	#include "wiring_private.h"
+
+	/**
+	 * \brief Timer prescalers as powers of 2, by PRESCALER field value
+	 */
+	static const unsigned char _uTimerLibShifts[] = {0, 1, 2, 3, 4, 6, 8, 10};
+
+	/**
+	 * \brief Most a continuously synchronized COUNT read lags behind counter, in GCLK0 cycles (TC3 input clock, before its prescaler)
+	 *
+	 * Clock domain synchronization delay is below 6 GCLK_TC cycles plus 3 APB cycles (datasheet, GCLK synchronization), and APBC
+	 * runs from GCLK0 undivided. At prescaler 2^shift it's (9 >> shift) whole timer ticks, plus one for a tick partly gone.
+	 */
+	#define UTIMERLIB_SAMD21_READ_LAG (6 + 3)
+
+	/**
+	 * \brief TC3 has been set up (its clock enabled), so now_ticks() idle count keeps its mode, with no synchronization wait
+	 */
+	static bool _uTimerLibSetUp = false;
+
+	/**
+	 * \brief Keeps TC3 counter continuously synchronized, so now_ticks() reads it with no wait; last step of each set up, waited for
+	 *
+	 * Input capture keeps CC0 synchronized instead, so each captured value is read fresh from interrupt (now_ticks() is paused meanwhile).
+	 *
+	 * @param	tc		Timer
+	 * @param	address	Register offset to keep synchronized: COUNT, or CC0 for input capture
+	 */
+	static inline void _uTimerLibReadContinuous(TcCount16 *tc, uint8_t address = TC_COUNT16_COUNT_OFFSET) {
+		tc->READREQ.reg = TC_READREQ_RREQ | TC_READREQ_RCONT | TC_READREQ_ADDR(address);
+		while (tc->STATUS.bit.SYNCBUSY == 1); // sync
+		_uTimerLibSetUp = true;
+	}
 
 
 	/**
@@ -42,11 +75,45 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
+		if (us > 0xFFFFFFFFFFFFFFFFULL / F_CPU) { // Cycles don't fit in 64 bits (days): count them from whole miliseconds
+			_attachInterrupt_cycles(us / 1000 * F_CPU, 1000);
+			return;
+		}
+		_attachInterrupt_cycles(us * F_CPU, 1000000);
+	}
 
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	s		Desired timing in seconds
+	 */
+	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
+		if (s == 0) { // Not valid
+			return;
+		}
+		_attachInterrupt_cycles((unsigned long long int) s * F_CPU, 1);
+	}
+
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for num / den GCLK_TC cycles
+	 *
+	 * Prescaler is the smallest one that fits timing in one compare, for best resolution; if none, largest one counting overflows.
+	 * Fraction of a tick left is added by _fraction() on each period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	num		Desired timing numerator, in GCLK_TC cycles
+	 * @param	den		Desired timing denominator
+	 */
+	void uTimerLib::_attachInterrupt_cycles(unsigned long long int num, unsigned long int den) {
 		/*
 		16 bit timer
 
@@ -73,21 +140,14 @@
 			freq = 48 MHz / prescaler
 			base_delay = 1 / freq
 			overflow_delay = UINT16_MAX * base_delay
-
-		Will be using:
-			GCLK_TC/16 for us
-			GCLK_TC/1024 for s
-
-		GCLK_TC/16:
-		freq = 48 MHz / prescaler = 48 MHz / 16 = 3 MHz
-		base_delay = 1 / freq = 1 / 3e6 s = 1/3 us ~= 0.333333333 us
-		overflow_delay = UINT16_MAX * base_delay = 65535 / 3 us = 21845 us
-
-		GCLK_TC/1024:
-		freq = 48 MHz / prescaler = 48 MHz / 1024 = 46.875 kHz = 46875 Hz
-		base_delay = 1 / freq = 1 / 46875 s = ~= 21.333333333us
-		overflow_delay = UINT16_MAX * base_delay = 65535 / 46875 s = 1.39808 s
 		*/
+		unsigned long long int ticks;
+		unsigned char prescaler = _prescale(num / den, _uTimerLibShifts, 8, 65535, &ticks) - 1;	// 65535: room for fraction tick in one compare
+		ticks = _ticks(num, (unsigned long long int) den << _uTimerLibShifts[prescaler]);
+
+		// now_ticks() counts at previous prescaler up to here; TC is stopped to change it, so clock pauses until _restart()
+		unsigned long int state = _lock();
+		_nowStop();
 
 		// Enable clock for TC
 		REG_GCLK_CLKCTRL = (uint16_t) (GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(GCM_TCC2_TC3)) ;
@@ -97,52 +157,146 @@
 		_TC->CTRLA.reg &= ~TC_CTRLA_ENABLE;
 		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
 
-		// Set Timer counter Mode to 16 bits + Set TC as normal Match Frq + Prescaler: GCLK_TC/16
-		_TC->CTRLA.reg |= (TC_CTRLA_MODE_COUNT16 + TC_CTRLA_WAVEGEN_MFRQ + TC_CTRLA_PRESCALER_DIV16);
+		// Set Timer counter Mode to 16 bits + Set TC as normal Match Frq + Prescaler
+		_TC->CTRLA.reg = (_TC->CTRLA.reg & ~(TC_CTRLA_MODE_Msk | TC_CTRLA_WAVEGEN_Msk | TC_CTRLA_PRESCALER_Msk)) | TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER(prescaler);
 		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+		_uTimerLibReadContinuous(_TC);
+		_nowShift = _uTimerLibShifts[prescaler];
+		_unlock(state);
+
+		// ticks = _overflows * 65536 + _remaining; last compare counts _remaining ticks, 0 if there's none
+		__overflows = ticks >> 16;
+		__remaining = ticks & 0xFFFF;
+		_restart();
+	}
 
-		if (us > 21845) {
-			__overflows = _overflows = us / 21845.0;
-			__remaining = _remaining = (us - (21845 * _overflows)) * 3 - 1;
-		} else {
-			__overflows = _overflows = 0;
-			__remaining = _remaining = us * 3 - 1;
+	/**
+	 * \brief Starts counting last timing from now: reloads counter, compare value, overflows count and interrupt, with timer clock already set
+	 *
+	 * Last step of setting up the timer, and restart(). No loops nor waits: some register writes; hardware stalls back to back
+	 * synchronized ones a few GCLK cycles.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		unsigned long int state = _lock(); // Timer interrupt, and now_ticks() from others, see timing and clock reloaded together
+		_nowFold(); // Ticks counted so far, as counter restarts
+		_overflows = __overflows;
+		_remaining = __remaining + _fraction(); // First period takes its fraction tick too, as next ones do on interrupt
+		if (_remaining == 65536) { // Last compare became a complete one
+			_overflows++;
+			_remaining = 0;
 		}
-
-		if (__overflows == 0) {
+		if (_overflows == 0) {
 			_loadRemaining();
 			_remaining = 0;
 		} else {
 			_TC->CC[0].reg = UINT16_MAX;
-			_TC->INTENSET.reg = 0;              // disable all interrupts
-			_TC->INTENSET.bit.OVF = 1;          // enable overfollow
-			// Skip: while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+			_nowTop = UINT16_MAX;
 		}
 
 		_TC->COUNT.reg = 0;              // Reset to 0
+		_TC->INTFLAG.reg = TC_INTFLAG_MC0 | TC_INTFLAG_OVF;	// Clear pending ones, if any
+		NVIC_ClearPendingIRQ(TC3_IRQn);
+		_TC->INTENCLR.reg = TC_INTENCLR_OVF;	// Compare match to CC0 only, as it's TOP: once each period
+		_TC->INTENSET.reg = TC_INTENSET_MC0;
+		_fastPath();
 
 		NVIC_EnableIRQ(TC3_IRQn);
 
 		// Enable TC
 		_TC->CTRLA.reg |= TC_CTRLA_ENABLE;
+
+		_nowAcc = 0;
+		_nowRun = _nowOn;
+		_nowIdling = false;
+		_unlock(state);
+		return true;
+	}
+
+	/**
+	 * \brief Gives count after running one a new length in timer ticks; next counts too
+	 *
+	 * Only next timing is set: interrupt writes CC0 on compare ending running count, as it does for each interval period,
+	 * and MFRQ restarts counter on that compare, so counts add up with no drift from interrupt latency and counter is never read.
+	 * CC0 is written just after counter restarts, so a count must be longer than interrupt latency.
+	 * Longer counts are split in complete compares, as set up does. Fast path is left, as it doesn't load next count.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	ticks	Timer ticks, see _reloadTicks()
+	 * @return	false if timer is not an interval
+	 */
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || ticks == 0) {
+			return false;
+		}
+		unsigned long int state = _lock(); // __overflows and __remaining are read together by interrupt
+		_fracRem = 0; // Whole ticks
+		__overflows = ticks >> 16;
+		__remaining = ticks & 0xFFFF;
+		_fastCb = NULL;
+		_unlock(state);
+		return true;
+	}
+
+	/**
+	 * \brief Microseconds in timer ticks of current interval prescaler, rounded
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	Timer ticks; 0 if timer is not an interval
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL) {
+			return 0;
+		}
+		unsigned char shift = _uTimerLibShifts[(_TC->CTRLA.reg & TC_CTRLA_PRESCALER_Msk) >> TC_CTRLA_PRESCALER_Pos];
+		return ((unsigned long long int) us * (F_CPU / 1000000) + ((1UL << shift) >> 1)) >> shift;
 	}
 
 
 	/**
-	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 * \brief Drives pin directly from timer compare output: toggle on compare match or PWM
+	 *
+	 * TC3 waveform outputs: WO0 on PA18 and WO1 on PA19 (10 and 12 on Arduino Zero).
+	 * Toggle: MFRQ mode, CC0 as TOP; WO1 toggles on CC1 = 0. PWM: MPWM mode, CC0 as TOP, so only WO1 can do PWM.
 	 *
 	 * Note: This is device-dependant
 	 *
-	 * @param	s		Desired timing in seconds
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false if pin is not a waveform output of TC3 or timing doesn't fit in timer
 	 */
-	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
-		if (s == 0) { // Not valid
-			return;
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		if (g_APinDescription[pin].ulPort != PORTA || (g_APinDescription[pin].ulPin != 18 && g_APinDescription[pin].ulPin != 19)) {
+			return false;
+		}
+		if (high > 0 && g_APinDescription[pin].ulPin != 19) {
+			return false;
+		}
+		if (us > 0xFFFFFFFF / (F_CPU / 1000000)) {
+			return false;
 		}
 
-		/*
-		GCLK_TC/1024	1024		46.875kHz	~21,333333333us	1398080us; 1398,08ms; 1,39808s
-		*/
+		// Smallest prescaler that fits in 16 bits: GCLK_TC, GCLK_TC/2, GCLK_TC/4, GCLK_TC/8, GCLK_TC/16, GCLK_TC/64, GCLK_TC/256, GCLK_TC/1024
+		static const uint16_t divisors[] = {1, 2, 4, 8, 16, 64, 256, 1024};
+		unsigned long int cycles = us * (F_CPU / 1000000), ticks = 0;
+		uint8_t prescaler;
+		for (prescaler = 0; prescaler < 8; prescaler++) {
+			ticks = (cycles + divisors[prescaler] / 2) / divisors[prescaler]; // + divisor / 2 is round for positive numbers
+			if (ticks <= 65536) {
+				break;
+			}
+		}
+		if (prescaler == 8) {
+			return false;
+		}
+		_nowStop(); // now_ticks() pauses while timer drives pin
 
 		// Enable clock for TC
 		REG_GCLK_CLKCTRL = (uint16_t) (GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(GCM_TCC2_TC3)) ;
@@ -152,62 +306,268 @@
 		_TC->CTRLA.reg &= ~TC_CTRLA_ENABLE;
 		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
 
-		// Set Timer counter Mode to 16 bits + Set TC as normal Match Frq + Prescaler: GCLK_TC/1024
-		_TC->CTRLA.reg |= (TC_CTRLA_MODE_COUNT16 + TC_CTRLA_WAVEGEN_MFRQ + TC_CTRLA_PRESCALER_DIV1024);
+		_TC->INTENCLR.reg = TC_INTENCLR_MC0 | TC_INTENCLR_MC1 | TC_INTENCLR_OVF;
+		_TC->CTRLA.reg = TC_CTRLA_MODE_COUNT16 | (high == 0 ? TC_CTRLA_WAVEGEN_MFRQ : TC_CTRLA_WAVEGEN_MPWM) | TC_CTRLA_PRESCALER(prescaler);
 		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
-
-		if (s > 1) {
-			__overflows = _overflows = s / 1.39808;
-			__remaining = _remaining = ((s * 100000) % 139808) * 480 / 1024 - 1; // for integer s this is always an integer
-		} else {
-			__overflows = _overflows = 0;
-			__remaining = _remaining = s * 46875 - 1;
-		}
-
-		if (__overflows == 0) {
-			_loadRemaining();
-			_remaining = 0;
-		} else {
-			_TC->CC[0].reg = UINT16_MAX;
-			_TC->INTENSET.reg = 0;              // disable all interrupts
-			_TC->INTENSET.bit.OVF = 1;          // enable overfollow
-			// Skip: while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
-		}
-
+		_TC->CC[0].reg = ticks - 1;
+		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+		_TC->CC[1].reg = (high == 0) ? 0 : (high * (F_CPU / 1000000) + divisors[prescaler] / 2) / divisors[prescaler];
+		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+		_uTimerLibReadContinuous(_TC);
+		_nowShift = _uTimerLibShifts[prescaler]; // now_ticks() idle count keeps it, once pin is cleared
 		_TC->COUNT.reg = 0;              // Reset to 0
 
-		NVIC_EnableIRQ(TC3_IRQn);
+		pinPeripheral(pin, PIO_TIMER);
 
 		// Enable TC
 		_TC->CTRLA.reg |= TC_CTRLA_ENABLE;
+		return true;
 	}
 
 
+	/**
+	 * \brief Sets up timer for input capture on pin: TC3 free running at GCLK_TC/16 (3MHz), capturing on CC0
+	 *
+	 * Pin edge goes from EIC to TC3 through last EVSYS channel, so any pin with external interrupt can be used.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false if pin has no external interrupt
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		EExt_Interrupts extint = g_APinDescription[pin].ulExtInt;
+		if (extint == NOT_AN_INTERRUPT) {
+			return false;
+		}
+		_cbCapture = cb;
+		_timeType = UTIMERLIB_TYPE_OFF; // Timer set up is lost for restart()
+		_pin = pin;
+		_overflows = 0;
+		_nowStop(); // now_ticks() pauses while timer captures
+
+		// EIC: event output on pin edge
+		REG_GCLK_CLKCTRL = (uint16_t) (GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(GCM_EIC));
+		while (GCLK->STATUS.bit.SYNCBUSY == 1); // sync
+		EIC->CTRL.bit.ENABLE = 0;
+		while (EIC->STATUS.bit.SYNCBUSY == 1); // sync
+		uint8_t shift = (extint & 7) << 2;
+		EIC->CONFIG[extint >> 3].reg = (EIC->CONFIG[extint >> 3].reg & ~(EIC_CONFIG_SENSE0_Msk << shift)) | (((edge == RISING) ? EIC_CONFIG_SENSE0_RISE_Val : EIC_CONFIG_SENSE0_FALL_Val) << shift);
+		EIC->EVCTRL.reg |= (1 << extint);
+		EIC->INTENCLR.reg = (1 << extint);
+		EIC->CTRL.bit.ENABLE = 1;
+		while (EIC->STATUS.bit.SYNCBUSY == 1); // sync
+		pinPeripheral(pin, PIO_EXTINT);
+
+		// EVSYS: EIC to TC3
+		PM->APBCMASK.reg |= PM_APBCMASK_EVSYS;
+		EVSYS->USER.reg = (uint16_t) (EVSYS_USER_USER(EVSYS_ID_USER_TC3_EVU) | EVSYS_USER_CHANNEL(EVSYS_CHANNELS)); // Channel n is n + 1
+		EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(EVSYS_CHANNELS - 1) | EVSYS_CHANNEL_EVGEN(EVSYS_ID_GEN_EIC_EXTINT_0 + extint) | EVSYS_CHANNEL_PATH_ASYNCHRONOUS | EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT;
+
+		// TC3: normal mode, capture event on CC0
+		REG_GCLK_CLKCTRL = (uint16_t) (GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(GCM_TCC2_TC3)) ;
+		while (GCLK->STATUS.bit.SYNCBUSY == 1); // sync
+		_TC->CTRLA.reg &= ~TC_CTRLA_ENABLE;
+		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+		_TC->CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_NFRQ | TC_CTRLA_PRESCALER_DIV16;
+		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+		_TC->CTRLC.reg = TC_CTRLC_CPTEN0;
+		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+		_TC->EVCTRL.reg = TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_OFF;
+		_TC->COUNT.reg = 0;
+		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+		_uTimerLibReadContinuous(_TC, TC_COUNT16_CC_OFFSET); // CC0 is synchronized on each capture, else interrupt would read previous one
+		_nowShift = 4; // now_ticks() idle count keeps it, once capture is cleared
+		_TC->INTFLAG.reg = TC_INTFLAG_MC0 | TC_INTFLAG_OVF;
+		_TC->INTENSET.reg = TC_INTENSET_MC0 | TC_INTENSET_OVF;
+		NVIC_EnableIRQ(TC3_IRQn);
+		_TC->CTRLA.reg |= TC_CTRLA_ENABLE;
+
+		*hz = F_CPU / 16;
+		return true;
+	}
+
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
 	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::_loadRemaining() {
-		_TC->CC[0].reg = _remaining;
-		_TC->INTENSET.reg = 0;              // disable all interrupts
-		_TC->INTENSET.bit.MC0 = 1;          // enable compare match to CC0
-		while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+		_TC->CC[0].reg = _remaining - 1; // CC0 is TOP, counting from 0; synchronized by hardware meanwhile, no need to wait for it
+		_nowTop = _remaining - 1;
+	}
+
+	/**
+	 * \brief Routes each timer period to an event system (EVSYS) channel and user, so a peripheral is triggered with no interrupt at all
+	 *
+	 * Timer must be an interval of a single compare (up to 1.39s). If callback is NULL timer interrupt is disabled.
+	 * Example, start an ADC conversion each 100us: TimerLib.setInterval_us(NULL, 100); TimerLib.setEventOutput(0, EVSYS_ID_USER_ADC_START);
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	channel		EVSYS channel to use
+	 * @param	user		EVSYS user (peripheral event input) to trigger, EVSYS_ID_USER_xxx
+	 * @return	false if timer is not a single compare interval or channel or user are not valid
+	 */
+	bool uTimerLib::setEventOutput(uint8_t channel, uint8_t user) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || __overflows != 0 || channel >= EVSYS_CHANNELS || user >= EVSYS_USERS) {
+			return false;
+		}
+		clearEventOutput();
+		_evChannel = channel;
+		_evUser = user;
+
+		PM->APBCMASK.reg |= PM_APBCMASK_EVSYS;
+		EVSYS->USER.reg = (uint16_t) (EVSYS_USER_USER(user) | EVSYS_USER_CHANNEL(channel + 1)); // Channel n is n + 1; 0 is none
+		EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(channel) | EVSYS_CHANNEL_EVGEN(EVSYS_ID_GEN_TC3_MCX_0) | EVSYS_CHANNEL_PATH_ASYNCHRONOUS | EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT;
+
+		// Event on CC0 compare match, which is TOP in MFRQ mode
+		_TC->EVCTRL.reg |= TC_EVCTRL_MCEO0;
+		if (_cb == NULL) {
+			_nowStop(); // now_ticks() pauses with no interrupt
+			_TC->INTENCLR.reg = TC_INTENCLR_MC0 | TC_INTENCLR_OVF;
+		}
+		return true;
+	}
+
+	/**
+	 * \brief Makes current interval run on its own in hardware, with no interrupt, for event output and DMA
+	 *
+	 * Timer already runs in MFRQ mode with CC0 as TOP; overflow happens once each period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	false if timer is not a single compare interval
+	 */
+	bool uTimerLib::_freeRun() {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || __overflows != 0) {
+			return false;
+		}
+		_nowStop(); // now_ticks() pauses with no interrupt
+		_TC->INTENCLR.reg = TC_INTENCLR_MC0 | TC_INTENCLR_OVF;
+		return true;
+	}
+
+	/**
+	 * \brief Disconnects timer from EVSYS channel and user set by setEventOutput
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::clearEventOutput() {
+		if (_evChannel == 0xFF) {
+			return;
+		}
+		_TC->EVCTRL.reg &= ~TC_EVCTRL_MCEO0;
+		EVSYS->USER.reg = (uint16_t) EVSYS_USER_USER(_evUser);
+		EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(_evChannel);
+		_evChannel = 0xFF;
+	}
+
+	/**
+	 * \brief Counts interval periods ended while callback ran, from pending CC0 compare flag, and drops them
+	 *
+	 * Called after an interval callback. MFRQ restarts count by itself, so counter is already on periods grid;
+	 * hardware has one pending flag, so a callback longer than two periods is counted as one missed period.
+	 * Intervals counting several compares are not checked: a pending one is part of next period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		if (__overflows != 0 || !(_TC->INTFLAG.reg & TC_INTFLAG_MC0)) {
+			return 0;
+		}
+		_TC->INTFLAG.reg = TC_INTFLAG_MC0 | TC_INTFLAG_OVF;
+		NVIC_ClearPendingIRQ(TC3_IRQn);
+		_nowWrap(); // Count of that compare is not in next interrupt
+		return 1;
+	}
+
+	/**
+	 * \brief Sets timer interrupt NVIC priority, so it can preempt communication stacks (USB, SERCOM...) or be preempted by them
+	 *
+	 * It's kept for next setXXX calls. With UTIMERLIB_BASEPRI, library critical sections only mask up to this priority.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	priority	NVIC priority, 0 is highest; up to 3
+	 */
+	void uTimerLib::setPriority(uint8_t priority) {
+		if (priority >= (1 << __NVIC_PRIO_BITS)) {
+			priority = (1 << __NVIC_PRIO_BITS) - 1;
+		}
+		_priority = priority;
+		NVIC_SetPriority(TC3_IRQn, priority);
 	}
 
 	/**
 	 * \brief Clear timer interrupts
 	 *
+	 * If now_ticks() is counting, TC and its interrupt are kept and next one sets its idle count.
+	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
+		unsigned char generation = _cancel();
 		_type = UTIMERLIB_TYPE_OFF;
 
 		// Disable TC
-		_TC->INTENSET.reg = 0;              // disable all interrupts
-		_TC->CTRLA.reg &= ~TC_CTRLA_ENABLE;
+		_TC->INTENCLR.reg = TC_INTENCLR_MC0 | TC_INTENCLR_MC1 | TC_INTENCLR_OVF;	// disable all interrupts
+		_fastCb = NULL;
+		if (_nowRun) {
+			_nowIdling = true;
+			_TC->INTENSET.reg = TC_INTENSET_MC0;	// Timer goes on counting for now_ticks()
+		} else {
+			_TC->CTRLA.reg &= ~TC_CTRLA_ENABLE;
+		}
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
+
+		// Stop input capture and release EIC event and EVSYS channel. CTRLC is synchronized by hardware meanwhile, no need to wait for it
+		if (_cbCapture != NULL) {
+			_TC->INTENCLR.reg = TC_INTENCLR_MC0 | TC_INTENCLR_OVF;
+			_TC->CTRLC.reg = 0;
+			_TC->READREQ.reg = TC_READREQ_RREQ | TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET); // Counter again, for now_ticks()
+			_TC->EVCTRL.reg &= ~(TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_Msk);
+			EIC->EVCTRL.reg &= ~(1 << g_APinDescription[_pin].ulExtInt);
+			EVSYS->USER.reg = (uint16_t) EVSYS_USER_USER(EVSYS_ID_USER_TC3_EVU);
+			EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(EVSYS_CHANNELS - 1);
+			_cbCapture = NULL;
+		}
+
+		// Back to GPIO, as waveform output stops with TC
+		if (_outputPin != 0xFF) {
+			pinMode(_outputPin, OUTPUT);
+			_outputPin = 0xFF;
+		}
+
+		if (_nowOn && !_nowRun) { // now_ticks() was paused
+			_nowIdle();
+		}
 }
 
+	/**
+	 * \brief Interrupt fast path for a pure single compare interval: MFRQ reloads CC0 by itself
+	 *
+	 * Both flags are cleared, as OVF also happens at TOP in MFRQ mode.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	false if timer is not in fast path, so _interrupt() has to be called
+	 */
+	inline bool uTimerLib::_fastInterrupt() {
+		void (*cb)() = _fastCb;
+		if (cb == NULL) {
+			return false;
+		}
+		_TC->INTFLAG.reg = TC_INTFLAG_MC0 | TC_INTFLAG_OVF;
+		cb();
+		return true;
+	}
+
 	/**
 	 * \brief Internal intermediate function to control timer interrupts
 	 *
@@ -215,6 +575,11 @@
 	 * this function implements oferflow control to offer user desired timings.
 	 */
 	void uTimerLib::_interrupt() {
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
+		if (_nowIdling) { // No timing: timer only counts for now_ticks()
+			_nowIdle();
+			return;
+		}
 		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
@@ -230,26 +595,128 @@
 		} else if (_overflows == 0 && _remaining == 0) {
 			if (_type == UTIMERLIB_TYPE_TIMEOUT) {
 				clearTimer();
+				generation = _current(); // Own clear, not a cancel
 			} else if (_type == UTIMERLIB_TYPE_INTERVAL) {
-				if (__overflows != 0) {
+				if (__overflows == 0) {
+					uint16_t top = __remaining - 1 + _fraction(); // One tick more each time fraction adds up to one
+					if (top != _nowTop) { // Or a new length from _reload(); else MFRQ keeps CC0
+						_nowTop = top;
+						_TC->CC[0].reg = top;
+					}
+				} else {
 					_overflows = __overflows;
-					_remaining = __remaining;
-
-					_TC->INTENSET.reg = 0;              // disable all interrupts
-					_TC->INTENSET.bit.OVF = 0;          // enable overfollow
-					_TC->INTENSET.bit.MC0 = 1;          // disable compare match to CC0
+					_remaining = __remaining + _fraction();
+					if (_remaining == 65536) { // Last compare became a complete one
+						_overflows++;
+						_remaining = 0;
+					}
 					_TC->CC[0].reg = UINT16_MAX;
+					_nowTop = UINT16_MAX;
 				}
 			}
-			_cb();
+			_dispatch(generation);
 		} else if (_overflows > 0) { // Reload for SAMD21
-			_TC->INTENSET.reg = 0;              // disable all interrupts
-			_TC->INTENSET.bit.OVF = 0;          // enable overfollow
-			_TC->INTENSET.bit.MC0 = 1;          // disable compare match to CC0
 			_TC->CC[0].reg = UINT16_MAX;
+			_nowTop = UINT16_MAX;
 		}
 	}
 
+	/**
+	 * \brief Timer ticks counted for now_ticks() since last fold: ended counts, counter and a compare pending meanwhile
+	 *
+	 * Interrupts are masked, or now_ticks() reads it again if timer interrupt ran meanwhile. Compare flag is read before and after
+	 * counter: if it's set between them, counter is read again. Counter is continuously synchronized (READREQ.RCONT), so it's read
+	 * with no wait, up to UTIMERLIB_SAMD21_READ_LAG cycles late: with a compare pending, a value still at TOP is the one before restart.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Timer ticks
+	 */
+	uint64_t uTimerLib::_nowCount() {
+		bool pending = _TC->INTFLAG.reg & TC_INTFLAG_MC0;
+		uint64_t count = _TC->COUNT.reg;
+		if (!pending && (_TC->INTFLAG.reg & TC_INTFLAG_MC0)) {
+			pending = true;
+			count = _TC->COUNT.reg;
+		}
+		if (pending) { // Counter has restarted from 0
+			if ((long int) count > (long int) _nowTop - ((UTIMERLIB_SAMD21_READ_LAG >> _nowShift) + 1)) { // Late value, from before restart
+				count = 0;
+			}
+			count += _nowTop + 1;
+		}
+		return _nowAcc + count;
+	}
+
+	/**
+	 * \brief Adds count just ended to now_ticks() clock, called on each CC0 compare before anything else
+	 *
+	 * Note: This is device-dependant
+	 */
+	inline void uTimerLib::_nowWrap() {
+		if (_nowRun) {
+			_nowAcc += _nowTop + 1;
+		}
+		_nowSeq++;
+	}
+
+	/**
+	 * \brief Starts now_ticks() clock on its first call: on a running timing if there's one, else with idle count
+	 *
+	 * Interrupts must be masked. If timer drives a pin, captures or runs on its own, clock starts when they're cleared.
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::_nowStart() {
+		if ((_TC->INTENSET.reg & TC_INTENSET_MC0) && _cbCapture == NULL) {
+			_nowAcc -= _nowCount();
+			_nowRun = true;
+			_nowSeq++;
+			_fastCb = NULL; // Clock counts on regular path; its state is kept as after a callback, so it's left at once
+		} else if (_type == UTIMERLIB_TYPE_OFF && _outputPin == 0xFF && _cbCapture == NULL) {
+			_nowIdle();
+		}
+	}
+
+	/**
+	 * \brief Keeps timer counting for now_ticks() when there's no timing: longest count, keeping last set up prescaler (GCLK_TC / 16 if there's none)
+	 *
+	 * Mode and prescaler are kept, so there's no clock change, restart() can use it again and there's no synchronization to wait for:
+	 * CC0 at 0xFFFF is a compare each 65536 ticks in any mode, also after pin output or input capture. Only if TC3 has never been set up
+	 * (first now_ticks() call), it's set up here, waiting for it. Called from timer interrupt after clearTimer(), or when timer is free again.
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::_nowIdle() {
+		unsigned long int state = _lock(); // Clock state changes together, also from timer interrupt
+		if (!_nowRun) {
+			if (!_uTimerLibSetUp) { // Never set up
+				REG_GCLK_CLKCTRL = (uint16_t) (GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(GCM_TCC2_TC3));
+				while (GCLK->STATUS.bit.SYNCBUSY == 1); // sync
+				_TC->CTRLA.reg &= ~TC_CTRLA_ENABLE;
+				while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+				_TC->CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV16;
+				while (_TC->STATUS.bit.SYNCBUSY == 1); // sync
+				_uTimerLibReadContinuous(_TC);
+				_nowShift = 4;
+			}
+			_TC->COUNT.reg = 0;
+			_TC->INTFLAG.reg = TC_INTFLAG_MC0 | TC_INTFLAG_OVF;
+			NVIC_ClearPendingIRQ(TC3_IRQn);
+			_TC->INTENCLR.reg = TC_INTENCLR_OVF;
+			_TC->INTENSET.reg = TC_INTENSET_MC0;
+			NVIC_EnableIRQ(TC3_IRQn);
+			_TC->CTRLA.reg |= TC_CTRLA_ENABLE;
+			_nowAcc = 0;
+			_nowRun = true;
+			_nowSeq++;
+		}
+		_TC->CC[0].reg = UINT16_MAX; // Called from interrupt, counter has just restarted from 0
+		_nowTop = UINT16_MAX;
+		_nowIdling = true;
+		_unlock(state);
+	}
+
 	/**
 	 * \brief Preinstantiate Object
 	 *
@@ -265,14 +732,27 @@
 	 * Note: This is device-dependant
 	 */
 	void TC3_Handler() {
-		// Overflow - Nothing, we will use compare to max value instead to unify behaviour
-		if (TimerLib._TC->INTFLAG.bit.OVF == 1) {
-			TimerLib._TC->INTFLAG.bit.OVF = 1;  // Clear flag
-			TimerLib._interrupt();
+		if (TimerLib._fastInterrupt()) {
+			return;
+		}
+		if (TimerLib._TC->INTFLAG.reg & TC_INTFLAG_MC0) { // A count has ended (or a capture, then clock is paused)
+			TimerLib._nowWrap();
+		}
+		// Input capture: timestamp on CC0, extended with overflows; CC0 is continuously synchronized, so it's read with no wait
+		if (TimerLib._TC->CTRLC.reg & TC_CTRLC_CPTEN0) {
+			if (TimerLib._TC->INTFLAG.reg & TC_INTFLAG_MC0) {
+				TimerLib._TC->INTFLAG.reg = TC_INTFLAG_MC0;
+				TimerLib._capture(TimerLib._TC->CC[0].reg, TimerLib._TC->INTFLAG.reg & TC_INTFLAG_OVF);
+			}
+			if (TimerLib._TC->INTFLAG.reg & TC_INTFLAG_OVF) {
+				TimerLib._TC->INTFLAG.reg = TC_INTFLAG_OVF;
+				TimerLib._captureOverflow();
+			}
+			return;
 		}
-		// Compare
+		// Compare to CC0, which is TOP: once each period. Overflow follows it, with nothing to do, so both flags are cleared
 		if (TimerLib._TC->INTFLAG.bit.MC0 == 1) {
-			TimerLib._TC->INTFLAG.bit.MC0 = 1;  // Clear flag
+			TimerLib._TC->INTFLAG.reg = TC_INTFLAG_MC0 | TC_INTFLAG_OVF;  // Clear flags
 			TimerLib._interrupt();
 		}
 	}
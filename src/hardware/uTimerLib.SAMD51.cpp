@@ -34,7 +34,18 @@
 	#define _uTimerLib_IMP_
 	#include "uTimerLib.cpp"
 
+	/**
+	 * \brief Waits for TC1 clock domain synchronization; only on set up (setXXX, setEventOutput), never on interrupt, restart(), _reload() nor now_ticks() paths
+	 *
+	 * extras/tests/test_sync.cpp checks it.
+	 */
 	#define UTIMERLIB_WAIT_SYNC() while (TC1->COUNT16.SYNCBUSY.reg)
+
+	/**
+	 * \brief Timer prescalers as powers of 2, by PRESCALER field value
+	 */
+	static const unsigned char _uTimerLibShifts[] = {0, 1, 2, 3, 4, 6, 8, 10};
+
 	/**
 	 * \brief Sets up the timer, calculation variables and interrupts for desired ms microseconds
 	 *
@@ -42,16 +53,51 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
+		if (us > 0xFFFFFFFFFFFFFFFFULL / F_CPU) { // Cycles don't fit in 64 bits (days): count them from whole miliseconds
+			_attachInterrupt_cycles(us / 1000 * F_CPU, 1000);
+			return;
+		}
+		_attachInterrupt_cycles(us * F_CPU, 1000000);
+	}
+
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	s		Desired timing in seconds
+	 */
+	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
+		if (s == 0) { // Not valid
+			return;
+		}
+		_attachInterrupt_cycles((unsigned long long int) s * F_CPU, 1);
+	}
+
+
+	/**
+	 * \brief Sets up the timer, calculation variables and interrupts for num / den GCLK_TC cycles
+	 *
+	 * Prescaler is the smallest one that fits timing in one count, for best resolution; if none, largest one counting overflows.
+	 * Fraction of a tick left is added by _fraction() on each period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	num		Desired timing numerator, in GCLK_TC cycles
+	 * @param	den		Desired timing denominator
+	 */
+	void uTimerLib::_attachInterrupt_cycles(unsigned long long int num, unsigned long int den) {
 		/*
 		16 bit timer
 
 		Prescaler:
 		Prescalers: GCLK_TC, GCLK_TC/2, GCLK_TC/4, GCLK_TC/8, GCLK_TC/16, GCLK_TC/64, GCLK_TC/256, GCLK_TC/1024
-		Base frequency: 84MHz
+		Base frequency: 120MHz
 
 		We will use TC1
 
@@ -61,17 +107,17 @@
 		GCLK_TC			   1		 120MHz		0,008333333us	    546,133333333us;    0,546133333333ms
 		GCLK_TC/2		   2		  60MHz		0,016666667us	   1092,266666667us;    1,092266666667ms
 		GCLK_TC/4		   4		  30MHz		0,033333333us	   2184,533333333us;    2,184533333333ms
-		GCLK_TC/8		   8		  20MHz		0,066666667us	   4369,066666667us;    4,369066666667ms
-		GCLK_TC/16		  16		  10MHz		0,133333333us	   8738,133333333us;    8,738133333333ms
+		GCLK_TC/8		   8		  15MHz		0,066666667us	   4369,066666667us;    4,369066666667ms
+		GCLK_TC/16		  16		 7,5MHz		0,133333333us	   8738,133333333us;    8,738133333333ms
 		GCLK_TC/64		  64		1,875MHz	0,533333333us	  34952,533333333us;   34,952533333333ms
 		GCLK_TC/256		 256		468,75KHz	2,133333333us	 139810,133333333us;  139,810133333333ms
-		GCLK_TC/1024	1024		117,1875Hz	8,533333333us	 559240,533333333us;  559,240533333333ms
-
-		Will be using:
-			GCLK_TC/16 for us
-			GCLK_TC/1024 for s
+		GCLK_TC/1024	1024		117,1875KHz	8,533333333us	 559240,533333333us;  559,240533333333ms
 		*/
+		unsigned long long int ticks;
+		unsigned char prescaler = _prescale(num / den, _uTimerLibShifts, 8, 65535, &ticks) - 1;
+		ticks = _ticks(num, (unsigned long long int) den << _uTimerLibShifts[prescaler]);
 
+		unsigned long int state = _lock(); // A running timing interrupt could restart TC meanwhile
 
 /*
 		// Enable the TC bus clock
@@ -83,126 +129,250 @@
 		GCLK->PCHCTRL[TC1_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK1_Val | GCLK_PCHCTRL_CHEN;
 		while(GCLK->SYNCBUSY.reg); // sync
 
+		// Mode, prescaler and waveform are enable-protected, not synchronized: only disabling has to be waited for
 		TC1->COUNT16.CTRLA.bit.ENABLE = 0;
 		UTIMERLIB_WAIT_SYNC();
+		TC1->COUNT16.CTRLA.reg = (TC1->COUNT16.CTRLA.reg & ~(TC_CTRLA_MODE_Msk | TC_CTRLA_PRESCALER_Msk)) | TC_CTRLA_MODE_COUNT16 | TC_CTRLA_PRESCALER(prescaler);
+		TC1->COUNT16.WAVE.reg = TC_WAVE_WAVEGEN_MFRQ; // CC0 is TOP, so each period is reloaded by hardware from CCBUF0
+		_unlock(state);
 
-		TC1->COUNT16.CTRLA.bit.MODE = TC_CTRLA_MODE_COUNT16_Val;
-		UTIMERLIB_WAIT_SYNC();
-
+		// Periods of 65535 ticks at most, so last one has room for fraction tick: __overflows complete ones, then last one of __remaining + 1 ticks
+		__overflows = (ticks - 1) / 65535;
+		__remaining = ticks - 1 - (unsigned long long int) __overflows * 65535;
 
+		// Count on event
+		//TC1->COUNT16.EVCTRL.bit.EVACT = TC_EVCTRL_EVACT_COUNT_Val;
 
-		TC1->COUNT16.CTRLA.reg &= ((~(TC_CTRLA_ENABLE)) & (~(TC_CTRLA_PRESCALER_DIV1024)) & (~(TC_CTRLA_PRESCALER_DIV256)) & (~(TC_CTRLA_PRESCALER_DIV64)) & (~(TC_CTRLA_PRESCALER_DIV16)) & (~(TC_CTRLA_PRESCALER_DIV4)) & (~(TC_CTRLA_PRESCALER_DIV2)) & (~(TC_CTRLA_PRESCALER_DIV1)));
-		UTIMERLIB_WAIT_SYNC();
-
-		TC1->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIV16;
-		UTIMERLIB_WAIT_SYNC();
+		_restart();
+	}
 
+	/**
+	 * \brief Starts counting last timing from now: reloads counter, TOP of this period and next one, overflows count and interrupt, with timer clock already set
+	 *
+	 * Last step of setting up the timer, and restart(). No loops nor waits: some register writes, each one to a different synchronized register.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		unsigned long int state = _lock(); // Timer interrupt doesn't see running TOP, next one and periods left half loaded
+		_overflows = __overflows; // Periods left after running one
+		// Running period and next one take their fraction tick too, in order, as next ones do on interrupt
+		TC1->COUNT16.CC[0].reg = (__overflows == 0) ? __remaining + _fraction() : 0xFFFE;
+		_remaining = (__overflows <= 1) ? __remaining + _fraction() : 0xFFFE;
+		_loadRemaining();
+		TC1->COUNT16.COUNT.reg = 0;
+		TC1->COUNT16.INTFLAG.reg = TC_INTFLAG_MASK;	// Clear pending ones, if any
+		NVIC_ClearPendingIRQ(TC1_IRQn);
+
+		TC1->COUNT16.INTENCLR.reg = TC_INTENCLR_MASK;
+		TC1->COUNT16.INTENSET.reg = TC_INTENSET_OVF;	// Overflow only: once each period
+		// Enable InterruptVector
+		NVIC_EnableIRQ(TC1_IRQn);
 
-		if (us > 8738) {
-			__overflows = _overflows = us / 8738.133333333;
-			__remaining = _remaining = (us - (8738.133333333 * _overflows)) / 0.133333333 + 0.5; // +0.5 is same as round
-		} else {
-			__overflows = _overflows = 0;
-			__remaining = _remaining = (us / 0.133333333 + 0.5); // +0.5 is same as round
-		}
+		TC1->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+		_unlock(state);
+		return true;
+	}
 
-		if (__remaining != 0) {
-			__remaining = _remaining = (((uint16_t) 0xffff) - __remaining); // Remaining is max value minus remaining
+	/**
+	 * \brief Gives count after running one a new length in timer ticks; next counts too
+	 *
+	 * Its TOP is written to CCBUF0, and MFRQ moves it to CC0 on overflow ending running count, restarting counter,
+	 * so counts add up with no drift from interrupt latency, and neither counter nor CC0 are touched while counting.
+	 * Next ones are loaded by interrupt, as for each interval period. Up to 65535 ticks, a single count:
+	 * if running count is not last one of its timing, CCBUF0 is not its to change.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	ticks	Timer ticks, see _reloadTicks()
+	 * @return	false if timer is not an interval or ticks don't fit in one count
+	 */
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || ticks == 0 || ticks > 65535) {
+			return false;
 		}
-
-		if (__overflows == 0) {
+		unsigned long int state = _lock(); // __overflows and __remaining are read together by interrupt
+		_fracRem = 0; // Whole ticks
+		__overflows = 0;
+		__remaining = ticks - 1;
+		if (_overflows == 0) { // Running count is last one: next one is already loaded, from previous timing
+			_remaining = __remaining;
 			_loadRemaining();
-			_remaining = 0;
-		} else {
-			TC1->COUNT16.COUNT.reg = 0;
 		}
-
-
-		TC1->COUNT16.INTENSET.reg = 0;
-		TC1->COUNT16.INTENSET.bit.OVF = 1;
-		// Enable InterruptVector
-		NVIC_EnableIRQ(TC1_IRQn);
-
-		// Count on event
-		//TC1->COUNT16.EVCTRL.bit.EVACT = TC_EVCTRL_EVACT_COUNT_Val;
-
-		TC1->COUNT16.CTRLA.bit.ENABLE = 1;
+		_unlock(state);
+		return true;
 	}
 
-
 	/**
-	 * \brief Sets up the timer, calculation variables and interrupts for desired s seconds
+	 * \brief Microseconds in timer ticks of current interval prescaler, rounded
 	 *
 	 * Note: This is device-dependant
 	 *
-	 * @param	s		Desired timing in seconds
+	 * @param	us		Microseconds
+	 * @return	Timer ticks; 0 if timer is not an interval
 	 */
-	void uTimerLib::_attachInterrupt_s(unsigned long int s) {
-		if (s == 0) { // Not valid
-			return;
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL) {
+			return 0;
 		}
-
-		/*
-		GCLK_TC/1024	1024		117,1875Hz	8,533333333us	 559240,533333333us;  559,240533333333ms
-		*/
-
+		unsigned char shift = _uTimerLibShifts[(TC1->COUNT16.CTRLA.reg & TC_CTRLA_PRESCALER_Msk) >> TC_CTRLA_PRESCALER_Pos];
+		return ((unsigned long long int) us * (F_CPU / 1000000) + ((1UL << shift) >> 1)) >> shift;
+	}
 
 
 
-		// Enable the TC bus clock
-		GCLK->PCHCTRL[TC1_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK1_Val | GCLK_PCHCTRL_CHEN;
-		while(GCLK->SYNCBUSY.reg); // sync
+	/**
+	 * \brief Drives pin directly from timer compare output
+	 *
+	 * Not available on this device: TC1 waveform outputs are not routed yet.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false, so pin is toggled by interrupt
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		return false;
+	}
 
-		TC1->COUNT16.CTRLA.bit.ENABLE = 0;
-		UTIMERLIB_WAIT_SYNC();
 
-		TC1->COUNT16.CTRLA.bit.MODE = TC_CTRLA_MODE_COUNT16_Val;
-		UTIMERLIB_WAIT_SYNC();
+	/**
+	 * \brief Sets up timer for input capture on pin
+	 *
+	 * Not available on this device: TC1 capture is not routed yet.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		return false;
+	}
 
+	/**
+	 * \brief Loads TOP of period after running one, _remaining, to CCBUF0
+	 *
+	 * Hardware moves it to CC0 on next overflow, so it's not written while counting and there's no synchronization to wait for.
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::_loadRemaining() {
+		TC1->COUNT16.CCBUF[0].reg = _remaining;
+	}
 
+	/**
+	 * \brief Routes each timer period to an event system (EVSYS) channel and user, so a peripheral is triggered with no interrupt at all
+	 *
+	 * Timer must be an interval of a single compare (up to 0.55s). If callback is NULL timer interrupt is disabled.
+	 * Example, start an ADC conversion each 100us: TimerLib.setInterval_us(NULL, 100); TimerLib.setEventOutput(0, EVSYS_ID_USER_ADC_START);
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	channel		EVSYS channel to use
+	 * @param	user		EVSYS user (peripheral event input) to trigger, EVSYS_ID_USER_xxx
+	 * @return	false if timer is not a single compare interval or channel or user are not valid
+	 */
+	bool uTimerLib::setEventOutput(uint8_t channel, uint8_t user) {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || __overflows != 0 || channel >= EVSYS_CHANNELS || user >= EVSYS_USERS) {
+			return false;
+		}
+		clearEventOutput();
+		_evChannel = channel;
+		_evUser = user;
 
-		TC1->COUNT16.CTRLA.reg &= ((~(TC_CTRLA_ENABLE)) & (~(TC_CTRLA_PRESCALER_DIV1024)) & (~(TC_CTRLA_PRESCALER_DIV256)) & (~(TC_CTRLA_PRESCALER_DIV64)) & (~(TC_CTRLA_PRESCALER_DIV16)) & (~(TC_CTRLA_PRESCALER_DIV4)) & (~(TC_CTRLA_PRESCALER_DIV2)) & (~(TC_CTRLA_PRESCALER_DIV1)));
-		UTIMERLIB_WAIT_SYNC();
+		MCLK->APBBMASK.reg |= MCLK_APBBMASK_EVSYS;
+		EVSYS->USER[user].reg = EVSYS_USER_CHANNEL(channel + 1); // Channel n is n + 1; 0 is none
+		EVSYS->Channel[channel].CHANNEL.reg = EVSYS_CHANNEL_EVGEN(EVSYS_ID_GEN_TC1_OVF) | EVSYS_CHANNEL_PATH_ASYNCHRONOUS | EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT;
 
-		TC1->COUNT16.CTRLA.reg |= TC_CTRLA_PRESCALER_DIV1024;
+		// EVCTRL is enable-protected
+		TC1->COUNT16.CTRLA.bit.ENABLE = 0;
 		UTIMERLIB_WAIT_SYNC();
-
-
-		__overflows = _overflows = s / 0.559240533333333;
-		__remaining = _remaining = (s - (0.559240533333333 * _overflows)) / 0.000008533333333 + 0.5; // +0.5 is same as round
-
-		if (__remaining != 0) {
-			__remaining = _remaining = (((uint16_t) 0xffff) - __remaining); // Remaining is max value minus remaining
+		TC1->COUNT16.EVCTRL.reg |= TC_EVCTRL_OVFEO;
+		TC1->COUNT16.CTRLA.bit.ENABLE = 1;
+		if (_cb == NULL) {
+			TC1->COUNT16.INTENCLR.reg = TC_INTENCLR_OVF | TC_INTENCLR_MC0;
 		}
+		return true;
+	}
 
-		if (__overflows == 0) {
-			_loadRemaining();
-			_remaining = 0;
-		} else {
-			TC1->COUNT16.COUNT.reg = 0;
+	/**
+	 * \brief Makes current interval run on its own in hardware, with no interrupt, for event output and DMA
+	 *
+	 * Timer already runs in MFRQ mode with CC0 as TOP; overflow happens once each period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	false if timer is not a single compare interval
+	 */
+	bool uTimerLib::_freeRun() {
+		if (_type != UTIMERLIB_TYPE_INTERVAL || __overflows != 0) {
+			return false;
 		}
+		TC1->COUNT16.INTENCLR.reg = TC_INTENCLR_OVF | TC_INTENCLR_MC0;
+		return true;
+	}
 
-
-		TC1->COUNT16.INTENSET.reg = 0;
-		TC1->COUNT16.INTENSET.bit.OVF = 1;
-		// Enable InterruptVector
-		NVIC_EnableIRQ(TC1_IRQn);
-
-		// Count on event
-		//TC1->COUNT16.EVCTRL.bit.EVACT = TC_EVCTRL_EVACT_COUNT_Val;
-
+	/**
+	 * \brief Disconnects timer from EVSYS channel and user set by setEventOutput
+	 *
+	 * Note: This is device-dependant
+	 */
+	void uTimerLib::clearEventOutput() {
+		if (_evChannel == 0xFF) {
+			return;
+		}
+		TC1->COUNT16.CTRLA.bit.ENABLE = 0;
+		UTIMERLIB_WAIT_SYNC();
+		TC1->COUNT16.EVCTRL.reg &= ~TC_EVCTRL_OVFEO;
 		TC1->COUNT16.CTRLA.bit.ENABLE = 1;
+		EVSYS->USER[_evUser].reg = 0;
+		EVSYS->Channel[_evChannel].CHANNEL.reg = 0;
+		_evChannel = 0xFF;
 	}
 
-
+	/**
+	 * \brief Counts interval periods ended while callback ran, from pending overflow flag, and drops them
+	 *
+	 * Called after an interval callback. MFRQ restarts count by itself, so counter is already on periods grid;
+	 * hardware has one pending flag, so a callback longer than two periods is counted as one missed period.
+	 * Intervals counting several compares are not checked: a pending one is part of next period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		if (__overflows != 0 || !TC1->COUNT16.INTFLAG.bit.OVF) {
+			return 0;
+		}
+		TC1->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+		NVIC_ClearPendingIRQ(TC1_IRQn);
+		return 1;
+	}
 
 	/**
-	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
+	 * \brief Sets timer interrupt NVIC priority, so it can preempt communication stacks (USB, SERCOM...) or be preempted by them
+	 *
+	 * It's kept for next setXXX calls. With UTIMERLIB_BASEPRI, library critical sections only mask up to this priority.
 	 *
 	 * Note: This is device-dependant
+	 *
+	 * @param	priority	NVIC priority, 0 is highest; up to 7
 	 */
-	void uTimerLib::_loadRemaining() {
-		TC1->COUNT16.COUNT.reg = _remaining;
+	void uTimerLib::setPriority(uint8_t priority) {
+		if (priority >= (1 << __NVIC_PRIO_BITS)) {
+			priority = (1 << __NVIC_PRIO_BITS) - 1;
+		}
+		_priority = priority;
+		NVIC_SetPriority(TC1_IRQn, priority);
 	}
 
 	/**
@@ -211,11 +381,13 @@
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
+		unsigned char generation = _cancel();
 		_type = UTIMERLIB_TYPE_OFF;
 
-		TC1->COUNT16.INTENSET.reg = 0;
+		TC1->COUNT16.INTENCLR.reg = TC_INTENCLR_MASK;
 		// Disable InterruptVector
 		NVIC_DisableIRQ(TC1_IRQn);
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
 	}
 
 	/**
@@ -223,33 +395,34 @@
 	 *
 	 * As timers doesn't give us enougth flexibility for large timings,
 	 * this function implements oferflow control to offer user desired timings.
+	 *
+	 * It's called on each overflow, when hardware has just loaded running period TOP from CCBUF0, and loads next one to it.
 	 */
 	void uTimerLib::_interrupt() {
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
 		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
-		if (_overflows > 0) {
-			_overflows--;
-		}
-		if (_overflows == 0 && _remaining > 0) {
-				// Load remaining count to counter
-				_loadRemaining();
-				// And clear remaining count
-				_remaining = 0;
-		} else if (_overflows == 0 && _remaining == 0) {
+		bool done = (_overflows == 0); // Last period has ended
+		if (done) {
 			if (_type == UTIMERLIB_TYPE_TIMEOUT) {
 				clearTimer();
-			} else if (_type == UTIMERLIB_TYPE_INTERVAL) {
-				if (__overflows == 0) {
-					_remaining = __remaining;
-					_loadRemaining();
-					_remaining = 0;
-				} else {
-					_overflows = __overflows;
-					_remaining = __remaining;
-				}
+				_dispatch(_current()); // Own clear, not a cancel
+				return;
 			}
-			_cb();
+			_overflows = __overflows;
+		} else {
+			_overflows--;
+		}
+		// Period after running one is last one if it's followed by no more: one tick more each time fraction adds up to one
+		if (_overflows == 1 || (_overflows == 0 && __overflows == 0)) {
+			_remaining = __remaining + _fraction();
+		} else {
+			_remaining = 0xFFFE;
+		}
+		_loadRemaining();
+		if (done) {
+			_dispatch(generation);
 		}
 	}
 
@@ -267,16 +440,16 @@
 	/**
 	 * \brief Attach Interrupts using internal functionality
 	 *
+	 * No fast path, as on AVR, SAM and SAMD21: each period _interrupt() loads TOP of the one after it to CCBUF0.
+	 *
 	 * Note: This is device-dependant
 	 */
 	void TC1_Handler() {
 		if (TC1->COUNT16.INTFLAG.bit.OVF == 1) {
-			TC1->COUNT16.INTENSET.bit.OVF = 1;  // Clear flag
+			TC1->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;  // Clear flag
 			TimerLib._interrupt();
 		}
-		if (TC1->COUNT16.INTFLAG.bit.MC0 == 1) {
-			TC1->COUNT16.INTENSET.bit.MC0 = 1;  // Clear flag
-		}
+		TC1->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;  // Compare is not used: clear flag
 	}
 
 #endif
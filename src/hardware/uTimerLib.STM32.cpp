@@ -34,6 +34,29 @@
 	#define _uTimerLib_IMP_
 	#include "uTimerLib.cpp"
 
+	// ST's Arduino Core STM32, https://github.com/stm32duino/Arduino_Core_STM32
+	#ifdef BOARD_NAME
+		/**
+		 * \brief Timer3 channel used for input capture
+		 */
+		static uint32_t _uTimerLibCaptureChannel = 0;
+
+		/**
+		 * \brief Input capture interrupt: timestamp, extended with overflows
+		 */
+		static void _uTimerLibCaptureInterrupt() {
+			// CCR1 to CCR4 are consecutive
+			TimerLib._capture((&TIM3->CCR1)[_uTimerLibCaptureChannel - 1], TIM3->SR & TIM_SR_UIF);
+		}
+
+		/**
+		 * \brief Input capture overflow interrupt
+		 */
+		static void _uTimerLibCaptureOverflow() {
+			TimerLib._captureOverflow();
+		}
+	#endif
+
 	/**
 	 * \brief Sets up the timer, calculation variables and interrupts for desired ms microseconds
 	 *
@@ -41,16 +64,24 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) {
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) {
 		if (us == 0) { // Not valid
 			return;
 		}
 
+		// Timer reaches about 1 minute in one period: longer timings are split in equal periods up to 10s (rounded down to us)
+		unsigned long int periods = (us + 9999999) / 10000000;
+		us /= periods;
+		if (periods == 1) {
+			periods = 0;
+		}
+
 		// STM32, all variants - Max us is: uint32 max / CYCLES_PER_MICROSECOND
 		// ST's Arduino Core STM32, https://github.com/stm32duino/Arduino_Core_STM32
 		#ifdef BOARD_NAME
 			Timer3->setMode(1, TIMER_OUTPUT_COMPARE);
-			__overflows = _overflows = __remaining = _remaining = 0;
+			__overflows = _overflows = periods;
+			__remaining = _remaining = 0;
 			Timer3->setOverflow(us, MICROSEC_FORMAT);
 			Timer3->setCaptureCompare(1, us - 1, MICROSEC_COMPARE_FORMAT);
 			if (_toInit) {
@@ -62,7 +93,8 @@
 		// Roger Clark Arduino STM32, https://github.com/rogerclarkmelbourne/Arduino_STM32
 		#else
 			Timer3.setMode(TIMER_CH1, TIMER_OUTPUTCOMPARE);
-			__overflows = _overflows = __remaining = _remaining = 0;
+			__overflows = _overflows = periods;
+			__remaining = _remaining = 0;
 			uint16_t timerOverflow = Timer3.setPeriod(us);
 			Timer3.setCompare(TIMER_CH1, timerOverflow);
 			if (_toInit) {
@@ -118,6 +150,119 @@
 	}
 
 
+	/**
+	 * \brief Starts counting last timing from now: resets counter and periods count, with timer already set up
+	 *
+	 * Used by restart(). No loops nor waits: some register writes.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	true
+	 */
+	bool uTimerLib::_restart() {
+		unsigned long int state = _lock(); // Timer interrupt reads periods count together with counter it goes with
+		_overflows = __overflows;
+		_remaining = __remaining;
+
+		// ST's Arduino Core STM32, https://github.com/stm32duino/Arduino_Core_STM32
+		#ifdef BOARD_NAME
+			Timer3->setCount(0);
+			Timer3->resume();
+
+		// Roger Clark Arduino STM32, https://github.com/rogerclarkmelbourne/Arduino_STM32
+		#else
+			Timer3.refresh();
+			Timer3.resume();
+		#endif
+		_unlock(state);
+		return true;
+	}
+
+	/**
+	 * \brief Gives running count of current interval, started on its last compare, a new length in timer ticks
+	 *
+	 * Not available on this device: Timer3 prescaler and period are set by core from microseconds.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	ticks	Timer ticks
+	 * @return	false
+	 */
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		return false;
+	}
+
+	/**
+	 * \brief Microseconds in timer ticks of current interval prescaler
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	0, counts can't be reloaded
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		return 0;
+	}
+
+
+
+	/**
+	 * \brief Drives pin directly from timer compare output
+	 *
+	 * Not available on this device: Timer3 channels pin mapping depends on each board.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false, so pin is toggled by interrupt
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) {
+		return false;
+	}
+
+
+	/**
+	 * \brief Sets up timer for input capture on pin: Timer3 free running at 1MHz
+	 *
+	 * Only on ST's core; pin must be a Timer3 channel (see board PinMap_TIM).
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false if pin is not a Timer3 channel
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) {
+		// ST's Arduino Core STM32, https://github.com/stm32duino/Arduino_Core_STM32
+		#ifdef BOARD_NAME
+			PinName name = digitalPinToPinName(pin);
+			if (pinmap_peripheral(name, PinMap_TIM) != TIM3) {
+				return false;
+			}
+			_uTimerLibCaptureChannel = STM_PIN_CHANNEL(pinmap_function(name, PinMap_TIM));
+			_cbCapture = cb;
+			_timeType = UTIMERLIB_TYPE_OFF; // Timer set up is lost for restart()
+			_overflows = 0;
+			Timer3->setMode(_uTimerLibCaptureChannel, (edge == RISING) ? TIMER_INPUT_CAPTURE_RISING : TIMER_INPUT_CAPTURE_FALLING, pin);
+			Timer3->setPrescaleFactor(Timer3->getTimerClkFreq() / 1000000);
+			Timer3->setOverflow(0x10000); // Ticks
+			Timer3->attachInterrupt(_uTimerLibCaptureChannel, _uTimerLibCaptureInterrupt);
+			Timer3->attachInterrupt(_uTimerLibCaptureOverflow);
+			_toInit = true; // Channel 1 interrupt has to be attached again for timers
+			Timer3->resume();
+			*hz = 1000000;
+			return true;
+
+		// Roger Clark Arduino STM32, https://github.com/rogerclarkmelbourne/Arduino_STM32
+		#else
+			return false;
+		#endif
+	}
+
 
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
@@ -126,22 +271,61 @@
 	 */
 	void uTimerLib::_loadRemaining() { }
 
+	/**
+	 * \brief Counts interval periods ended while callback ran, from pending channel 1 compare flag, and drops them
+	 *
+	 * Called after an interval callback. Timer3 update restarts count by itself, so counter is already on periods grid;
+	 * hardware has one pending flag, so a callback longer than two periods is counted as one missed period.
+	 * Intervals counting several periods (longer than 10s) are not checked: a pending one is part of next period.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	Missed periods
+	 */
+	unsigned long int uTimerLib::_missed() {
+		// ST's Arduino Core STM32, https://github.com/stm32duino/Arduino_Core_STM32
+		#ifdef BOARD_NAME
+			if (__overflows != 0 || !(TIM3->SR & TIM_SR_CC1IF)) {
+				return 0;
+			}
+			TIM3->SR = ~TIM_SR_CC1IF; // Flags are cleared writing 0
+			NVIC_ClearPendingIRQ(TIM3_IRQn);
+
+		// Roger Clark Arduino STM32, https://github.com/rogerclarkmelbourne/Arduino_STM32
+		#else
+			timer_dev *dev = Timer3.c_dev();
+			if (__overflows != 0 || !(dev->regs.gen->SR & TIMER_SR_CC1IF)) {
+				return 0;
+			}
+			dev->regs.gen->SR = ~TIMER_SR_CC1IF; // Flags are cleared writing 0; interrupt handler checks them
+		#endif
+		return 1;
+	}
+
 	/**
 	 * \brief Clear timer interrupts
 	 *
 	 * Note: This is device-dependant
 	 */
 	void uTimerLib::clearTimer() {
+		unsigned char generation = _cancel();
 		_type = UTIMERLIB_TYPE_OFF;
 
 		// ST's Arduino Core STM32, https://github.com/stm32duino/Arduino_Core_STM32
 		#ifdef BOARD_NAME
 			Timer3->pause();
+			if (_cbCapture != NULL) {
+				Timer3->detachInterrupt();
+				Timer3->detachInterrupt(_uTimerLibCaptureChannel);
+				Timer3->setMode(_uTimerLibCaptureChannel, TIMER_DISABLED);
+				_cbCapture = NULL;
+			}
 
 		// Roger Clark Arduino STM32, https://github.com/rogerclarkmelbourne/Arduino_STM32
 		#else
 			Timer3.pause();
 		#endif
+		_trace(UTIMERLIB_TRACE_CANCEL, generation);
 	}
 
 	/**
@@ -151,6 +335,7 @@
 	 * this function implements oferflow control to offer user desired timings.
 	 */
 	void uTimerLib::_interrupt() {
+		unsigned char generation = _current(); // Any clear or new timer from now on cancels this call
 		if (_type == UTIMERLIB_TYPE_OFF) { // Should not happen
 			return;
 		}
@@ -161,8 +346,9 @@
 			_overflows = __overflows;
 			if (_type == UTIMERLIB_TYPE_TIMEOUT) {
 				clearTimer();
+				generation = _current(); // Own clear, not a cancel
 			}
-			_cb();
+			_dispatch(generation);
 		}
 	}
 
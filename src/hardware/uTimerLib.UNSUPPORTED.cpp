@@ -41,7 +41,7 @@
 	 *
 	 * @param	us		Desired timing in microseconds
 	 */
-	void uTimerLib::_attachInterrupt_us(unsigned long int us) { }
+	void uTimerLib::_attachInterrupt_us(unsigned long long int us) { }
 
 
 	/**
@@ -55,6 +55,75 @@
 
 
 
+	/**
+	 * \brief Drives pin directly from timer compare output
+	 *
+	 * Not available on this device: device not supported.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to drive
+	 * @param	us		Toggle interval (high == 0) or PWM period, in microseconds
+	 * @param	high	PWM high time in microseconds; 0 for toggle
+	 * @return	false, so pin is toggled by interrupt
+	 */
+	bool uTimerLib::_attachOutput_us(uint8_t pin, unsigned long int us, unsigned long int high) { return false; }
+
+
+	/**
+	 * \brief Sets up timer for input capture on pin
+	 *
+	 * Not available on this device: device not supported.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	pin		Pin to capture
+	 * @param	edge	RISING or FALLING
+	 * @param	cb		Function receiving each 32 bit timestamp
+	 * @param	hz		Timestamps frequency, in Hz
+	 * @return	false
+	 */
+	bool uTimerLib::_attachCapture(uint8_t pin, uint8_t edge, void (* cb)(uint32_t), unsigned long int *hz) { return false; }
+
+
+	/**
+	 * \brief Starts counting last timing from now, with timer already set up
+	 *
+	 * Not available on this device: device not supported.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	false, so timing is set up again
+	 */
+	bool uTimerLib::_restart() { return false; }
+
+	/**
+	 * \brief Gives running count of current interval, started on its last compare, a new length in timer ticks
+	 *
+	 * Not available on this device: there's no timer.
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	ticks	Timer ticks
+	 * @return	false
+	 */
+	bool uTimerLib::_reload(unsigned long int ticks) {
+		return false;
+	}
+
+	/**
+	 * \brief Microseconds in timer ticks of current interval prescaler
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @param	us		Microseconds
+	 * @return	0, counts can't be reloaded
+	 */
+	unsigned long int uTimerLib::_reloadTicks(unsigned long int us) {
+		return 0;
+	}
+
+
 	/**
 	 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
 	 *
@@ -62,6 +131,17 @@
 	 */
 	void uTimerLib::_loadRemaining() { }
 
+	/**
+	 * \brief Counts interval periods ended while callback ran, and drops them
+	 *
+	 * Note: This is device-dependant
+	 *
+	 * @return	0, no timer
+	 */
+	unsigned long int uTimerLib::_missed() {
+		return 0;
+	}
+
 	/**
 	 * \brief Clear timer interrupts
 	 *
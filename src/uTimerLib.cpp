@@ -49,6 +49,42 @@
                     _instance = this;
                     clearTimer();
             #endif
+            #if defined(ARDUINO_ARCH_AVR) && defined(CLKPR)
+                    _clkpsBoot = CLKPR & 0x0F; // F_CPU is the clock with this prescaler
+            #endif
+    }
+
+    /**
+     * \brief Internal: cancels any _interrupt() already running, incrementing _generation, with no lock
+     *
+     * ESP32 uses an atomic add, as both cores may clear timer at once; Cortex-M3/M4 (SAM, SAMD51, most STM32) too (LDREXB/STREXB).
+     * Elsewhere (AVR, SAMD21...) a plain byte increment is enough: a context preempting it between read and write runs to its end
+     * before it, with any _interrupt() started meanwhile, so two clears giving one increment can't leave an _interrupt() running
+     * with a generation they should have cancelled.
+     *
+     * @return	New generation
+     */
+    inline unsigned char uTimerLib::_cancel() {
+            #if defined(ARDUINO_ARCH_ESP32) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+                    return __atomic_add_fetch(&_generation, 1, __ATOMIC_ACQ_REL);
+            #else
+                    unsigned char generation = _generation + 1;
+                    _generation = generation;
+                    return generation;
+            #endif
+    }
+
+    /**
+     * \brief Internal: current _generation; on ESP32 an acquire load, pairing with _cancel() on other core
+     *
+     * @return	Current generation
+     */
+    inline unsigned char uTimerLib::_current() {
+            #if defined(ARDUINO_ARCH_ESP32)
+                    return __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+            #else
+                    return _generation;
+            #endif
     }
 
     /**
@@ -61,6 +97,11 @@
             clearTimer();
             _cb = cb;
             _type = UTIMERLIB_TYPE_INTERVAL;
+            _timeType = UTIMERLIB_TYPE_INTERVAL;
+            _time = us;
+            _timeS = false;
+            _timeDen = 0;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
             _attachInterrupt_us(us);
     }
 
@@ -75,6 +116,11 @@
             clearTimer();
             _cb = cb;
             _type = UTIMERLIB_TYPE_TIMEOUT;
+            _timeType = UTIMERLIB_TYPE_TIMEOUT;
+            _time = us;
+            _timeS = false;
+            _timeDen = 0;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
             _attachInterrupt_us(us);
     }
 
@@ -89,6 +135,11 @@
             clearTimer();
             _cb = cb;
             _type = UTIMERLIB_TYPE_INTERVAL;
+            _timeType = UTIMERLIB_TYPE_INTERVAL;
+            _time = s;
+            _timeS = true;
+            _timeDen = 0;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
             _attachInterrupt_s(s);
     }
 
@@ -103,9 +154,1020 @@
             clearTimer();
             _cb = cb;
             _type = UTIMERLIB_TYPE_TIMEOUT;
+            _timeType = UTIMERLIB_TYPE_TIMEOUT;
+            _time = s;
+            _timeS = true;
+            _timeDen = 0;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
             _attachInterrupt_s(s);
     }
 
+    /**
+     * \brief Attaches a callback function to be executed each ms miliseconds
+     *
+     * Up to 49 days. On ESP8266 it maps 1:1 to Ticker miliseconds.
+     *
+     * @param	cb		Callback function to be called
+     * @param	ms		Interval in miliseconds
+     */
+    void uTimerLib::setInterval_ms(void (* cb)(), unsigned long int ms) {
+            clearTimer();
+            _cb = cb;
+            _type = UTIMERLIB_TYPE_INTERVAL;
+            _timeType = UTIMERLIB_TYPE_INTERVAL;
+            _time = (unsigned long long int) ms * 1000; // Same timing, set again in microseconds
+            _timeS = false;
+            _timeDen = 0;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
+            _attachInterrupt_ms(ms);
+    }
+
+
+    /**
+     * \brief Attaches a callback function to be executed once when ms miliseconds have passed
+     *
+     * Up to 49 days. On ESP8266 it maps 1:1 to Ticker miliseconds.
+     *
+     * @param	cb		Callback function to be called
+     * @param	ms		Timeout in miliseconds
+     */
+    void uTimerLib::setTimeout_ms(void (* cb)(), unsigned long int ms) {
+            clearTimer();
+            _cb = cb;
+            _type = UTIMERLIB_TYPE_TIMEOUT;
+            _timeType = UTIMERLIB_TYPE_TIMEOUT;
+            _time = (unsigned long long int) ms * 1000; // Same timing, set again in microseconds
+            _timeS = false;
+            _timeDen = 0;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
+            _attachInterrupt_ms(ms);
+    }
+
+
+    /**
+     * \brief Attaches a callback function to be executed each us microseconds, with a 64 bit duration for weeks or longer
+     *
+     * @param	cb		Callback function to be called
+     * @param	us		Interval in microseconds
+     */
+    void uTimerLib::setInterval_us64(void (* cb)(), uint64_t us) {
+            clearTimer();
+            _cb = cb;
+            _type = UTIMERLIB_TYPE_INTERVAL;
+            _timeType = UTIMERLIB_TYPE_INTERVAL;
+            _time = us;
+            _timeS = false;
+            _timeDen = 0;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
+            _attachInterrupt_us(us);
+    }
+
+
+    /**
+     * \brief Attaches a callback function to be executed once when us microseconds have passed, with a 64 bit duration for weeks or longer
+     *
+     * @param	cb		Callback function to be called
+     * @param	us		Timeout in microseconds
+     */
+    void uTimerLib::setTimeout_us64(void (* cb)(), uint64_t us) {
+            clearTimer();
+            _cb = cb;
+            _type = UTIMERLIB_TYPE_TIMEOUT;
+            _timeType = UTIMERLIB_TYPE_TIMEOUT;
+            _time = us;
+            _timeS = false;
+            _timeDen = 0;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
+            _attachInterrupt_us(us);
+    }
+
+    /**
+     * \brief Attaches a callback function to be executed hz / den times each second
+     *
+     * Rate doesn't need to match timer clock: each period is one whole timer tick or the next one,
+     * alternated so average rate is exact, e.g. 44100Hz or 1000 / 3 Hz (a jitter of one tick at most).
+     * On ESP32, ESP8266, STM32 and SAM period is rounded to microseconds (miliseconds on ESP8266).
+     *
+     * @param	cb		Callback function to be called
+     * @param	hz		Rate numerator, in Hz
+     * @param	den		Rate denominator; 1 by default
+     */
+    void uTimerLib::setInterval_hz(void (* cb)(), unsigned long int hz, unsigned long int den) {
+            clearTimer();
+            if (hz == 0 || den == 0) { // Not valid
+                    return;
+            }
+            _cb = cb;
+            _type = UTIMERLIB_TYPE_INTERVAL;
+            _timeType = UTIMERLIB_TYPE_INTERVAL;
+            _time = hz;
+            _timeS = false;
+            _timeDen = den;
+            _trace(UTIMERLIB_TRACE_ARM, _type);
+            _attachInterrupt_hz(hz, den);
+    }
+
+    /**
+     * \brief Sets up the timer for a rate of hz / den Hz
+     *
+     * @param	hz		Rate numerator, in Hz
+     * @param	den		Rate denominator
+     */
+    void uTimerLib::_attachInterrupt_hz(unsigned long int hz, unsigned long int den) {
+            #if defined(ARDUINO_ARCH_AVR)
+                    _attachInterrupt_cycles((unsigned long long int) _clockHz * den, hz);
+            #elif defined(_SAMD21_) || defined(__SAMD51__)
+                    _attachInterrupt_cycles((unsigned long long int) F_CPU * den, hz);
+            #else
+                    _attachInterrupt_us(((unsigned long long int) den * 1000000 + hz / 2) / hz); // Rounded to microseconds
+            #endif
+    }
+
+    /**
+     * \brief Sets up the timer for ms miliseconds, with no microseconds intermediate on devices counting CPU cycles
+     *
+     * @param	ms		Timing in miliseconds
+     */
+    void uTimerLib::_attachInterrupt_ms(unsigned long int ms) {
+            if (ms == 0) { // Not valid
+                    return;
+            }
+            #if defined(ARDUINO_ARCH_AVR)
+                    _attachInterrupt_cycles((unsigned long long int) ms * _clockHz, 1000);
+            #elif defined(_SAMD21_) || defined(__SAMD51__)
+                    _attachInterrupt_cycles((unsigned long long int) ms * F_CPU, 1000);
+            #else
+                    _attachInterrupt_us((unsigned long long int) ms * 1000); // Exact: ESP8266 gets back same ms for its Ticker
+            #endif
+    }
+
+    /**
+     * \brief Sets last interval or timeout again, from now
+     */
+    void uTimerLib::_rearm() {
+            unsigned char type = _type;
+            if (type != UTIMERLIB_TYPE_INTERVAL && type != UTIMERLIB_TYPE_TIMEOUT) {
+                    return;
+            }
+            clearTimer();
+            _type = type;
+            _trace(UTIMERLIB_TRACE_ARM, type);
+            if (_timeDen != 0) {
+                    _attachInterrupt_hz(_time, _timeDen);
+            } else if (_timeS) {
+                    _attachInterrupt_s(_time);
+            } else {
+                    _attachInterrupt_us(_time);
+            }
+    }
+
+    /**
+     * \brief Sets last interval or timeout again, from now, with no timer set up: e.g. to retrigger a timeout from its callback
+     *
+     * Only timer counter and interrupt are reloaded, as prescaler and clock are kept from last setXXX call, so period is kept too:
+     * a new one may need another prescaler, a full set up (setXXX), so there's no rearm(period).
+     * It can be called from callbacks and interrupts and takes a bounded time, with no loops nor waits. Whole call, trace off,
+     * counted from source and instruction timings (not measured), upper bounds:
+     *		* AVR: about 150 cycles (10us at 16MHz); while now_ticks() clock runs, about 350 more for its 64 bit fold
+     *		  (libgcc shift by prescaler, up to 18 steps).
+     *		* ATtiny and Digispark: about 80 cycles.
+     *		* SAM: about 150 cycles (2us at 84MHz).
+     *		* SAMD21: about 200 cycles (4us at 48MHz), hardware stalls of back to back synchronized register writes included.
+     *		* SAMD51: about 150 cycles (1.3us at 120MHz); each synchronized register is written once, so there's no stall.
+     *		* STM32: about 200 cycles, in core timer calls.
+     *		* ESP32: an esp_timer stop and start, each a critical section linear in the number of esp_timers armed.
+     *		* ESP8266: a Ticker (os_timer) disarm and arm, linear in the number of os_timers armed.
+     * A callback already running is not repeated by overrun policy.
+     *
+     * Nothing is done if no timing has been set yet or timer has been used for pin output or input capture since.
+     */
+    void uTimerLib::restart() {
+            unsigned char type = _timeType;
+            if (type == UTIMERLIB_TYPE_OFF || _time == 0) {
+                    return;
+            }
+            // Single core devices take no lock here: _cancel() needs none and each _restart() masks what timer interrupt must not see half loaded
+            #if defined(ARDUINO_ARCH_ESP32)
+                    unsigned long int state = _lock(); // Other core may clear or set timer meanwhile: type and esp_timer change together
+            #endif
+            _cancel();
+            _type = type;
+            bool restarted = _restart();
+            #if defined(ARDUINO_ARCH_ESP32)
+                    _unlock(state);
+            #endif
+            if (restarted) {
+                    _trace(UTIMERLIB_TRACE_ARM, type);
+            } else { // No fast path on this device
+                    _rearm();
+            }
+    }
+
+    #if defined(ARDUINO_ARCH_AVR)
+            /**
+             * \brief Re-derives running timer after system clock prescaler (CLKPR) has been changed, so its timing stays right
+             *
+             * Interval or timeout is set again from now (a timeout restarts). Pin output and input capture have to be set again.
+             */
+            void uTimerLib::clockChanged() {
+                    #ifdef CLKPR
+                            unsigned char clkps = CLKPR & 0x0F;
+                            _clockHz = (clkps >= _clkpsBoot) ? (F_CPU >> (clkps - _clkpsBoot)) : (F_CPU << (_clkpsBoot - clkps));
+                            #if defined(UTIMERLIB_NOW_TIMER)
+                                    _nowClock();
+                            #endif
+                    #endif
+                    _rearm();
+            }
+
+            /**
+             * \brief Changes system clock prescaler (CLKPR) and re-derives running timer
+             *
+             * Note: Arduino millis(), micros() and delay() don't follow system clock changes; now_ticks() and now_us() do.
+             *
+             * @param	clkps	CLKPS bits value: system clock is divided by 2^clkps
+             */
+            void uTimerLib::setClockPrescaler(unsigned char clkps) {
+                    #ifdef CLKPR
+                            unsigned long int state = _lock(); // Timed CLKPR sequence, and now_ticks() clock moved to new clock with it
+                            #if defined(UTIMERLIB_NOW_TIMER)
+                                    _nowFold(); // now_ticks() counted at previous clock
+                            #endif
+                            CLKPR = (1 << CLKPCE);	// Timed sequence: enable change
+                            CLKPR = clkps & 0x0F;	// and set it in 4 cycles
+                            #if defined(UTIMERLIB_NOW_TIMER)
+                                    _nowClock();
+                            #endif
+                            _unlock(state);
+                    #endif
+                    clockChanged();
+            }
+
+    #endif
+
+    #if defined(ARDUINO_ARCH_AVR) || defined(_SAMD21_) || defined(__SAMD51__)
+            /**
+             * \brief Converts desired timing to timer ticks, with smallest prescaler that fits it in max ticks (or largest one if none)
+             *
+             * @param	cycles	Desired timing in CPU cycles
+             * @param	shifts	Timer prescalers as powers of 2
+             * @param	count	Number of prescalers
+             * @param	max		Maximum ticks in one count
+             * @param	ticks	Resulting ticks, rounded; greater than max if it doesn't fit
+             * @return	Position + 1 of prescaler used (CS bits value on AVR)
+             */
+            unsigned char uTimerLib::_prescale(unsigned long long int cycles, const unsigned char *shifts, unsigned char count, unsigned long int max, unsigned long long int *ticks) {
+                    unsigned char i;
+                    for (i = 0; i < count; i++) {
+                            *ticks = (cycles + ((1UL << shifts[i]) >> 1)) >> shifts[i]; // + half divisor is round for positive numbers
+                            if (*ticks <= max) {
+                                    break;
+                            }
+                    }
+                    if (i == count) {
+                            i--;
+                    }
+                    if (*ticks == 0) {
+                            *ticks = 1;
+                    }
+                    return i + 1;
+            }
+
+            /**
+             * \brief Converts a period of num / den timer ticks to whole ticks, keeping the fraction for _fraction()
+             *
+             * @param	num		Period numerator, in timer ticks
+             * @param	den		Period denominator
+             * @return	Whole ticks (floor), at least one
+             */
+            unsigned long long int uTimerLib::_ticks(unsigned long long int num, unsigned long long int den) {
+                    if (den > 0xFFFFFFFF) { // Reduce fraction, so accumulator works in 32 bits
+                            unsigned long long int a = num, b = den, t;
+                            while (b != 0) {
+                                    t = a % b;
+                                    a = b;
+                                    b = t;
+                            }
+                            num /= a;
+                            den /= a;
+                            while (den > 0xFFFFFFFF) { // Still too big, fraction is approximated
+                                    num >>= 1;
+                                    den >>= 1;
+                            }
+                    }
+                    if (num < den) { // At least one tick
+                            _fracRem = 0;
+                            return 1;
+                    }
+                    _fracRem = num % den;
+                    _fracDen = den;
+                    _fracErr = 0;
+                    return num / den;
+            }
+
+            /**
+             * \brief Bresenham accumulator: adds period fraction to error, called once each period
+             *
+             * @return	true if error reached a whole tick, so this period has to be one tick longer
+             */
+            bool uTimerLib::_fraction() {
+                    if (_fracRem == 0) {
+                            return false;
+                    }
+                    if (_fracErr >= _fracDen - _fracRem) {
+                            _fracErr -= _fracDen - _fracRem;
+                            return true;
+                    }
+                    _fracErr += _fracRem;
+                    return false;
+            }
+    #endif
+
+
+    #if defined(UTIMERLIB_FAST_PATH)
+            /**
+             * \brief Selects interrupt fast path when timer has just been armed as a pure single compare interval
+             *
+             * That's an interval of one timer count, with no overflows to count, no tick fraction to add,
+             * no overrun policy and a callback: then interrupt only clears its flag and calls callback,
+             * with no _interrupt() branches nor _dispatch(). Timer interrupt must be disabled while calling it.
+             * Not while now_ticks() clock is started, as it counts on each interrupt (_nowWrap()); _nowStart() leaves it.
+             *
+             * @return	true if fast path is used
+             */
+            bool uTimerLib::_fastPath() {
+                    _fastCb = NULL;
+                    if (_type != UTIMERLIB_TYPE_INTERVAL || __overflows != 0 || _cb == NULL || _overrunPolicy != UTIMERLIB_OVERRUN_NONE) {
+                            return false;
+                    }
+                    #if defined(UTIMERLIB_TRACE)
+                            return false; // Trace is recorded on _interrupt() and _dispatch()
+                    #endif
+                    #if defined(UTIMERLIB_NOW_TIMER)
+                            if (_nowOn) { // now_ticks() clock counts on regular path
+                                    return false;
+                            }
+                    #endif
+                    #if defined(ARDUINO_ARCH_AVR) || defined(_SAMD21_)
+                            if (_fracRem != 0) {
+                                    return false;
+                            }
+                    #endif
+                    _fastCb = _cb;
+                    return true;
+            }
+    #endif
+
+
+    /**
+     * \brief Toggles a pin each us microseconds, a square wave of 2 * us period
+     *
+     * If pin is a compare output of the timer used, it's driven by timer hardware with no CPU usage.
+     * If not, it's toggled by timer interrupt.
+     *
+     * @param	pin		Pin to toggle
+     * @param	us		Toggle interval in microseconds
+     * @return	true if pin is driven by hardware, false if it's toggled by interrupt
+     */
+    bool uTimerLib::setToggle_us(uint8_t pin, unsigned long int us) {
+            clearTimer();
+            _timeType = UTIMERLIB_TYPE_OFF;
+            pinMode(pin, OUTPUT);
+            if (_attachOutput_us(pin, us, 0)) {
+                    _outputPin = pin;
+                    return true;
+            }
+            _pin = pin;
+            setInterval_us(uTimerLib::_toggle, us);
+            return false;
+    }
+
+
+    /**
+     * \brief Outputs a PWM signal on a pin, driven by timer hardware with no CPU usage
+     *
+     * Only available on compare output pins of the timer used; see README.
+     *
+     * @param	pin		Pin to drive
+     * @param	period	PWM period in microseconds
+     * @param	high	High time in microseconds, greater than 0 and lower than period
+     * @return	false if pin can't be driven by timer or timing is not valid
+     */
+    bool uTimerLib::setPwm_us(uint8_t pin, unsigned long int period, unsigned long int high) {
+            clearTimer();
+            _timeType = UTIMERLIB_TYPE_OFF;
+            if (high == 0 || high >= period) {
+                    return false;
+            }
+            pinMode(pin, OUTPUT);
+            if (!_attachOutput_us(pin, period, high)) {
+                    return false;
+            }
+            _outputPin = pin;
+            return true;
+    }
+
+
+    /**
+     * \brief Internal callback toggling pin when timer can't drive it
+     */
+    void uTimerLib::_toggle() {
+            digitalWrite(TimerLib._pin, !digitalRead(TimerLib._pin));
+    }
+
+
+    /**
+     * \brief Internal: timestamps a captured edge, extending 16 bit capture value with overflows count
+     *
+     * @param	value			Captured counter value
+     * @param	overflowPending	Timer overflow happened but it's not counted yet
+     */
+    void uTimerLib::_capture(uint16_t value, bool overflowPending) {
+            unsigned long int high = _overflows;
+            if (overflowPending && value < 0x8000) { // Captured after that overflow
+                    high++;
+            }
+            if (_cbCapture != NULL) {
+                    _cbCapture((high << 16) | value);
+            }
+    }
+
+
+    /**
+     * \brief Internal: counts a timer overflow in input capture mode
+     */
+    void uTimerLib::_captureOverflow() {
+            _overflows++;
+    }
+
+
+    /**
+     * \brief Sets what to do when an interval callback runs longer than its period
+     *
+     * Missed ticks are detected after callback from timer hardware (pending interrupt flag and counter) and counted in getOverruns().
+     * Timer keeps one pending flag, so on AVR, ATtiny, SAM, SAMD and STM32 a callback longer than two periods may be counted short;
+     * ESP32 and ESP8266 count them from esp_timer and micros64(). Only intervals of a single timer count are checked.
+     * Policies:
+     *  - UTIMERLIB_OVERRUN_NONE: no detection; a late interrupt may fire just after callback (default)
+     *  - UTIMERLIB_OVERRUN_SKIP: missed ticks are dropped
+     *  - UTIMERLIB_OVERRUN_CATCHUP: callback is called once for each missed tick, in a burst
+     *  - UTIMERLIB_OVERRUN_COALESCE: missed ticks are coalesced into one call to cbOverrun with missed count (or to callback if NULL)
+     *
+     * Also resets overruns counter. All of it is changed in one critical section, so interrupt doesn't see half of it
+     * (a 32 bit counter is written in four steps on AVR) nor adds to a counter already reset.
+     *
+     * @param	policy		Overrun policy
+     * @param	cbOverrun	Function to be called with missed count on UTIMERLIB_OVERRUN_COALESCE
+     */
+    void uTimerLib::setOverrunPolicy(unsigned char policy, void (* cbOverrun)(unsigned long int)) {
+            unsigned long int state = _lock();
+            _overrunPolicy = policy;
+            _cbOverrun = cbOverrun;
+            _overruns = 0;
+            #if defined(UTIMERLIB_FAST_PATH)
+                    if (policy != UTIMERLIB_OVERRUN_NONE) { // Fast path doesn't measure callback; back on next setXXX call
+                            _fastCb = NULL;
+                    }
+            #endif
+            _unlock(state);
+    }
+
+    /**
+     * \brief Gets how many interval ticks have been missed because callback ran longer than its period
+     *
+     * Only counted when an overrun policy is set.
+     *
+     * @return	Missed ticks count
+     */
+    unsigned long int uTimerLib::getOverruns() {
+            unsigned long int state = _lock(); // Written by interrupt, in four steps on AVR
+            unsigned long int overruns = _overruns;
+            _unlock(state);
+            return overruns;
+    }
+
+    /**
+     * \brief Calls user callback, applying overrun policy
+     *
+     * Called from each device _interrupt() when callback is due. It's not called if timer
+     * has been cleared or set again (from other interrupt, other core or callback) since that
+     * _interrupt() started.
+     *
+     * @param	generation	_generation when _interrupt() started
+     * @param	late		Ticks of same timer ended before it, not dispatched yet (ESP32 pinned core task)
+     */
+    void uTimerLib::_dispatch(unsigned char generation, unsigned long int late) {
+            if (_current() != generation) { // Cancelled meanwhile
+                    return;
+            }
+            #if defined(ARDUINO_ARCH_ESP32)
+                    TaskHandle_t core = _coreTask;
+                    if (core == NULL || core != xTaskGetCurrentTaskHandle()) { // Fire is recorded once, before hand-off to pinned core task
+                            _trace(UTIMERLIB_TRACE_FIRE, generation);
+                    }
+                    if (core != NULL && core != xTaskGetCurrentTaskHandle()) { // Dispatch is pinned to a core: go on in its task
+                            unsigned long int state = _lock(); // Dispatch task takes both together
+                            if (_coreGeneration != generation) { // Ticks left from a cleared timer are dropped
+                                    _coreGeneration = generation;
+                                    _corePending = 0;
+                            }
+                            _corePending++;
+                            _unlock(state);
+                            xTaskNotifyGive(core);
+                            return;
+                    }
+            #else
+                    _trace(UTIMERLIB_TRACE_FIRE, generation);
+            #endif
+            #if defined(UTIMERLIB_FREERTOS)
+                    if (_notifyTask != NULL) {
+                            #if defined(ARDUINO_ARCH_ESP32)
+                                    do { // esp_timer callbacks run in its task; one notification per tick, late ones too
+                                            xTaskNotifyGive(_notifyTask);
+                                    } while (late-- > 0);
+                            #else
+                                    BaseType_t woken = pdFALSE;
+                                    vTaskNotifyGiveFromISR(_notifyTask, &woken);
+                                    portYIELD_FROM_ISR(woken);
+                            #endif
+                            return;
+                    }
+            #endif
+            if (_cb == NULL) { // No callback (event output only)
+                    return;
+            }
+            _callback();
+            if (_overrunPolicy == UTIMERLIB_OVERRUN_NONE) { // Late ticks are called each, as hardware would fire them
+                    for (; late > 0 && _current() == generation; late--) {
+                            _callback();
+                    }
+                    return;
+            }
+            if (_type != UTIMERLIB_TYPE_INTERVAL || _current() != generation) { // Or callback cleared or set again the timer
+                    return;
+            }
+            unsigned long int missed = _missed() + late; // Also drops them from hardware, so they're not fired late
+            if (missed == 0) {
+                    return;
+            }
+            unsigned long int state = _lock(); // On ESP32 it may run on a core while setOverrunPolicy() resets it on the other one
+            _overruns = _overruns + missed; // Not +=: compound assignment to volatile is deprecated in C++20
+            _unlock(state);
+            _trace(UTIMERLIB_TRACE_OVERRUN, (missed > 255) ? 255 : missed);
+
+            if (_overrunPolicy == UTIMERLIB_OVERRUN_CATCHUP) {
+                    for (; missed > 0 && _current() == generation; missed--) {
+                            _callback();
+                    }
+            } else if (_overrunPolicy == UTIMERLIB_OVERRUN_COALESCE) {
+                    if (_cbOverrun != NULL) {
+                            _cbOverrun(missed);
+                    } else {
+                            _callback();
+                    }
+            }
+    }
+
+    /**
+     * \brief Calls user callback, recording its start and end on trace
+     */
+    void uTimerLib::_callback() {
+            _trace(UTIMERLIB_TRACE_CB_START, 0);
+            _cb();
+            _trace(UTIMERLIB_TRACE_CB_END, 0);
+    }
+
+    #if defined(UTIMERLIB_TRACE)
+            /**
+             * \brief Prints hexadecimal value with leading zeros
+             */
+            static void _uTimerLibTraceHex(Print &out, unsigned long int value, unsigned char digits) {
+                    while (digits-- > 0) {
+                            out.write("0123456789abcdef"[(value >> (digits * 4)) & 0x0F]);
+                    }
+            }
+
+            /**
+             * \brief Stores trace record time, with release order
+             *
+             * AVR has no 32 bit atomic store, but it's single core: volatile accesses keep order with the other fields ones.
+             */
+            static inline void _uTimerLibTraceTimeStore(volatile unsigned long int *time, unsigned long int value) {
+                    #if defined(ARDUINO_ARCH_AVR)
+                            *time = value;
+                    #else
+                            __atomic_store_n(time, value, __ATOMIC_RELEASE);
+                    #endif
+            }
+
+            /**
+             * \brief Loads trace record time, with acquire order (volatile access on AVR, see _uTimerLibTraceTimeStore())
+             */
+            static inline unsigned long int _uTimerLibTraceTimeLoad(volatile unsigned long int *time) {
+                    #if defined(ARDUINO_ARCH_AVR)
+                            return *time;
+                    #else
+                            return __atomic_load_n(time, __ATOMIC_ACQUIRE);
+                    #endif
+            }
+
+            /**
+             * \brief Adds a record to trace ring; oldest one is overwritten when ring is full
+             *
+             * Lock free: record index is reserved with an atomic increment of _traceHead, record is filled and then published by its seq,
+             * so a record from an interrupt preempting another one, or from other core, takes next index. seq is cleared first and fields
+             * are release stores, so a reader seeing any new field sees seq changed too; traceDump() skips records being written.
+             * Pause check is not locked either: a record started before traceDump() paused tracing may be skipped.
+             *
+             * @param	event	UTIMERLIB_TRACE_* event
+             * @param	arg		Event argument
+             */
+            void uTimerLib::_trace(unsigned char event, unsigned char arg) {
+                    if (__atomic_load_n(&_tracePaused, __ATOMIC_RELAXED)) {
+                            return;
+                    }
+                    unsigned long int index = _traceReserve();
+                    TraceRecord *record = &_traceRing[index & (UTIMERLIB_TRACE_SIZE - 1)];
+                    __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED); // Being written
+                    _uTimerLibTraceTimeStore(&record->time, _traceTime(event));
+                    __atomic_store_n(&record->event, event, __ATOMIC_RELEASE);
+                    __atomic_store_n(&record->arg, arg, __ATOMIC_RELEASE);
+                    __atomic_store_n(&record->seq, (unsigned char) (((index / UTIMERLIB_TRACE_SIZE) << 1) | 1), __ATOMIC_RELEASE);
+            }
+
+            /**
+             * \brief Internal: reserves next trace record index
+             *
+             * ESP32 and Cortex-M3/M4 (SAM, SAMD51, most STM32) have an atomic increment (S32C1I, LDREX/STREX). AVR, Cortex-M0+ (SAMD21) and
+             * ESP8266 have none, so interrupts are masked only for the increment, a few instructions.
+             *
+             * @return	Index, counted since traceClear()
+             */
+            inline unsigned long int uTimerLib::_traceReserve() {
+                    #if defined(ARDUINO_ARCH_ESP32) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+                            return __atomic_fetch_add(&_traceHead, 1, __ATOMIC_RELAXED);
+                    #else
+                            unsigned long int state = _lock(); // No atomic increment: _traceHead is read and written with interrupts masked
+                            unsigned long int index = _traceHead;
+                            _traceHead = index + 1;
+                            _unlock(state);
+                            return index;
+                    #endif
+            }
+
+            /**
+             * \brief Internal: trace record timestamp, now_ticks() low 32 bits
+             *
+             * Where now_ticks() counts library timer (AVR, SAM, SAMD21), FIRE comes from timer interrupt, which has just added ended count
+             * to clock, so it's the time of that compare, with no counter read. Other events read now_ticks(), with no lock nor wait.
+             * There, clock is started by first arm, out of interrupts; records before have time 0.
+             *
+             * @param	event	UTIMERLIB_TRACE_* event
+             * @return	Timestamp
+             */
+            inline unsigned long int uTimerLib::_traceTime(unsigned char event) {
+                    #if defined(UTIMERLIB_NOW_TIMER)
+                            if (event == UTIMERLIB_TRACE_FIRE && _nowRun) {
+                                    return (unsigned long int) (_nowBase + _nowScale(_nowAcc)); // Counter was 0 on that compare
+                            }
+                            if (!_nowOn && event != UTIMERLIB_TRACE_ARM) {
+                                    return 0;
+                            }
+                    #endif
+                    return (unsigned long int) now_ticks();
+            }
+
+            /**
+             * \brief Prints trace ring, oldest record first; it can be called while timer runs
+             *
+             * Format, a line each, hexadecimal with no prefix (decoded by extras/uTimerLibTrace.py):
+             *		* uTimerLib trace 2 size written hz* : header; 2 is format version, size is UTIMERLIB_TRACE_SIZE, written the records written since traceClear()
+             *		  and hz UTIMERLIB_NOW_HZ, timestamps frequency.
+             *		* tttttttteeaa* : a record each, oldest first; tttttttt is now_ticks() low 32 bits when it happened, ee the UTIMERLIB_TRACE_* event and aa its argument.
+             *		* uTimerLib trace end* : end of dump.
+             *
+             * Only last size records are kept. Tracing is paused while printing, so events meanwhile are not recorded.
+             * No lock is taken: each record is copied between an acquire read of its seq and a second read, and skipped if it's being
+             * written or has been overwritten, so written count may be more than records printed.
+             *
+             * @param	out		Where to print, e.g. Serial
+             */
+            void uTimerLib::traceDump(Print &out) {
+                    __atomic_store_n(&_tracePaused, true, __ATOMIC_RELAXED);
+                    #if defined(ARDUINO_ARCH_ESP32) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+                            unsigned long int head = __atomic_load_n(&_traceHead, __ATOMIC_RELAXED);
+                    #else
+                            unsigned long int state = _lock(); // Incremented with interrupts masked, see _traceReserve()
+                            unsigned long int head = _traceHead;
+                            _unlock(state);
+                    #endif
+                    unsigned long int count = (head < UTIMERLIB_TRACE_SIZE) ? head : UTIMERLIB_TRACE_SIZE;
+                    out.print("uTimerLib trace 2 ");
+                    out.print((unsigned long int) UTIMERLIB_TRACE_SIZE, HEX);
+                    out.print(" ");
+                    out.print(head, HEX);
+                    out.print(" ");
+                    out.print((unsigned long int) UTIMERLIB_NOW_HZ, HEX);
+                    out.println();
+                    for (unsigned long int i = head - count; i != head; i++) {
+                            TraceRecord *slot = &_traceRing[i & (UTIMERLIB_TRACE_SIZE - 1)];
+                            unsigned char seq = (unsigned char) ((i / UTIMERLIB_TRACE_SIZE) << 1) | 1;
+                            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq) { // Being written, or overwritten by a later one
+                                    continue;
+                            }
+                            unsigned long int time = _uTimerLibTraceTimeLoad(&slot->time);
+                            unsigned char event = __atomic_load_n(&slot->event, __ATOMIC_ACQUIRE);
+                            unsigned char arg = __atomic_load_n(&slot->arg, __ATOMIC_ACQUIRE);
+                            if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) { // Written meanwhile
+                                    continue;
+                            }
+                            _uTimerLibTraceHex(out, time, 8);
+                            _uTimerLibTraceHex(out, event, 2);
+                            _uTimerLibTraceHex(out, arg, 2);
+                            out.println();
+                    }
+                    out.println("uTimerLib trace end");
+                    __atomic_store_n(&_tracePaused, false, __ATOMIC_RELAXED);
+            }
+
+            /**
+             * \brief Empties trace ring
+             */
+            void uTimerLib::traceClear() {
+                    for (unsigned int i = 0; i < UTIMERLIB_TRACE_SIZE; i++) { // Records before are not taken for new ones
+                            __atomic_store_n(&_traceRing[i].seq, 0, __ATOMIC_RELAXED);
+                    }
+                    _traceHead = 0;
+            }
+    #endif
+
+    #if defined(UTIMERLIB_FREERTOS)
+            /**
+             * \brief Notifies a FreeRTOS task on each timer tick, instead of calling callback
+             *
+             * Task waits with ulTaskNotifyTake(pdTRUE, portMAX_DELAY), which returns ticks since last call,
+             * so work runs at task priority instead of in timer interrupt (STM32) or esp_timer task (ESP32).
+             * It's kept for next setXXX calls until clearNotifyTask(). Overrun policy is not applied.
+             *
+             * @param	task		Task to notify
+             * @param	priority	If not 0, task priority is raised to it until clearNotifyTask()
+             */
+            void uTimerLib::setNotifyTask(TaskHandle_t task, UBaseType_t priority) {
+                    clearNotifyTask();
+                    if (task == NULL) {
+                            return;
+                    }
+                    if (priority != 0) {
+                            _notifyPriority = uxTaskPriorityGet(task);
+                            _notifyBoost = true;
+                            vTaskPrioritySet(task, priority);
+                    }
+                    _notifyTask = task;
+            }
+
+            /**
+             * \brief Stops notifying task, back to callback; restores task priority if it was raised
+             */
+            void uTimerLib::clearNotifyTask() {
+                    TaskHandle_t task = _notifyTask;
+                    _notifyTask = NULL;
+                    if (task != NULL && _notifyBoost) {
+                            vTaskPrioritySet(task, _notifyPriority);
+                    }
+                    _notifyBoost = false;
+            }
+    #endif
+
+    #if defined(UTIMERLIB_NOW_TIMER)
+            /**
+             * \brief Internal: timer ticks in now_ticks() units
+             *
+             * @param	count	Timer ticks
+             * @return	Ticks of UTIMERLIB_NOW_HZ
+             */
+            inline uint64_t uTimerLib::_nowScale(uint64_t count) {
+                    return (_nowShift >= 0) ? (count << _nowShift) : (count >> -_nowShift);
+            }
+
+            /**
+             * \brief Internal: moves ticks counted since last fold to _nowBase, before timer clock changes or its counter restarts
+             *
+             * Caller changes clock state after it, in same critical section, so _nowSeq is bumped here for all of it.
+             */
+            void uTimerLib::_nowFold() {
+                    unsigned long int state = _lock(); // _nowBase and _nowAcc are moved together; also from timer interrupt
+                    if (_nowRun) {
+                            uint64_t count = _nowCount();
+                            _nowBase += _nowScale(count);
+                            _nowAcc -= count;
+                    }
+                    _nowSeq++;
+                    _unlock(state);
+            }
+
+            /**
+             * \brief Internal: pauses now_ticks() clock, as timer is going to drive a pin, capture or run on its own, with no interrupt
+             */
+            void uTimerLib::_nowStop() {
+                    unsigned long int state = _lock(); // Clock state changes together
+                    _nowFold();
+                    _nowRun = false;
+                    _nowIdling = false;
+                    _unlock(state);
+            }
+    #elif !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+            /**
+             * \brief Half wraps of micros() (2^31us), or millis() on SAMD51, seen by now_ticks(); odd when its upper bit is expected to be set
+             */
+            volatile unsigned long int uTimerLib::_nowHalves = 0;
+
+            #if defined(__SAMD51__)
+                    volatile bool uTimerLib::_nowCycOn = false;
+                    uint32_t uTimerLib::_nowCycOff = 0;
+
+                    /**
+                     * \brief 32 bit time extended by now_ticks(): millis() places DWT cycle counter
+                     */
+                    #define UTIMERLIB_NOW_WIDEN millis
+            #else
+                    #define UTIMERLIB_NOW_WIDEN micros
+            #endif
+    #endif
+
+    /**
+     * \brief Monotonic 64 bit time in ticks of UTIMERLIB_NOW_HZ, that never wraps
+     *
+     * AVR (not ATtiny nor Digispark), SAM and SAMD21 count library timer in CPU cycles (timer clock, MCK / 32, on SAM): its counter,
+     * extended by its interrupt, so it doesn't need to be called at any rate. First call starts it from micros() time; then timer interrupt
+     * keeps counting when there's no timing, with longest count: on AVR at CPU clock / 64 or slower on Timer2 (each 1ms at 16MHz)
+     * and / 8 or slower on Timer1 and Timer3 (each 33ms); on SAMD21 at last timing prescaler, or GCLK_TC / 16 if there's none; each 27 minutes on SAM.
+     * It pauses while timer drives a pin, captures or runs on its own (setEventOutput with no callback, uTimerLibStream),
+     * and each timer clock change (new timing, idle count) may move it up to one timer tick; SAM and SAMD21 also pause it while
+     * a new timing is set up, as timer has to be stopped to change its clock (a few microseconds).
+     * Interrupts are not masked while reading: clock state and counter are read again if timer interrupt changed them meanwhile
+     * (sequence count), and counter is read with no synchronization wait (SAMD21 keeps it continuously synchronized).
+     * Only first call masks them, to start the clock. An interrupt preempting timer interrupt or a library critical section
+     * (higher priority with UTIMERLIB_BASEPRI) may read a time one timer count off.
+     *
+     * SAMD51 counts CPU cycles with DWT cycle counter, so it never pauses; its 32 bit wraps are given by millis(), extended to 64 bits
+     * detecting its wraps on each read, so it must be called at least once each 24 days.
+     *
+     * ESP32 reads esp_timer and ESP8266 uses micros64(). Other devices (STM32, ATtiny, Digispark...) extend micros() to 64 bits,
+     * detecting wraps on each read, so it must be called at least once each 35 minutes, or it loses 71 minutes each time it's not.
+     * All of them are in microseconds (UTIMERLIB_NOW_HZ is 1000000).
+     *
+     * @return	Ticks since start
+     */
+    uint64_t uTimerLib::now_ticks() {
+            #if defined(ARDUINO_ARCH_ESP32)
+                    return esp_timer_get_time();
+            #elif defined(ARDUINO_ARCH_ESP8266)
+                    return micros64();
+            #elif defined(UTIMERLIB_NOW_TIMER)
+                    if (!TimerLib._nowOn) {
+                            unsigned long int state = _lock(); // Only once: clock is started on timer state
+                            if (!TimerLib._nowOn) {
+                                    TimerLib._nowOn = true;
+                                    TimerLib._nowBase = (uint64_t) micros() * (UTIMERLIB_NOW_HZ / 1000) / 1000;
+                                    TimerLib._nowStart();
+                            }
+                            _unlock(state);
+                    }
+                    uint64_t ticks;
+                    unsigned char seq;
+                    // Sequence count: if timer interrupt or a fold changed clock state while reading, read again
+                    do {
+                            seq = TimerLib._nowSeq;
+                            ticks = TimerLib._nowBase;
+                            if (TimerLib._nowRun) {
+                                    ticks += TimerLib._nowScale(TimerLib._nowCount());
+                            }
+                    } while (seq != TimerLib._nowSeq);
+                    return ticks;
+            #else
+                    unsigned long int halves, time;
+                    // Double read: if an interrupt updated _nowHalves meanwhile, read again
+                    do {
+                            halves = _nowHalves;
+                            time = UTIMERLIB_NOW_WIDEN();
+                    } while (halves != _nowHalves);
+                    if ((time >> 31) != (halves & 1)) {
+                            // Next half wrap. All concurrent callers write same value, so no lock is needed
+                            halves++;
+                            _nowHalves = halves;
+                    }
+                    #if defined(__SAMD51__)
+                            // Cycles from millis() time are within 2^31 (17s at 120MHz) of cycle counter, so they give its wraps
+                            uint64_t cycles = (((uint64_t) (halves >> 1) << 32) | time) * (F_CPU / 1000);
+                            if (!_nowCycOn) {
+                                    unsigned long int state = _lock(); // Only once: counter is enabled and placed on millis() time
+                                    if (!_nowCycOn) {
+                                            CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+                                            DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+                                            _nowCycOff = (uint32_t) cycles - DWT->CYCCNT;
+                                            _nowCycOn = true;
+                                    }
+                                    _unlock(state);
+                            }
+                            return cycles + (int32_t) (DWT->CYCCNT + _nowCycOff - (uint32_t) cycles);
+                    #else
+                            return ((uint64_t) (halves >> 1) << 32) | time;
+                    #endif
+            #endif
+    }
+
+    /**
+     * \brief Monotonic 64 bit time in microseconds, that never wraps: now_ticks() converted
+     *
+     * @return	Microseconds since start
+     */
+    uint64_t uTimerLib::now_us() {
+            #if (UTIMERLIB_NOW_HZ % 1000000) == 0
+                    return now_ticks() / (UTIMERLIB_NOW_HZ / 1000000);
+            #else
+                    uint64_t ticks = now_ticks();
+                    return ticks / UTIMERLIB_NOW_HZ * 1000000 + ticks % UTIMERLIB_NOW_HZ * 1000000 / UTIMERLIB_NOW_HZ;
+            #endif
+    }
+
+    #if defined(ARDUINO_ARCH_ESP32)
+            /**
+             * \brief Spinlock for library critical sections, shared by both cores
+             */
+            static portMUX_TYPE _uTimerLibMux = portMUX_INITIALIZER_UNLOCKED;
+    #elif !defined(ARDUINO_ARCH_AVR) && !defined(__AVR__) && !defined(ARDUINO_ARCH_ESP8266) && !defined(__arm__)
+            /**
+             * \brief Nested critical sections, on devices whose interrupts state can't be read
+             */
+            static volatile unsigned char _uTimerLibLockDepth = 0;
+    #endif
+
+    /**
+     * \brief Enters a critical section for library state, saving previous interrupts state
+     *
+     * SREG on AVR (also cores not defining ARDUINO_ARCH_AVR), PS level on ESP8266 and PRIMASK (or BASEPRI) on ARM.
+     * Where it can't be read, only nesting is counted: then it must not be called with interrupts already masked (as in an interrupt).
+     *
+     * @return	Previous interrupts state, to be passed to _unlock
+     */
+    unsigned long int uTimerLib::_lock() {
+            #if defined(ARDUINO_ARCH_AVR) || defined(__AVR__)
+                    unsigned char state = SREG;
+                    cli();
+                    return state;
+            #elif defined(ARDUINO_ARCH_ESP32)
+                    portENTER_CRITICAL_SAFE(&_uTimerLibMux);
+                    return 0;
+            #elif defined(ARDUINO_ARCH_ESP8266)
+                    return xt_rsil(15);
+            #elif defined(__arm__)
+                    #if defined(UTIMERLIB_BASEPRI) && (defined(ARDUINO_ARCH_SAM) || defined(__SAMD51__))
+                            if (TimerLib._priority != 0) { // BASEPRI 0 masks nothing, so highest priority needs PRIMASK
+                                    unsigned long int state = __get_BASEPRI();
+                                    unsigned long int level = (TimerLib._priority << (8 - __NVIC_PRIO_BITS)) & 0xFF;
+                                    if (state == 0 || state > level) { // Only raise it, if nested
+                                            __set_BASEPRI(level);
+                                    }
+                                    return state | 0x100; // BASEPRI state
+                            }
+                    #endif
+                    unsigned long int state = __get_PRIMASK();
+                    __disable_irq();
+                    return state;
+            #else
+                    noInterrupts();
+                    return _uTimerLibLockDepth++;
+            #endif
+    }
+
+    /**
+     * \brief Leaves a critical section for library state, restoring previous interrupts state
+     *
+     * @param	state	Value returned by _lock
+     */
+    void uTimerLib::_unlock(unsigned long int state) {
+            #if defined(ARDUINO_ARCH_AVR) || defined(__AVR__)
+                    SREG = state;
+            #elif defined(ARDUINO_ARCH_ESP32)
+                    portEXIT_CRITICAL_SAFE(&_uTimerLibMux);
+            #elif defined(ARDUINO_ARCH_ESP8266)
+                    xt_wsr_ps(state);
+            #elif defined(__arm__)
+                    #if defined(UTIMERLIB_BASEPRI) && (defined(ARDUINO_ARCH_SAM) || defined(__SAMD51__))
+                            if (state & 0x100) {
+                                    __set_BASEPRI(state & 0xFF);
+                                    return;
+                            }
+                    #endif
+                    __set_PRIMASK(state);
+            #else
+                    _uTimerLibLockDepth = state;
+                    if (state == 0) { // Outermost one
+                            interrupts();
+                    }
+            #endif
+    }
+
     #define UTIMERLIB_HW_COMPILE
 
     // Now load each hardware variation support:
@@ -6,7 +6,7 @@
  *		* Atmel ATtiny:		Timer1 (2nd timer) - https://github.com/damellis/attiny and https://github.com/SpenceKonde/Disgispark AVRCore (25, 45 and 85)
  *		* DisgiSpark AVR:	Timer0 (1st timer) - https://github.com/digistump/DigistumpArduino
  *		* Atmel AVR 32U4:	Timer3 (4rd timer)
- *		* Atmel AVR other:	Timer2 (3rd timer)
+ *		* Atmel AVR other:	Timer2 (3rd timer), or Timer1 (2nd timer) when UTIMERLIB_AVR_TIMER1 is defined
  *		* STM32:			Timer3 (3rd timer)
  *		* SAM (Due):		TC3 (Timer1, channel 0)
  *		* ESP8266:			OS Timer, one slot of seven available (Software timer provided by Arduino because ESP8266 has only two hardware timers and one is needed by it normal operation)
@@ -19,7 +19,10 @@
  *		* TimerLib.setInterval_s(callback_function, seconds);* : callback_function will be called each seconds.
  *		* TimerLib.setTimeout_us(callback_function, microseconds);* : callback_function will be called once when microseconds have passed.
  *		* TimerLib.setTimeout_s(callback_function, seconds);* : callback_function will be called once when seconds have passed.
+ *		* TimerLib.setInterval_hz(callback_function, hz[, den]);* : callback_function will be called hz / den times each second, exact on average.
  *		* TimerLib.clearTimer();* : will clear any timed function if exists.
+ *		* TimerLib.restart();* : sets last interval or timeout again from now, keeping its period; a new period needs setXXX.
+ *		* TimerLib.traceDump(Serial);* : with UTIMERLIB_TRACE defined, prints recorded timer events; decode them with extras/uTimerLibTrace.py.
  *
  * @file hardware/uTimerLib.ATTINY.cpp
  * @copyright Naguissa
@@ -40,12 +43,175 @@
 
 	#include "Arduino.h"
 
+	// Optional features, uncomment to enable them (or define them in your build flags)
+	/**
+	 * \brief Use 16 bit Timer1 instead of 8 bit Timer2 on AVR boards (not 32U4)
+	 *
+	 * Timer1 reaches 4.19s in a single compare at 16MHz, so long timings need far less interrupts.
+	 * It frees Timer2 for tone(), but Servo library uses Timer1 too.
+	 */
+	// #define UTIMERLIB_AVR_TIMER1
+
+	/**
+	 * \brief Use a naked interrupt on AVR boards (not ATtiny nor Digispark) that swallows overflows with nothing to do in a few cycles
+	 *
+	 * Long timings count many timer overflows. A regular interrupt saves all call-clobbered registers on each one;
+	 * this one only decrements a byte counter in assembly, and jumps to regular interrupt when something is due.
+	 * Computed cost from instruction timings (2 byte PC, 3 byte PC as ATmega2560 adds 2): swallowed overflow 27 cycles
+	 * in total; due interrupt 18 cycles more than regular interrupt.
+	 */
+	// #define UTIMERLIB_AVR_NAKED_ISR
+
+	/**
+	 * \brief Enable uTimerLibStream, timer-paced DMA streaming on SAMD21 and SAMD51
+	 *
+	 * It uses DMAC channel 0 and its descriptor table, so it can't be used together with other DMA libraries that set them up.
+	 */
+	// #define UTIMERLIB_USE_DMA
+
+	/**
+	 * \brief Define DMAC interrupt handler in uTimerLibStream (DMAC_Handler on SAMD21, DMAC_0_Handler on SAMD51)
+	 *
+	 * Without it there's no handler, so it doesn't clash with the one of another library or sketch, and DMAC interrupt is not enabled:
+	 * for stream callbacks, call uTimerLibStream::dmaHandler() from yours and enable it.
+	 */
+	// #define UTIMERLIB_DMA_HANDLER
+
+	/**
+	 * \brief Define timer input capture and overflow interrupt vectors in uTimerLibCapture on AVR (TIMER3_CAPT_vect and TIMER3_OVF_vect on 32U4,
+	 * TIMER1_CAPT_vect and TIMER1_OVF_vect with UTIMERLIB_AVR_TIMER1)
+	 *
+	 * Without it there are no such vectors, so they don't clash with the ones of another library or sketch using that timer:
+	 * for input capture, call uTimerLibCapture::captureHandler() and uTimerLibCapture::overflowHandler() from yours and enable them
+	 * after capture begin(), as they're not enabled then.
+	 */
+	// #define UTIMERLIB_CAPTURE_HANDLER
+
+	/**
+	 * \brief Enable FreeRTOS task notification dispatch on STM32, with STM32FreeRTOS library (always enabled on ESP32)
+	 */
+	// #define UTIMERLIB_FREERTOS
+
+	/**
+	 * \brief On SAM (Due) and SAMD51, library critical sections only mask interrupts up to timer priority (BASEPRI)
+	 *
+	 * Timer priority is set with TimerLib.setPriority; interrupts with higher priority keep running, so they must not call TimerLib.
+	 * SAMD21 (Cortex-M0+) has no BASEPRI, so it always masks all interrupts, as when timer has highest priority (0).
+	 */
+	// #define UTIMERLIB_BASEPRI
+
+	/**
+	 * \brief Record timer events (arm, cancel, fire, callback start and end, overrun) on a ring, to be printed with TimerLib.traceDump(Serial)
+	 *
+	 * Each record is a now_ticks() timestamp (low 32 bits), an event and an argument; ring size is UTIMERLIB_TRACE_SIZE (32 by default).
+	 * Interrupt fast path is not used, so each timer interrupt is recorded.
+	 */
+	// #define UTIMERLIB_TRACE
+
 	#if defined(ARDUINO_ARCH_ESP8266)
 		#include <Ticker.h>  //Ticker Library
 	#endif
 
+	// C++20 coroutines, see uTimerLibCoroutine.h
+	#if defined(__cpp_impl_coroutine) && defined(__has_include)
+		#if __has_include(<coroutine>)
+			/**
+			 * \brief Toolchain supports coroutines: TimerLib.sleep_us and uTimerLibTask are available
+			 */
+			#define UTIMERLIB_COROUTINES
+			class uTimerLibSleep;
+		#endif
+	#endif
+
+	// std::chrono durations: wherever toolchain has <chrono>; not on AVR, as avr-gcc has no C++ standard library
+	#if defined(__has_include) && !defined(ARDUINO_ARCH_AVR) && !defined(__AVR__)
+		#if __has_include(<chrono>)
+			#include <chrono>
+			/**
+			 * \brief std::chrono::duration overloads are available: TimerLib.setInterval(callback, 250ms)
+			 */
+			#define UTIMERLIB_CHRONO
+		#endif
+	#endif
+
+	// now_ticks() clock: library timer counter extended by its interrupt where timer can keep counting (or SAMD51 cycle counter), else microseconds
+	#if defined(ARDUINO_ARCH_SAM)
+		/**
+		 * \brief now_ticks() counts library timer, extended by its interrupt, so no call cadence is needed
+		 */
+		#define UTIMERLIB_NOW_TIMER
+		/**
+		 * \brief now_ticks() frequency, in Hz: timer clock (MCK / 32) on SAM, CPU clock (F_CPU, boot one on AVR) on AVR and SAMD, microseconds elsewhere
+		 */
+		#define UTIMERLIB_NOW_HZ (VARIANT_MCK / 32)
+	#elif defined(__SAMD51__)
+		#define UTIMERLIB_NOW_HZ F_CPU
+	#elif defined(_SAMD21_) || ((defined(__AVR_ATmega32U4__) || defined(ARDUINO_ARCH_AVR)) && !defined(ARDUINO_attiny) && !defined(ARDUINO_AVR_ATTINYX4) && !defined(ARDUINO_AVR_ATTINYX5) && !defined(ARDUINO_AVR_ATTINYX7) && !defined(ARDUINO_AVR_ATTINYX8) && !defined(ARDUINO_AVR_ATTINYX61) && !defined(ARDUINO_AVR_ATTINY43) && !defined(ARDUINO_AVR_ATTINY828) && !defined(ARDUINO_AVR_ATTINY1634) && !defined(ARDUINO_AVR_ATTINYX313) && !defined(ARDUINO_AVR_DIGISPARK))
+		#define UTIMERLIB_NOW_TIMER
+		#define UTIMERLIB_NOW_HZ F_CPU
+	#else
+		#define UTIMERLIB_NOW_HZ 1000000
+	#endif
+
+	// Interrupt fast path: AVR (not ATtiny nor Digispark, same ones counting now_ticks() on timer), SAM and SAMD21
+	#if defined(ARDUINO_ARCH_SAM) || defined(_SAMD21_) || (defined(ARDUINO_ARCH_AVR) && defined(UTIMERLIB_NOW_TIMER))
+		/**
+		 * \brief Timer interrupt has a fast path for single compare intervals (_fastInterrupt())
+		 */
+		#define UTIMERLIB_FAST_PATH
+	#endif
+
+	/**
+	 * \brief Lightweight duration in microseconds, for toolchains without <chrono> (AVR): TimerLib.setInterval(callback, 250_ms)
+	 *
+	 * Made by uTimerLibLiterals suffixes, which are constexpr, so unit conversion is done at compile time.
+	 */
+	struct uTimerLibDuration {
+		uint64_t us;
+	};
+
+	/**
+	 * \brief Duration suffixes: _us, _ms, _s and _min. Use them with: using namespace uTimerLibLiterals;
+	 */
+	namespace uTimerLibLiterals {
+		constexpr uTimerLibDuration operator"" _us(unsigned long long int v) {
+			return uTimerLibDuration{v};
+		}
+		constexpr uTimerLibDuration operator"" _ms(unsigned long long int v) {
+			return uTimerLibDuration{v * 1000};
+		}
+		constexpr uTimerLibDuration operator"" _s(unsigned long long int v) {
+			return uTimerLibDuration{v * 1000000};
+		}
+		constexpr uTimerLibDuration operator"" _min(unsigned long long int v) {
+			return uTimerLibDuration{v * 60000000};
+		}
+	}
+
 	#if defined(ARDUINO_ARCH_ESP32)
 		#include "esp_timer.h"
+
+		/**
+		 * \brief Stack size, in bytes, of each dispatch task created by TimerLib.setCore
+		 */
+		#ifndef UTIMERLIB_ESP32_CORE_STACK
+			#define UTIMERLIB_ESP32_CORE_STACK 4096
+		#endif
+
+		#ifndef UTIMERLIB_FREERTOS
+			#define UTIMERLIB_FREERTOS
+		#endif
+	#endif
+
+	#if defined(UTIMERLIB_FREERTOS)
+		#if defined(ARDUINO_ARCH_ESP32)
+			#include "freertos/FreeRTOS.h"
+			#include "freertos/task.h"
+		#elif defined(_VARIANT_ARDUINO_STM32_) || defined(ARDUINO_ARCH_STM32)
+			#include <STM32FreeRTOS.h>
+		#else
+			#undef UTIMERLIB_FREERTOS
+		#endif
 	#endif
 
 	// Operation modes
@@ -62,6 +228,62 @@
 	 */
 	#define UTIMERLIB_TYPE_INTERVAL 2
 
+	// Overrun policies
+	/**
+	 * \brief Overrun policy: no detection, a late interrupt may fire just after callback (default)
+	 */
+	#define UTIMERLIB_OVERRUN_NONE 0
+	/**
+	 * \brief Overrun policy: missed ticks are counted and dropped
+	 */
+	#define UTIMERLIB_OVERRUN_SKIP 1
+	/**
+	 * \brief Overrun policy: missed ticks are counted and callback is called once for each one
+	 */
+	#define UTIMERLIB_OVERRUN_CATCHUP 2
+	/**
+	 * \brief Overrun policy: missed ticks are counted and coalesced into one call to overrun callback, with missed count
+	 */
+	#define UTIMERLIB_OVERRUN_COALESCE 3
+
+	// Trace events, recorded when UTIMERLIB_TRACE is defined
+	/**
+	 * \brief Trace event: timer armed; argument is timing type
+	 */
+	#define UTIMERLIB_TRACE_ARM 1
+	/**
+	 * \brief Trace event: timer cleared; argument is new generation
+	 */
+	#define UTIMERLIB_TRACE_CANCEL 2
+	/**
+	 * \brief Trace event: callback due on timer interrupt; argument is generation it was armed with
+	 */
+	#define UTIMERLIB_TRACE_FIRE 3
+	/**
+	 * \brief Trace event: callback called
+	 */
+	#define UTIMERLIB_TRACE_CB_START 4
+	/**
+	 * \brief Trace event: callback returned
+	 */
+	#define UTIMERLIB_TRACE_CB_END 5
+	/**
+	 * \brief Trace event: overrun detected; argument is missed ticks, up to 255
+	 */
+	#define UTIMERLIB_TRACE_OVERRUN 6
+
+	#if defined(UTIMERLIB_TRACE)
+		/**
+		 * \brief Trace ring records, a power of 2; each one takes 7 bytes (8 on 32 bit devices)
+		 */
+		#ifndef UTIMERLIB_TRACE_SIZE
+			#define UTIMERLIB_TRACE_SIZE 32
+		#endif
+		#if (UTIMERLIB_TRACE_SIZE & (UTIMERLIB_TRACE_SIZE - 1)) != 0
+			#error "UTIMERLIB_TRACE_SIZE must be a power of 2"
+		#endif
+	#endif
+
 	#if defined(_VARIANT_ARDUINO_STM32_) || defined(ARDUINO_ARCH_STM32)
 		#include "HardwareTimer.h"
 
@@ -82,6 +304,49 @@
 			void setInterval_s(void (*) (), unsigned long int);
 			void setTimeout_us(void (*) (), unsigned long int);
 			void setTimeout_s(void (*) (), unsigned long int);
+			void setInterval_hz(void (*) (), unsigned long int, unsigned long int = 1);
+			void setInterval_ms(void (*) (), unsigned long int);
+			void setTimeout_ms(void (*) (), unsigned long int);
+			void setInterval_us64(void (*) (), uint64_t);
+			void setTimeout_us64(void (*) (), uint64_t);
+
+			/**
+			 * \brief Attaches a callback function to be executed each duration, made with uTimerLibLiterals (250_ms)
+			 */
+			void setInterval(void (* cb)(), uTimerLibDuration d) {
+				setInterval_us64(cb, d.us);
+			}
+			/**
+			 * \brief Attaches a callback function to be executed once when duration has passed, made with uTimerLibLiterals (250_ms)
+			 */
+			void setTimeout(void (* cb)(), uTimerLibDuration d) {
+				setTimeout_us64(cb, d.us);
+			}
+
+			#if defined(UTIMERLIB_CHRONO)
+				/**
+				 * \brief Attaches a callback function to be executed each std::chrono duration (250ms); converted to us at compile time if constant
+				 */
+				template <class Rep, class Period> void setInterval(void (* cb)(), std::chrono::duration<Rep, Period> d) {
+					setInterval_us64(cb, _chronoUs(d));
+				}
+				/**
+				 * \brief Attaches a callback function to be executed once when std::chrono duration has passed (250ms)
+				 */
+				template <class Rep, class Period> void setTimeout(void (* cb)(), std::chrono::duration<Rep, Period> d) {
+					setTimeout_us64(cb, _chronoUs(d));
+				}
+				/**
+				 * \brief Internal: std::chrono duration in microseconds, rounded down; 0 (not valid) if negative
+				 */
+				template <class Rep, class Period> static constexpr uint64_t _chronoUs(std::chrono::duration<Rep, Period> d) {
+					return (d.count() > 0) ? std::chrono::duration_cast<std::chrono::duration<uint64_t, std::micro>>(d).count() : 0;
+				}
+			#endif
+
+			#if defined(UTIMERLIB_COROUTINES)
+				uTimerLibSleep sleep_us(unsigned long int);
+			#endif
 
 			/**
 			 * \brief Loads last bit of time needed to precisely count until desired time (non complete loop)
@@ -89,6 +354,84 @@
 			 * Note: This is device-dependant
 			 */
 			void clearTimer();
+			void restart();
+
+			void setOverrunPolicy(unsigned char, void (*) (unsigned long int) = NULL);
+			unsigned long int getOverruns();
+
+			static uint64_t now_us();
+			static uint64_t now_ticks();
+
+			#if defined(UTIMERLIB_TRACE)
+				void traceDump(Print &);
+				void traceClear();
+			#endif
+
+			#if defined(ARDUINO_ARCH_AVR)
+				void clockChanged();
+				void setClockPrescaler(unsigned char);
+			#endif
+
+			#if defined(UTIMERLIB_FREERTOS)
+				void setNotifyTask(TaskHandle_t, UBaseType_t = 0);
+				void clearNotifyTask();
+			#endif
+
+			bool setToggle_us(uint8_t, unsigned long int);
+			bool setPwm_us(uint8_t, unsigned long int, unsigned long int);
+
+			#if defined(ARDUINO_ARCH_SAM) || defined(_SAMD21_) || defined(__SAMD51__)
+				void setPriority(uint8_t);
+			#endif
+
+			#if defined(_SAMD21_) || defined(__SAMD51__)
+				bool setEventOutput(uint8_t, uint8_t);
+				void clearEventOutput();
+
+				/**
+				 * \brief Internal: makes current interval run on its own in hardware, with no interrupt, for event output and DMA
+				 *
+				 * Note: This is device-dependant
+				 */
+				bool _freeRun();
+			#endif
+
+			/**
+			 * \brief Internal: sets up timer for input capture on pin; calls callback with each 32 bit timestamp
+			 *
+			 * Note: This is device-dependant
+			 */
+			bool _attachCapture(uint8_t, uint8_t, void (*) (uint32_t), unsigned long int *);
+			void _capture(uint16_t, bool);
+			void _captureOverflow();
+
+			/**
+			 * \brief Internal: count after running one of current interval lasts given timer ticks, and so do next ones
+			 *
+			 * Prescaler is kept, so ticks are the ones of _reloadTicks(). For uTimerLibPWM edges, from interval callback.
+			 * Running count is never changed nor counter read, so there's no wait for register synchronization; restart() takes
+			 * given length at once.
+			 *
+			 * Note: This is device-dependant
+			 */
+			bool _reload(unsigned long int);
+			/**
+			 * \brief Internal: microseconds in timer ticks of current interval prescaler, rounded; 0 if device can't reload counts
+			 *
+			 * Note: This is device-dependant
+			 */
+			unsigned long int _reloadTicks(unsigned long int);
+
+			/**
+			 * \brief Internal critical section for library state; returns previous interrupts state
+			 *
+			 * Can be nested and called from interrupts or callbacks, as it restores previous state on _unlock.
+			 */
+			static unsigned long int _lock();
+			/**
+			 * \brief Internal critical section end; restores interrupts state returned by _lock
+			 */
+			static void _unlock(unsigned long int);
 
 			/**
 			 * \brief Internal intermediate function to control timer interrupts
@@ -99,6 +442,29 @@
 
 			void _interrupt();
 
+			#if defined(UTIMERLIB_NOW_TIMER)
+				/**
+				 * \brief Internal: adds count just ended to now_ticks() clock, called on each timer interrupt before anything else
+				 *
+				 * Note: This is device-dependant
+				 */
+				void _nowWrap();
+			#endif
+
+			#if defined(UTIMERLIB_FAST_PATH)
+				/**
+				 * \brief Internal: interrupt fast path for a pure single compare interval, only clearing flag and calling callback
+				 *
+				 * Checked first by timer interrupt, before now_ticks() clock count, so it's only selected while that clock is not started.
+				 * SAMD51 has none: its TC1_Handler always runs _interrupt(), as it loads next TOP on each period (CCBUF0).
+				 *
+				 * Note: This is device-dependant
+				 *
+				 * @return	false if timer is not in fast path, so _interrupt() has to be called
+				 */
+				bool _fastInterrupt();
+			#endif
+
 			#if defined(_VARIANT_ARDUINO_STM32_) || defined(ARDUINO_ARCH_STM32)
 				// ST's Arduino Core STM32, https://github.com/stm32duino/Arduino_Core_STM32
 				#ifdef BOARD_NAME
@@ -112,6 +478,7 @@
 
 			#if defined(ARDUINO_ARCH_ESP32)
 				static void interrupt(void* arg);
+				bool setCore(BaseType_t, UBaseType_t = configMAX_PRIORITIES - 1);
 			#endif
 
 			#if defined(ARDUINO_ARCH_ESP8266)
@@ -130,9 +497,52 @@
 		private:
 			static uTimerLib *_instance;
 
+			#if defined(UTIMERLIB_NOW_TIMER)
+				// now_ticks() is _nowBase plus timer ticks since last fold shifted by _nowShift: _nowAcc (ended counts since last fold, minus counter then) plus counter
+				volatile uint64_t _nowBase = 0;
+				#if defined(ARDUINO_ARCH_AVR)
+					volatile long int _nowAcc = 0; // Moved to _nowBase by interrupt long before it overflows
+				#else
+					volatile int64_t _nowAcc = 0;
+				#endif
+				volatile signed char _nowShift = 0;
+				// _nowOn once now_ticks() has been called; _nowRun while timer interrupt counts (not on pin output, input capture nor free run)
+				bool _nowOn = false;
+				volatile bool _nowRun = false;
+				// Timer interrupt only counts for now_ticks(), as there's no timing
+				volatile bool _nowIdling = false;
+				// Bumped on each change of clock state above (interrupt, fold): now_ticks() reads it again if it changed meanwhile
+				volatile unsigned char _nowSeq = 0;
+				uint64_t _nowCount();
+				uint64_t _nowScale(uint64_t);
+				void _nowFold();
+				void _nowStop();
+				void _nowStart();
+				void _nowIdle();
+				#if defined(ARDUINO_ARCH_AVR)
+					signed char _nowClkps = 0;	// System clock prescaler from boot one, already in _nowShift
+					unsigned char _cs = 0;		// Prescaler (CS bits) of last timing, as idle count may slow timer down
+					void _nowClock();
+					#if defined(UTIMERLIB_AVR_NAKED_ISR)
+						volatile unsigned char _nowSkip = 0; // Overflows given to naked interrupt, not yet in _nowAcc
+					#endif
+				#elif defined(_SAMD21_)
+					volatile uint16_t _nowTop = 0;	// TOP of running count, as reading CC0 needs synchronization
+				#endif
+			#elif !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+				static volatile unsigned long int _nowHalves;
+				#if defined(__SAMD51__)
+					static volatile bool _nowCycOn;		// DWT cycle counter is enabled
+					static uint32_t _nowCycOff;		// Cycle counter to cycles since boot, at millis() ones
+				#endif
+			#endif
+
 			unsigned long int _overflows = 0;
 			unsigned long int __overflows = 0;
-			#ifdef ARDUINO_ARCH_AVR
+			#if defined(ARDUINO_ARCH_AVR) && (defined(UTIMERLIB_AVR_TIMER1) || defined(__AVR_ATmega32U4__))
+				uint16_t _remaining = 0;
+				uint16_t __remaining = 0;
+			#elif defined(ARDUINO_ARCH_AVR)
 				unsigned char _remaining = 0;
 				unsigned char __remaining = 0;
 			#else
@@ -140,13 +550,103 @@
 				unsigned long int __remaining = 0;
 			#endif
 			void (*_cb)() = NULL;
-			unsigned char _type = UTIMERLIB_TYPE_OFF;
+			volatile unsigned char _type = UTIMERLIB_TYPE_OFF;
+			// Incremented on each clear or new timer, so an interrupt already running knows it has been cancelled
+			volatile unsigned char _generation = 0;
+
+			unsigned char _overrunPolicy = UTIMERLIB_OVERRUN_NONE;
+			void (*_cbOverrun)(unsigned long int) = NULL;
+			volatile unsigned long int _overruns = 0;
 
 			void _loadRemaining();
+			unsigned long int _missed();
+			unsigned char _cancel();
+			unsigned char _current();
+			void _dispatch(unsigned char, unsigned long int = 0);
+			void _callback();
 
-			void _attachInterrupt_us(unsigned long int);
+			#if defined(UTIMERLIB_TRACE)
+				// Trace ring, lock free: _traceHead counts records reserved since traceClear(), its low bits are ring index
+				// Each record is published by its seq: 0 while it's written, then odd lap number of its index
+				// Fields are written and read with __atomic builtins (time with volatile accesses on AVR), published by seq
+				struct TraceRecord {
+					volatile unsigned long int time;
+					volatile unsigned char event;
+					volatile unsigned char arg;
+					volatile unsigned char seq;
+				};
+				TraceRecord _traceRing[UTIMERLIB_TRACE_SIZE];
+				volatile unsigned long int _traceHead = 0;
+				volatile bool _tracePaused = false;
+				void _trace(unsigned char, unsigned char);
+				unsigned long int _traceReserve();
+				unsigned long int _traceTime(unsigned char);
+			#else
+				/**
+				 * \brief Internal: trace record, nothing if UTIMERLIB_TRACE is not defined
+				 */
+				void _trace(unsigned char, unsigned char) {}
+			#endif
+
+			void _attachInterrupt_us(unsigned long long int);
 			void _attachInterrupt_s(unsigned long int);
 
+			void _attachInterrupt_hz(unsigned long int, unsigned long int);
+			void _attachInterrupt_ms(unsigned long int);
+
+			// Last timing set, to set it again; _time / _timeDen Hz if _timeDen is not 0
+			unsigned long long int _time = 0;
+			bool _timeS = false;
+			unsigned long int _timeDen = 0;
+			void _rearm();
+			// Type of last timing set, for restart(); OFF if timer has been used for something else since
+			volatile unsigned char _timeType = UTIMERLIB_TYPE_OFF;
+			bool _restart();
+
+			#if defined(UTIMERLIB_FAST_PATH)
+				// Callback for interrupt fast path, selected when timer is armed; NULL to use _interrupt()
+				void (* volatile _fastCb)() = NULL;
+				bool _fastPath();
+			#endif
+
+			#if defined(ARDUINO_ARCH_AVR) && defined(UTIMERLIB_AVR_NAKED_ISR)
+				void _skipOverflows();
+			#endif
+
+			#if defined(ARDUINO_ARCH_AVR)
+				// CPU clock, following system clock prescaler (CLKPR) changes
+				unsigned long int _clockHz = F_CPU;
+				unsigned char _clkpsBoot = 0;
+			#endif
+
+			#if defined(ARDUINO_ARCH_AVR) || defined(_SAMD21_) || defined(__SAMD51__)
+				unsigned char _prescale(unsigned long long int, const unsigned char *, unsigned char, unsigned long int, unsigned long long int *);
+				void _attachInterrupt_cycles(unsigned long long int, unsigned long int);
+
+				// Period fraction of a tick, as _fracRem / _fracDen; Bresenham accumulator adds one tick each time _fracErr reaches a whole one
+				unsigned long int _fracRem = 0;
+				unsigned long int _fracDen = 1;
+				unsigned long int _fracErr = 0;
+				unsigned long long int _ticks(unsigned long long int, unsigned long long int);
+				bool _fraction();
+			#endif
+
+			// Pin driven by timer compare output, or toggled by interrupt when it can't be (or input capture pin)
+			uint8_t _outputPin = 0xFF;
+			uint8_t _pin = 0xFF;
+			bool _attachOutput_us(uint8_t, unsigned long int, unsigned long int);
+			static void _toggle();
+
+			// Input capture timestamps receiver; _overflows counts timer overflows meanwhile
+			void (*_cbCapture)(uint32_t) = NULL;
+
+			#if defined(UTIMERLIB_FREERTOS)
+				// Task notified instead of calling callback, and its priority before boost
+				TaskHandle_t _notifyTask = NULL;
+				UBaseType_t _notifyPriority = 0;
+				bool _notifyBoost = false;
+			#endif
+
 			#if defined(_VARIANT_ARDUINO_STM32_) || defined(ARDUINO_ARCH_STM32)
 				bool _toInit = true;
 
@@ -160,11 +660,35 @@
 			#endif
 
 			#if defined(ARDUINO_ARCH_ESP32)
-				esp_timer_handle_t _timer;
+				// Created on first use and kept, so setting a timing again is only a stop and a start
+				esp_timer_handle_t _timer = NULL;
+				uint64_t _timerUs = 0;
+				volatile uint64_t _reloadUs = 0; // Next period from _reload(), taken on period end; 0 if none
+				int64_t _fireTime = 0; // esp_timer time of last period end, for overruns; read and written under _lock()
+
+				// Dispatch task pinned to each core, created on first use and kept; _coreTask is the one in use, if any
+				TaskHandle_t _coreTasks[portNUM_PROCESSORS] = {};
+				volatile TaskHandle_t _coreTask = NULL;
+				// Ticks handed off and not dispatched yet, all of _coreGeneration timer; moved together under _lock()
+				unsigned char _coreGeneration = 0;
+				unsigned long int _corePending = 0;
+				static void _coreLoop(void *);
 			#endif
 
 			#if defined(ARDUINO_ARCH_ESP8266)
 				Ticker _ticker;
+				unsigned long int _tickerMs = 0;
+				uint64_t _fireTime = 0; // micros64() of last period end, for overruns
+			#endif
+
+			#if defined(ARDUINO_ARCH_SAM) || defined(_SAMD21_) || defined(__SAMD51__)
+				// Timer interrupt NVIC priority, 0 is highest
+				uint8_t _priority = 0;
+			#endif
+
+			#if defined(_SAMD21_) || defined(__SAMD51__)
+				uint8_t _evChannel = 0xFF;
+				uint8_t _evUser = 0;
 			#endif
 
 	};
@@ -0,0 +1,200 @@
+/**
+ * \class uTimerLibCapture
+ * \brief Input capture for uTimerLib: pin edges timestamped by timer hardware, buffered in a ring.
+ *
+ * @file uTimerLibCapture.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibCapture.h"
+
+uTimerLibCapture *uTimerLibCapture::_instance = NULL;
+
+/**
+ * \brief Constructor
+ *
+ * @param	buffer	Ring storage for timestamps
+ * @param	size	Number of timestamps in storage; ring holds size - 1 unread ones
+ */
+uTimerLibCapture::uTimerLibCapture(uint32_t *buffer, uint16_t size) {
+	_buffer = buffer;
+	_size = size;
+}
+
+/**
+ * \brief Starts capturing edges on pin
+ *
+ * @param	pin		Pin to capture; must be an input capture pin of the timer used (see header)
+ * @param	edge	RISING or FALLING
+ * @return	false if pin can't be captured on this device or ring is too small
+ */
+bool uTimerLibCapture::begin(uint8_t pin, uint8_t edge) {
+	if (_size < 2) {
+		return false;
+	}
+	end();
+	TimerLib.clearTimer();
+	_head = _tail = _stored = 0;
+	_lost = 0;
+	_instance = this;
+	pinMode(pin, INPUT);
+	if (!TimerLib._attachCapture(pin, edge, uTimerLibCapture::_interrupt, &_hz)) {
+		_instance = NULL;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * \brief Stops capturing
+ */
+void uTimerLibCapture::end() {
+	if (_instance == this) {
+		TimerLib.clearTimer();
+		_instance = NULL;
+	}
+}
+
+/**
+ * \brief Number of timestamps not read yet
+ */
+uint16_t uTimerLibCapture::available() {
+	unsigned long int state = uTimerLib::_lock();
+	uint16_t count = (_head + _size - _tail) % _size;
+	uTimerLib::_unlock(state);
+	return count;
+}
+
+/**
+ * \brief Copies timestamps, oldest first, and removes them from ring
+ *
+ * Timestamps are in timer ticks (see getTicksHz()) and wrap at 32 bits; differences between them are always right.
+ *
+ * @param	dst		Destination buffer
+ * @param	max		Maximum timestamps to copy
+ * @return	Number of timestamps copied
+ */
+uint16_t uTimerLibCapture::read(uint32_t *dst, uint16_t max) {
+	uint16_t count = 0;
+	unsigned long int state = uTimerLib::_lock();
+	while (count < max && _tail != _head) {
+		dst[count++] = _buffer[_tail];
+		_tail = (_tail + 1) % _size;
+	}
+	uTimerLib::_unlock(state);
+	return count;
+}
+
+/**
+ * \brief Number of timestamps overwritten before being read, since begin()
+ */
+unsigned long int uTimerLibCapture::getLost() {
+	return _lost;
+}
+
+/**
+ * \brief Timestamps frequency, in Hz
+ */
+unsigned long int uTimerLibCapture::getTicksHz() {
+	return _hz;
+}
+
+/**
+ * \brief Average period of last n captures, read or not
+ *
+ * @param	n		Number of periods to average; needs n + 1 timestamps
+ * @return	Period in microseconds; 0 if there are not enough captures
+ */
+float uTimerLibCapture::getPeriod_us(uint16_t n) {
+	if (n == 0 || n >= _size || _hz == 0) {
+		return 0;
+	}
+	unsigned long int state = uTimerLib::_lock();
+	if (_stored <= n) {
+		uTimerLib::_unlock(state);
+		return 0;
+	}
+	uint16_t last = (_head + _size - 1) % _size;
+	uint32_t ticks = _buffer[last] - _buffer[(last + _size - n) % _size];
+	uTimerLib::_unlock(state);
+	return (float) ticks * 1000000 / _hz / n;
+}
+
+/**
+ * \brief Average frequency of last n captures, read or not
+ *
+ * @param	n		Number of periods to average; needs n + 1 timestamps
+ * @return	Frequency in Hz; 0 if there are not enough captures
+ */
+float uTimerLibCapture::getFrequency(uint16_t n) {
+	float period = getPeriod_us(n);
+	return (period == 0) ? 0 : 1000000 / period;
+}
+
+/**
+ * \brief Internal function called on each captured edge, from timer interrupt
+ *
+ * When ring is full oldest timestamp is overwritten and counted as lost.
+ *
+ * @param	timestamp	32 bit timestamp in timer ticks
+ */
+void uTimerLibCapture::_interrupt(uint32_t timestamp) {
+	uTimerLibCapture *c = _instance;
+	if (c == NULL) {
+		return;
+	}
+	c->_buffer[c->_head] = timestamp;
+	c->_head = (c->_head + 1) % c->_size;
+	if (c->_head == c->_tail) {
+		c->_tail = (c->_tail + 1) % c->_size;
+		c->_lost++;
+	}
+	if (c->_stored < c->_size) {
+		c->_stored++;
+	}
+}
+
+#if defined(UTIMERLIB_CAPTURE_AVR)
+	/**
+	 * \brief Timer input capture interrupt hook: timestamps captured edge
+	 *
+	 * Defined as TIMER3_CAPT_vect (32U4) or TIMER1_CAPT_vect handler with UTIMERLIB_CAPTURE_HANDLER; otherwise call it from yours.
+	 */
+	void uTimerLibCapture::captureHandler() {
+		#ifdef __AVR_ATmega32U4__
+			TimerLib._capture(ICR3, TIFR3 & (1 << TOV3));
+		#else
+			TimerLib._capture(ICR1, TIFR1 & (1 << TOV1));
+		#endif
+	}
+
+	/**
+	 * \brief Timer overflow interrupt hook: extends timestamps
+	 *
+	 * Defined as TIMER3_OVF_vect (32U4) or TIMER1_OVF_vect handler with UTIMERLIB_CAPTURE_HANDLER; otherwise call it from yours.
+	 */
+	void uTimerLibCapture::overflowHandler() {
+		TimerLib._captureOverflow();
+	}
+
+	#if defined(UTIMERLIB_CAPTURE_HANDLER)
+		#ifdef __AVR_ATmega32U4__
+			ISR(TIMER3_CAPT_vect) {
+				uTimerLibCapture::captureHandler();
+			}
+			ISR(TIMER3_OVF_vect) {
+				uTimerLibCapture::overflowHandler();
+			}
+		#else
+			ISR(TIMER1_CAPT_vect) {
+				uTimerLibCapture::captureHandler();
+			}
+			ISR(TIMER1_OVF_vect) {
+				uTimerLibCapture::overflowHandler();
+			}
+		#endif
+	#endif
+#endif
@@ -0,0 +1,83 @@
+/**
+ * \class uTimerLibCapture
+ * \brief Input capture for uTimerLib: pin edges timestamped by timer hardware, buffered in a ring.
+ *
+ * Edge timestamps are taken by timer input capture hardware, so they don't depend on interrupt latency.
+ * They are extended to 32 bits counting timer overflows and buffered in a ring, to be read in batches.
+ * Average period and frequency of last captures can be calculated too.
+ *
+ * It uses TimerLib, so any setXXX call on TimerLib will stop captures.
+ *
+ * Usage:
+ *		* uint32_t captures[32]; uTimerLibCapture capture(captures, 32);* : ring buffer storage.
+ *		* capture.begin(pin, RISING);* : starts capturing edges on pin.
+ *		* capture.read(buffer, count);* : copies up to count timestamps, oldest first, and removes them from ring.
+ *		* capture.getPeriod_us(n);* / *capture.getFrequency(n);* : average of last n periods.
+ *		* capture.end();* : stops capturing.
+ *
+ * On AVR, timer capture and overflow interrupt vectors are defined and enabled only with UTIMERLIB_CAPTURE_HANDLER; otherwise call
+ * uTimerLibCapture::captureHandler() and uTimerLibCapture::overflowHandler() from your TIMER3_CAPT_vect and TIMER3_OVF_vect (32U4)
+ * or TIMER1_CAPT_vect and TIMER1_OVF_vect (UTIMERLIB_AVR_TIMER1) handlers, and enable them after begin() (ICIE and TOIE bits of TIMSK3 or TIMSK1).
+ *
+ * Pins and timestamps resolution:
+ *		* Atmel AVR 32U4:	ICP3 (13 on Leonardo), F_CPU / 8.
+ *		* Atmel AVR other:	ICP1 (8 on UNO) when UTIMERLIB_AVR_TIMER1 is defined, F_CPU / 8. Timer2 has no input capture.
+ *		* STM32:			Timer3 channel pins, ST's core only, 1MHz.
+ *		* SAMD21:			Any pin with external interrupt, using last EVSYS channel, 3MHz.
+ *
+ * @file uTimerLibCapture.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibCapture_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibCapture_
+
+	#include "uTimerLib.h"
+
+	// AVR input capture timer: Timer3 on 32U4, Timer1 with UTIMERLIB_AVR_TIMER1 (not ATtiny nor Digispark, same ones counting now_ticks() on timer)
+	#if defined(ARDUINO_ARCH_AVR) && defined(UTIMERLIB_NOW_TIMER) && (defined(__AVR_ATmega32U4__) || defined(UTIMERLIB_AVR_TIMER1))
+		/**
+		 * \brief Input capture uses its own timer interrupt vectors, see captureHandler() and overflowHandler()
+		 */
+		#define UTIMERLIB_CAPTURE_AVR
+	#endif
+
+	class uTimerLibCapture {
+		public:
+			uTimerLibCapture(uint32_t *, uint16_t);
+			bool begin(uint8_t, uint8_t = RISING);
+			void end();
+
+			uint16_t available();
+			uint16_t read(uint32_t *, uint16_t);
+			unsigned long int getLost();
+			unsigned long int getTicksHz();
+
+			float getPeriod_us(uint16_t = 1);
+			float getFrequency(uint16_t = 1);
+
+			#if defined(UTIMERLIB_CAPTURE_AVR)
+				static void captureHandler();
+				static void overflowHandler();
+			#endif
+
+		private:
+			static uTimerLibCapture *_instance;
+			static void _interrupt(uint32_t);
+
+			uint32_t *_buffer;
+			uint16_t _size;
+			volatile uint16_t _head = 0;	// Next write position
+			volatile uint16_t _tail = 0;	// Next read position
+			volatile uint16_t _stored = 0;	// Timestamps in ring, read or not, for averaging
+			volatile unsigned long int _lost = 0;
+			unsigned long int _hz = 0;
+	};
+
+#endif
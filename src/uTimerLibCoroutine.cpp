@@ -0,0 +1,186 @@
+/**
+ * \class uTimerLibTask
+ * \brief Coroutines for uTimerLib: sequential tasks sharing one timer, with co_await TimerLib.sleep_us(us).
+ *
+ * @file uTimerLibCoroutine.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibCoroutine.h"
+
+#if defined(UTIMERLIB_COROUTINES)
+
+	// Sleep slot states
+	#define UTIMERLIB_COROUTINE_FREE 0
+	#define UTIMERLIB_COROUTINE_SLEEPING 1
+	#define UTIMERLIB_COROUTINE_READY 2
+
+	std::coroutine_handle<> uTimerLibTask::_handles[UTIMERLIB_COROUTINE_FRAMES];
+	uint64_t uTimerLibTask::_wakeUp[UTIMERLIB_COROUTINE_FRAMES];
+	volatile uint8_t uTimerLibTask::_state[UTIMERLIB_COROUTINE_FRAMES];
+	volatile bool uTimerLibTask::_armed = false;
+	uint64_t uTimerLibTask::_next = 0;
+	volatile bool uTimerLibTask::_rearm = false;
+
+	// Coroutine frames pool
+	alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) static unsigned char _uTimerLibFrames[UTIMERLIB_COROUTINE_FRAMES][UTIMERLIB_COROUTINE_FRAME_SIZE];
+	static volatile bool _uTimerLibFrameUsed[UTIMERLIB_COROUTINE_FRAMES];
+
+	/**
+	 * \brief Index of a coroutine frame in pool
+	 *
+	 * @param	frame	Frame, as given by operator new (coroutine handle address)
+	 * @return	Index, or UTIMERLIB_COROUTINE_FRAMES if it's not from pool
+	 */
+	static uint8_t _uTimerLibFrame(void *frame) {
+		uintptr_t offset = (uintptr_t) frame - (uintptr_t) &_uTimerLibFrames[0][0];
+		if ((uintptr_t) frame < (uintptr_t) &_uTimerLibFrames[0][0] || offset >= sizeof(_uTimerLibFrames)) {
+			return UTIMERLIB_COROUTINE_FRAMES;
+		}
+		return offset / UTIMERLIB_COROUTINE_FRAME_SIZE;
+	}
+
+	/**
+	 * \brief Takes a coroutine frame from pool
+	 *
+	 * @param	size	Frame size needed
+	 * @return	Frame, or nullptr if there's no free one or it's too small (then task is not started)
+	 */
+	void *uTimerLibTask::promise_type::operator new(size_t size) noexcept {
+		if (size > UTIMERLIB_COROUTINE_FRAME_SIZE) {
+			return nullptr;
+		}
+		unsigned long int state = uTimerLib::_lock();
+		for (uint8_t i = 0; i < UTIMERLIB_COROUTINE_FRAMES; i++) {
+			if (!_uTimerLibFrameUsed[i]) {
+				_uTimerLibFrameUsed[i] = true;
+				uTimerLib::_unlock(state);
+				return _uTimerLibFrames[i];
+			}
+		}
+		uTimerLib::_unlock(state);
+		return nullptr;
+	}
+
+	/**
+	 * \brief Returns a coroutine frame to pool, when its task ends
+	 *
+	 * @param	frame	Frame taken by operator new
+	 */
+	void uTimerLibTask::promise_type::operator delete(void *frame) noexcept {
+		_uTimerLibFrameUsed[_uTimerLibFrame(frame)] = false;
+	}
+
+	/**
+	 * \brief Resumes tasks whose sleep has ended; call it from loop()
+	 *
+	 * Tasks are resumed here, in normal context, not in timer interrupt. If timeout has ended, TimerLib is set here for next wake up.
+	 */
+	void uTimerLibTask::run() {
+		if (_rearm) {
+			_arm();
+		}
+		for (uint8_t i = 0; i < UTIMERLIB_COROUTINE_FRAMES; i++) {
+			if (_state[i] == UTIMERLIB_COROUTINE_READY) {
+				std::coroutine_handle<> h = _handles[i];
+				_state[i] = UTIMERLIB_COROUTINE_FREE;
+				h.resume();
+			}
+		}
+	}
+
+	/**
+	 * \brief Internal: suspends coroutine h for us microseconds
+	 *
+	 * Sleep slot is the one of coroutine frame: it's free, as a task only sleeps once at a time and run() frees it before resuming.
+	 * Sets TimerLib again only if this is the nearest wake up.
+	 *
+	 * @param	h		Coroutine to resume
+	 * @param	us		Sleep time in microseconds
+	 * @return	false if it can't sleep (coroutine frame not from pool: not an uTimerLibTask), so coroutine is not suspended
+	 */
+	bool uTimerLibTask::_sleep(std::coroutine_handle<> h, unsigned long int us) {
+		uint8_t i = _uTimerLibFrame(h.address());
+		if (i == UTIMERLIB_COROUTINE_FRAMES) {
+			return false;
+		}
+		uint64_t wakeUp = uTimerLib::now_us() + us;
+		unsigned long int state = uTimerLib::_lock();
+		_handles[i] = h;
+		_wakeUp[i] = wakeUp;
+		_state[i] = UTIMERLIB_COROUTINE_SLEEPING;
+		bool arm = !_armed || wakeUp < _next;
+		uTimerLib::_unlock(state);
+		if (arm) {
+			_arm();
+		}
+		return true;
+	}
+
+	/**
+	 * \brief Queues tasks whose sleep has ended and takes the nearest wake up left to _next; called with library lock taken
+	 *
+	 * @param	now		Current time, now_us()
+	 * @return	true if there's a wake up left
+	 */
+	bool uTimerLibTask::_queue(uint64_t now) {
+		bool left = false;
+		for (uint8_t i = 0; i < UTIMERLIB_COROUTINE_FRAMES; i++) {
+			if (_state[i] != UTIMERLIB_COROUTINE_SLEEPING) {
+				continue;
+			}
+			if (_wakeUp[i] <= now) {
+				_state[i] = UTIMERLIB_COROUTINE_READY;
+			} else if (!left || _wakeUp[i] < _next) {
+				_next = _wakeUp[i];
+				left = true;
+			}
+		}
+		return left;
+	}
+
+	/**
+	 * \brief Queues tasks whose sleep has ended and sets TimerLib for the nearest wake up left; in normal context
+	 */
+	void uTimerLibTask::_arm() {
+		uint64_t now = uTimerLib::now_us();
+		unsigned long int state = uTimerLib::_lock();
+		_rearm = false;
+		bool armed = _queue(now);
+		_armed = armed;
+		uint64_t next = _next;
+		uTimerLib::_unlock(state);
+		if (armed) {
+			next -= now;
+			TimerLib.setTimeout_us(uTimerLibTask::_interrupt, (next > 0xFFFFFFFF) ? 0xFFFFFFFF : (unsigned long int) next);
+		}
+	}
+
+	/**
+	 * \brief Static envelope for TimerLib timeout, in interrupt: only queues tasks
+	 *
+	 * Timeout has ended, so TimerLib is free; it's set for next wake up by run() or by next sleep, never here.
+	 */
+	void uTimerLibTask::_interrupt() {
+		uint64_t now = uTimerLib::now_us();
+		unsigned long int state = uTimerLib::_lock();
+		_queue(now);
+		_armed = false;
+		_rearm = true;
+		uTimerLib::_unlock(state);
+	}
+
+	/**
+	 * \brief Awaitable sleep for coroutines: co_await TimerLib.sleep_us(us);
+	 *
+	 * @param	us		Sleep time in microseconds
+	 * @return	Awaitable
+	 */
+	uTimerLibSleep uTimerLib::sleep_us(unsigned long int us) {
+		return uTimerLibSleep(us);
+	}
+
+#endif
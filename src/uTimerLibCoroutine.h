@@ -0,0 +1,143 @@
+/**
+ * \class uTimerLibTask
+ * \brief Coroutines for uTimerLib: sequential tasks sharing one timer, with co_await TimerLib.sleep_us(us).
+ *
+ * Needs a C++20 toolchain with coroutines (e.g. ESP32 or SAMD51 with -std=gnu++20); otherwise nothing is defined.
+ *
+ * A task is a function returning uTimerLibTask. It runs until its first co_await, and each
+ * co_await TimerLib.sleep_us(us) suspends it until us microseconds have passed.
+ * All sleeping tasks share TimerLib: it's set as a timeout for the nearest wake up.
+ * Timer interrupt only queues tasks to be resumed; they are resumed from loop() by uTimerLibTask::run(),
+ * so tasks run in normal context and can use Serial, delay, etc. TimerLib is set for next wake up there too,
+ * as executive batches its changes, so timer is never set up from its own interrupt.
+ *
+ * Coroutine frames are taken from a fixed pool, not from heap: UTIMERLIB_COROUTINE_FRAMES frames of
+ * UTIMERLIB_COROUTINE_FRAME_SIZE bytes. If there's no free frame (or task needs a bigger one), task is not started.
+ * Each frame has its own sleep slot, so a started task can always sleep. co_await TimerLib.sleep_us(us) returns false,
+ * not sleeping, only if it's awaited from a coroutine that is not an uTimerLibTask (no frame from pool).
+ *
+ * It uses TimerLib, so any setXXX call on TimerLib will stop sleeping tasks (they won't be resumed).
+ *
+ * Usage:
+ *		* uTimerLibTask blink() { for (;;) { digitalWrite(13, !digitalRead(13)); co_await TimerLib.sleep_us(500000); } }* : a task.
+ *		* blink();* : starts the task; returns false if there's no free frame.
+ *		* uTimerLibTask::run();* : in loop(), resumes tasks whose sleep has ended.
+ *		* if (!co_await TimerLib.sleep_us(us)) { ... }* : optional check, only needed if awaited from other coroutine types.
+ *
+ * @file uTimerLibCoroutine.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibCoroutine_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibCoroutine_
+
+	#include "uTimerLib.h"
+
+	#if defined(UTIMERLIB_COROUTINES)
+		#include <coroutine>
+
+		/**
+		 * \brief Number of coroutine frames in pool; maximum tasks alive at once
+		 */
+		#ifndef UTIMERLIB_COROUTINE_FRAMES
+			#define UTIMERLIB_COROUTINE_FRAMES 8
+		#endif
+
+		/**
+		 * \brief Size of each coroutine frame in pool, in bytes; it has to hold task locals and arguments
+		 */
+		#ifndef UTIMERLIB_COROUTINE_FRAME_SIZE
+			#define UTIMERLIB_COROUTINE_FRAME_SIZE 256
+		#endif
+
+		class uTimerLibTask {
+			public:
+				/**
+				 * \brief Coroutine promise: frame from pool, starts at once and frees its frame when it ends
+				 */
+				struct promise_type {
+					uTimerLibTask get_return_object() noexcept {
+						return uTimerLibTask(true);
+					}
+					static uTimerLibTask get_return_object_on_allocation_failure() noexcept {
+						return uTimerLibTask(false);
+					}
+					std::suspend_never initial_suspend() noexcept {
+						return {};
+					}
+					std::suspend_never final_suspend() noexcept {
+						return {};
+					}
+					void return_void() noexcept {}
+					void unhandled_exception() noexcept {}
+
+					static void *operator new(size_t) noexcept;
+					static void operator delete(void *) noexcept;
+				};
+
+				static void run();
+
+				/**
+				 * \brief Task has been started
+				 *
+				 * @return	false if there was no free frame in pool
+				 */
+				explicit operator bool() const {
+					return _started;
+				}
+
+				/**
+				 * \brief Internal: suspends coroutine h for us microseconds; false if it's not an uTimerLibTask
+				 */
+				static bool _sleep(std::coroutine_handle<>, unsigned long int);
+
+			private:
+				explicit uTimerLibTask(bool started) : _started(started) {}
+				bool _started;
+
+				static void _interrupt();
+				static void _arm();
+				static bool _queue(uint64_t);
+
+				// Wake up TimerLib is set for, if any
+				static volatile bool _armed;
+				static uint64_t _next;
+				// Timeout has ended in interrupt: run() sets TimerLib for next wake up
+				static volatile bool _rearm;
+
+				// Sleeping coroutines: slot of same index than task frame, as each task sleeps once at a time
+				static std::coroutine_handle<> _handles[UTIMERLIB_COROUTINE_FRAMES];
+				static uint64_t _wakeUp[UTIMERLIB_COROUTINE_FRAMES];
+				static volatile uint8_t _state[UTIMERLIB_COROUTINE_FRAMES];
+		};
+
+		/**
+		 * \brief Awaitable returned by TimerLib.sleep_us; co_await result is false if it has not slept (coroutine not an uTimerLibTask)
+		 */
+		class uTimerLibSleep {
+			public:
+				explicit uTimerLibSleep(unsigned long int us) : _us(us), _slept(true) {}
+				bool await_ready() const noexcept {
+					return _us == 0;
+				}
+				bool await_suspend(std::coroutine_handle<> h) noexcept {
+					_slept = uTimerLibTask::_sleep(h, _us);
+					return _slept;
+				}
+				bool await_resume() const noexcept {
+					return _slept;
+				}
+
+			private:
+				unsigned long int _us;
+				bool _slept;
+		};
+	#endif
+
+#endif
@@ -0,0 +1,249 @@
+/**
+ * \class uTimerLibExecutive
+ * \brief Cyclic executive for uTimerLib: phase-aligned tasks sharing one base tick.
+ *
+ * @file uTimerLibExecutive.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibExecutive.h"
+
+uTimerLibExecutive *uTimerLibExecutive::_instance = NULL;
+
+/**
+ * \brief Constructor
+ *
+ * Storage is split in two frame tables: one in use and one where changes are built while running.
+ *
+ * @param	frames	Frame tables storage, two bytes for each base tick of the hyperperiod
+ * @param	size	Size of frame tables storage
+ */
+uTimerLibExecutive::uTimerLibExecutive(uint8_t *frames, uint16_t size) {
+	_size = size / 2;
+	_tables[0].frames = frames;
+	_tables[1].frames = frames + _size;
+	_tables[0].length = _tables[1].length = 0;
+}
+
+/**
+ * \brief Registers a task to be called each multiple base ticks
+ *
+ * Tasks are kept ordered by multiple, so faster tasks are called first on each frame.
+ * If executive is running, change is applied at once (unless inside a batch).
+ *
+ * @param	cb			Callback function to be called
+ * @param	multiple	Task period, in base ticks
+ * @return	false if multiple is 0, there's no room for more tasks or new hyperperiod doesn't fit in frame table (then task is not added)
+ */
+bool uTimerLibExecutive::addTask(void (* cb)(), uint16_t multiple) {
+	if (multiple == 0 || _count >= UTIMERLIB_EXECUTIVE_MAX_TASKS) {
+		return false;
+	}
+	uint8_t i = _count;
+	while (i > 0 && _multiples[i - 1] > multiple) {
+		_tasks[i] = _tasks[i - 1];
+		_multiples[i] = _multiples[i - 1];
+		i--;
+	}
+	_tasks[i] = cb;
+	_multiples[i] = multiple;
+	_count++;
+	if (_hyperperiod() == 0) { // Doesn't fit: back to previous tasks, running table is untouched
+		_count--;
+		for (; i < _count; i++) {
+			_tasks[i] = _tasks[i + 1];
+			_multiples[i] = _multiples[i + 1];
+		}
+		return false;
+	}
+	return _batch > 0 || _apply();
+}
+
+/**
+ * \brief Unregisters a task
+ *
+ * If executive is running, change is applied at once (unless inside a batch). Removing last task stops it.
+ *
+ * @param	cb		Callback function of the task
+ * @return	false if task was not found
+ */
+bool uTimerLibExecutive::removeTask(void (* cb)()) {
+	for (uint8_t i = 0; i < _count; i++) {
+		if (_tasks[i] == cb) {
+			_count--;
+			for (; i < _count; i++) {
+				_tasks[i] = _tasks[i + 1];
+				_multiples[i] = _multiples[i + 1];
+			}
+			if (_batch == 0) {
+				_apply();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * \brief Starts a batch: addTask / removeTask changes are not applied until commitBatch()
+ *
+ * Batches can be nested; changes are applied on outer commitBatch().
+ */
+void uTimerLibExecutive::beginBatch() {
+	_batch++;
+}
+
+/**
+ * \brief Ends a batch, applying all changes in one critical section
+ *
+ * Frame table is rebuilt once and tasks already running keep their phase.
+ * Timer is not reprogrammed, as base period doesn't change.
+ *
+ * @return	false if there're no tasks left and executive was running (then it's stopped)
+ */
+bool uTimerLibExecutive::commitBatch() {
+	if (_batch > 0 && --_batch > 0) {
+		return true;
+	}
+	return _apply();
+}
+
+/**
+ * \brief Builds frame table and starts the base tick
+ *
+ * @param	us		Base period in microseconds
+ * @return	false if there're no tasks or hyperperiod doesn't fit in frame table
+ */
+bool uTimerLibExecutive::begin(unsigned long int us) {
+	end();
+	uint16_t length = _hyperperiod();
+	if (length == 0) {
+		return false;
+	}
+	_fill(&_tables[_front], length);
+	_frame = 0;
+	_instance = this;
+	TimerLib.setInterval_us(uTimerLibExecutive::_interrupt, us);
+	return true;
+}
+
+/**
+ * \brief Stops the executive
+ */
+void uTimerLibExecutive::end() {
+	if (_instance == this) {
+		TimerLib.clearTimer();
+		_instance = NULL;
+	}
+}
+
+/**
+ * \brief Calculates hyperperiod: LCM of all multiples
+ *
+ * @return	Hyperperiod in base ticks; 0 if there're no tasks or it doesn't fit in frame table
+ */
+uint16_t uTimerLibExecutive::_hyperperiod() {
+	if (_count == 0) {
+		return 0;
+	}
+	unsigned long int length = 1;
+	for (uint8_t i = 0; i < _count; i++) {
+		unsigned long int a = length, b = _multiples[i];
+		while (b != 0) {
+			unsigned long int t = a % b;
+			a = b;
+			b = t;
+		}
+		length = length / a * _multiples[i];
+		if (length > _size) {
+			return 0;
+		}
+	}
+	return length;
+}
+
+/**
+ * \brief Precomputes a frame table, one bitmask of due tasks for each base tick, and sets tasks used on base tick
+ *
+ * No divisions: each task just sets its bit every multiple frames.
+ *
+ * @param	table	Table to fill; not the one in use if executive is running
+ * @param	length	Hyperperiod, from _hyperperiod()
+ */
+void uTimerLibExecutive::_fill(Table *table, uint16_t length) {
+	uint16_t f;
+	for (f = 0; f < length; f++) {
+		table->frames[f] = 0;
+	}
+	for (uint8_t i = 0; i < _count; i++) {
+		for (f = 0; f < length; f += _multiples[i]) {
+			table->frames[f] |= (1 << i);
+		}
+		table->run[i] = _tasks[i];
+	}
+	table->length = length;
+}
+
+/**
+ * \brief Applies registered tasks to a running executive
+ *
+ * New frame table is built aside, with interrupts enabled; critical section only switches to it.
+ * Current frame is kept modulo new hyperperiod, so tasks already running keep their phase.
+ *
+ * @return	false if there're no tasks left (then executive is stopped)
+ */
+bool uTimerLibExecutive::_apply() {
+	if (_instance != this) { // Not running, will be applied on begin()
+		return true;
+	}
+	uint16_t length = _hyperperiod();
+	if (length == 0) {
+		end();
+		return false;
+	}
+	uint8_t back = _front ^ 1;
+	_fill(&_tables[back], length);
+	unsigned long int state = uTimerLib::_lock();
+	_front = back;
+	_frame = _frame % length;
+	uTimerLib::_unlock(state);
+	return true;
+}
+
+/**
+ * \brief Internal function called on each base tick
+ *
+ * Calls tasks due on current frame, fastest first.
+ * Table, frame and due tasks are read in the same critical section _apply() switches tables in, as on ESP32 it can run on
+ * the other core meanwhile; tasks are called out of it, from a copy, so a table built aside later can't change them.
+ */
+void uTimerLibExecutive::_tick() {
+	void (*run[UTIMERLIB_EXECUTIVE_MAX_TASKS])();
+	uint8_t n = 0;
+	unsigned long int state = uTimerLib::_lock();
+	Table *table = &_tables[_front];
+	uint16_t frame = _frame;
+	uint8_t mask = table->frames[frame];
+	_frame = (frame + 1 == table->length) ? 0 : frame + 1;
+	for (uint8_t i = 0; mask != 0; i++, mask >>= 1) {
+		if (mask & 1) {
+			run[n++] = table->run[i];
+		}
+	}
+	uTimerLib::_unlock(state);
+	for (uint8_t i = 0; i < n; i++) {
+		run[i]();
+	}
+}
+
+/**
+ * \brief Static envelope for base tick
+ */
+void uTimerLibExecutive::_interrupt() {
+	if (_instance != NULL) {
+		_instance->_tick();
+	}
+}
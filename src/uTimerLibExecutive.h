@@ -0,0 +1,98 @@
+/**
+ * \class uTimerLibExecutive
+ * \brief Cyclic executive for uTimerLib: phase-aligned tasks sharing one base tick.
+ *
+ * Tasks are registered with a period that is an integer multiple of a base period.
+ * A frame table covering the hyperperiod (LCM of all multiples) is precomputed in begin(),
+ * so each base tick only reads one frame and calls the tasks due on it.
+ * Changes while running are built on a second table, aside, and only switched to in a critical section.
+ * All tasks are aligned to frame 0 and, on each frame, are called fastest first.
+ *
+ * It uses TimerLib, so any setXXX call on TimerLib will stop the executive.
+ *
+ * Usage:
+ *		* uint8_t frames[200]; uTimerLibExecutive executive(frames, sizeof(frames));* : frame tables storage, two bytes each base tick of the hyperperiod (table in use and one built aside).
+ *		* executive.addTask(callback_function, multiple);* : callback_function will be called each multiple base ticks.
+ *		* executive.begin(microseconds);* : builds frame table and starts calling tasks with a base tick of microseconds.
+ *		* executive.end();* : stops the executive.
+ *		* executive.batch([&]{ ... });* : applies all addTask / removeTask calls inside at once (or use beginBatch() and commitBatch()).
+ *
+ * @file uTimerLibExecutive.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibExecutive_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibExecutive_
+
+	#include "uTimerLib.h"
+
+	/**
+	 * \brief Maximum number of tasks; each frame of the table is a bitmask of tasks
+	 */
+	#define UTIMERLIB_EXECUTIVE_MAX_TASKS 8
+
+	class uTimerLibExecutive {
+		public:
+			uTimerLibExecutive(uint8_t *, uint16_t);
+			bool addTask(void (*) (), uint16_t);
+			bool removeTask(void (*) ());
+			bool begin(unsigned long int);
+			void end();
+
+			void beginBatch();
+			bool commitBatch();
+
+			/**
+			 * \brief Applies all addTask / removeTask calls done inside f at once, in one critical section
+			 *
+			 * @param	f		Function or lambda doing the changes
+			 * @return	false if there're no tasks left and executive was running (then it's stopped)
+			 */
+			template <typename F> bool batch(F f) {
+				beginBatch();
+				f();
+				return commitBatch();
+			}
+
+			/**
+			 * \brief Internal function called on each base tick
+			 */
+			void _tick();
+
+		private:
+			static uTimerLibExecutive *_instance;
+			static void _interrupt();
+
+			/**
+			 * \brief Frame table, with tasks used on base tick matching its bits
+			 */
+			struct Table {
+				uint8_t *frames;
+				void (*run[UTIMERLIB_EXECUTIVE_MAX_TASKS])();
+				uint16_t length;
+			};
+
+			uint16_t _hyperperiod();
+			void _fill(Table *, uint16_t);
+			bool _apply();
+
+			// Registered tasks; copied to a table when changes are applied
+			void (*_tasks[UTIMERLIB_EXECUTIVE_MAX_TASKS])();
+			uint16_t _multiples[UTIMERLIB_EXECUTIVE_MAX_TASKS];
+			uint8_t _count = 0;
+			uint8_t _batch = 0;
+
+			// Double buffer: base tick uses _tables[_front]; the other one is built by _apply() and switched to under lock, that base tick takes too
+			Table _tables[2];
+			volatile uint8_t _front = 0;
+			uint16_t _size;
+			volatile uint16_t _frame = 0;
+	};
+
+#endif
@@ -0,0 +1,257 @@
+/**
+ * \class uTimerLibPWM
+ * \brief Software PWM for uTimerLib: many channels on any pins, timer armed only for each distinct edge.
+ *
+ * @file uTimerLibPWM.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibPWM.h"
+
+uTimerLibPWM *uTimerLibPWM::_instance = NULL;
+
+/**
+ * \brief Adds a channel on a pin, set as output and low (duty 0)
+ *
+ * @param	pin		Pin to drive
+ * @return	false if pin is already attached or there's no room for more channels
+ */
+bool uTimerLibPWM::attach(uint8_t pin) {
+	if (_count >= UTIMERLIB_PWM_MAX_CHANNELS) {
+		return false;
+	}
+	for (uint8_t i = 0; i < _count; i++) {
+		if (_pins[i] == pin) {
+			return false;
+		}
+	}
+	pinMode(pin, OUTPUT);
+	digitalWrite(pin, LOW);
+	_pins[_count] = pin;
+	_duty[_count] = 0;
+	_count++;
+	return true;
+}
+
+/**
+ * \brief Sets channel high time
+ *
+ * If PWM is running, new duty is applied at next period start.
+ *
+ * @param	pin		Pin of the channel
+ * @param	high	High time in microseconds; 0 is always low, period or more always high
+ * @return	false if pin is not attached
+ */
+bool uTimerLibPWM::setDuty_us(uint8_t pin, unsigned long int high) {
+	for (uint8_t i = 0; i < _count; i++) {
+		if (_pins[i] == pin) {
+			_duty[i] = high;
+			if (_instance == this) {
+				_build();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * \brief Starts PWM on all attached channels
+ *
+ * @param	us		Period in microseconds
+ * @return	false if period is not longer than UTIMERLIB_PWM_MIN_GAP_US, there're no channels or device can't reload timer counts
+ */
+bool uTimerLibPWM::begin(unsigned long int us) {
+	end();
+	if (us <= UTIMERLIB_PWM_MIN_GAP_US || _count == 0) {
+		return false;
+	}
+	TimerLib.setInterval_us(uTimerLibPWM::_interrupt, us); // Prescaler for whole period; counts are set by _reload()
+	_periodTicks = TimerLib._reloadTicks(us);
+	_gap = TimerLib._reloadTicks(UTIMERLIB_PWM_MIN_GAP_US);
+	if (_periodTicks <= _gap || !TimerLib._reload(_periodTicks)) { // Also 0: no _reload() on this device; or period too long for it
+		TimerLib.clearTimer();
+		return false;
+	}
+	_period = us;
+	_build();
+	unsigned long int state = uTimerLib::_lock();
+	// First period starts now: its first edges are done, and timer restarted counting to next one
+	_due = Edges();
+	_at = 0;
+	_startPeriod(&_due);
+	long int next = _plan(&_due);
+	_do(&_due);
+	TimerLib._reload(next);
+	#if defined(ARDUINO_ARCH_ESP32)
+		// esp_timer_stop() and esp_timer_start() are not called in this critical section. First edge is UTIMERLIB_PWM_MIN_GAP_US away at
+		// least, so count after it is loaded in time unless this task is held off that long; first period is one count off then
+		uTimerLib::_unlock(state);
+		TimerLib.restart();
+		state = uTimerLib::_lock();
+	#else
+		TimerLib.restart(); // Interrupts masked: count after it is loaded before first edge
+	#endif
+	_at = next;
+	// Count after it, as on each edge (this _reload() also drops fast path restart() may have chosen)
+	_due = Edges();
+	next = _plan(&_due);
+	TimerLib._reload(next - _at);
+	_at = next;
+	_instance = this;
+	uTimerLib::_unlock(state);
+	return true;
+}
+
+/**
+ * \brief Stops PWM and sets all channels low
+ */
+void uTimerLibPWM::end() {
+	if (_instance == this) {
+		TimerLib.clearTimer();
+		_instance = NULL;
+		_write(((uint32_t) 1 << _count) - 1, LOW);
+	}
+}
+
+/**
+ * \brief Builds event list for current duties on back buffer, to be taken at next period start
+ *
+ * Runs in normal context: high times are converted to timer ticks and falling edges sorted by them here,
+ * equal times merged in one event, so interrupt only walks the list.
+ */
+void uTimerLibPWM::_build() {
+	unsigned long int state = uTimerLib::_lock();
+	__atomic_store_n(&_swap, false, __ATOMIC_RELAXED); // Back buffer is not taken while it's built
+	uint8_t back = _front ^ 1;
+	uTimerLib::_unlock(state);
+
+	Event *events = _events[back];
+	uint8_t n = 0;
+	uint16_t high = 0;
+	for (uint8_t i = 0; i < _count; i++) {
+		if (_duty[i] == 0) {
+			continue;
+		}
+		high |= (1 << i);
+		if (_duty[i] >= _period) {
+			continue;
+		}
+		unsigned long int at = TimerLib._reloadTicks(_duty[i]);
+		uint8_t j = 0;
+		while (j < n && events[j].at < at) {
+			j++;
+		}
+		if (j < n && events[j].at == at) {
+			events[j].mask |= (1 << i);
+			continue;
+		}
+		for (uint8_t k = n; k > j; k--) {
+			events[k] = events[k - 1];
+		}
+		events[j].at = at;
+		events[j].mask = (1 << i);
+		n++;
+	}
+	events[n].at = _periodTicks;
+	events[n].mask = 0;
+	_high[back] = high;
+	__atomic_store_n(&_swap, true, __ATOMIC_RELEASE); // List is written before, also as seen from interrupt on other core (ESP32)
+}
+
+/**
+ * \brief Plans a period start: takes new event list if there's one, and its channels to set high
+ *
+ * @param	edges	Edge being planned
+ */
+void uTimerLibPWM::_startPeriod(Edges *edges) {
+	if (__atomic_load_n(&_swap, __ATOMIC_ACQUIRE)) { // List built by _build() is seen complete
+		_front ^= 1;
+		__atomic_store_n(&_swap, false, __ATOMIC_RELAXED);
+		edges->off = (((uint32_t) 1 << _count) - 1) & ~_high[_front]; // Channels that were always high may be off now
+	}
+	_next = 0;
+	edges->high = _high[_front];
+	edges->start = true;
+}
+
+/**
+ * \brief Plans edge at _at: all events due (or closer than UTIMERLIB_PWM_MIN_GAP_US), starting next period if it's due too
+ *
+ * @param	edges	Edge being planned
+ * @return	Time of next edge, in ticks from period start of _at (more than period if it's in next one)
+ */
+long int uTimerLibPWM::_plan(Edges *edges) {
+	for (;;) {
+		Event *event = &_events[_front][_next];
+		if ((long int) event->at > _at + (long int) _gap) {
+			return event->at;
+		}
+		if (event->mask != 0) {
+			if (edges->start) {
+				edges->lowNext |= event->mask;
+			} else {
+				edges->low |= event->mask;
+			}
+			_next++;
+			continue;
+		}
+		// Period end
+		_at -= _periodTicks;
+		_startPeriod(edges);
+	}
+}
+
+/**
+ * \brief Sets channels of a planned edge
+ *
+ * @param	edges	Planned edge
+ */
+void uTimerLibPWM::_do(const Edges *edges) {
+	_write(edges->low, LOW);
+	if (edges->start) {
+		_write(edges->off, LOW);
+		_write(edges->high, HIGH);
+	}
+	_write(edges->lowNext, LOW);
+}
+
+/**
+ * \brief Sets a value on channels of a bitmask
+ *
+ * @param	mask	Channels bitmask
+ * @param	value	HIGH or LOW
+ */
+void uTimerLibPWM::_write(uint16_t mask, uint8_t value) {
+	for (uint8_t i = 0; mask != 0; i++, mask >>= 1) {
+		if (mask & 1) {
+			digitalWrite(_pins[i], value);
+		}
+	}
+}
+
+/**
+ * \brief Internal function called on each edge
+ *
+ * Called on the compare planned in _due. Timer is already counting to next edge, at _at, as it was loaded on previous one:
+ * sets _due channels, plans edge at _at and loads count after running one with ticks from it to the edge after, keeping prescaler.
+ */
+void uTimerLibPWM::_tick() {
+	_do(&_due);
+	_due = Edges();
+	long int next = _plan(&_due);
+	TimerLib._reload(next - _at);
+	_at = next;
+}
+
+/**
+ * \brief Static envelope for TimerLib interval
+ */
+void uTimerLibPWM::_interrupt() {
+	if (_instance != NULL) {
+		_instance->_tick();
+	}
+}
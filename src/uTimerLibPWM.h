@@ -0,0 +1,118 @@
+/**
+ * \class uTimerLibPWM
+ * \brief Software PWM for uTimerLib: many channels on any pins, timer armed only for each distinct edge.
+ *
+ * All channels share one period. They go high at period start and each one goes low at its high time.
+ * Falling edges are sorted into an event list, one event for each distinct high time, precomputed out of interrupts,
+ * so timer counts up to the next edge only: CPU usage depends on the number of distinct edges,
+ * not on PWM resolution nor number of channels.
+ *
+ * Duty changes are double-buffered: a new event list is built aside and taken at next period start,
+ * so a period never mixes old and new duties.
+ *
+ * Timer is set up once as an interval for the whole period, so its prescaler fits it, and edges are timed in its ticks.
+ * Timer reloads counts buffered, as next interval period, so edges are planned one ahead: on each edge, the count after
+ * running one is loaded with ticks between next two edges. Counter is never read nor stopped, so interrupt latency doesn't
+ * add up along the period and there's no wait for register synchronization. Edges closer than UTIMERLIB_PWM_MIN_GAP_US
+ * are done in the same interrupt.
+ *
+ * Supported on AVR (not ATtiny nor Digispark), SAM, SAMD21 and SAMD51 (periods up to 65535 timer ticks, 0.55s at 120MHz).
+ * On ESP32 each edge restarts esp_timer from the interrupt, so latency adds up. On other devices begin() returns false.
+ *
+ * It uses TimerLib, so any setXXX call on TimerLib will stop PWM.
+ *
+ * Usage:
+ *		* uTimerLibPWM pwm;* : PWM engine.
+ *		* pwm.attach(pin);* : adds a channel on pin (up to 16).
+ *		* pwm.setDuty_us(pin, high);* : sets channel high time, in microseconds; 0 is always low, period or more always high.
+ *		* pwm.begin(period);* : starts PWM with a period in microseconds; it has to be longer than UTIMERLIB_PWM_MIN_GAP_US.
+ *		* pwm.end();* : stops PWM and sets all channels low.
+ *
+ * @file uTimerLibPWM.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibPWM_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibPWM_
+
+	#include "uTimerLib.h"
+
+	/**
+	 * \brief Maximum number of channels; each event is a bitmask of channels
+	 */
+	#define UTIMERLIB_PWM_MAX_CHANNELS 16
+
+	/**
+	 * \brief Edges closer than this to current one, in microseconds, are done at once instead of counting up to them
+	 */
+	#ifndef UTIMERLIB_PWM_MIN_GAP_US
+		#define UTIMERLIB_PWM_MIN_GAP_US 10
+	#endif
+
+	class uTimerLibPWM {
+		public:
+			bool attach(uint8_t);
+			bool setDuty_us(uint8_t, unsigned long int);
+			bool begin(unsigned long int);
+			void end();
+
+			/**
+			 * \brief Internal function called on each edge
+			 */
+			void _tick();
+
+		private:
+			static uTimerLibPWM *_instance;
+			static void _interrupt();
+
+			/**
+			 * \brief Channels to set on an edge: going low, then on period start ones turned off and going high, then going low in new period
+			 */
+			struct Edges {
+				uint16_t low;
+				uint16_t off;
+				uint16_t high;
+				uint16_t lowNext;
+				bool start;
+			};
+
+			void _build();
+			void _startPeriod(Edges *);
+			long int _plan(Edges *);
+			void _do(const Edges *);
+			void _write(uint16_t, uint8_t);
+
+			uint8_t _pins[UTIMERLIB_PWM_MAX_CHANNELS];
+			unsigned long int _duty[UTIMERLIB_PWM_MAX_CHANNELS];
+			uint8_t _count = 0;
+			unsigned long int _period = 0;
+
+			/**
+			 * \brief Event: channels going low at a time from period start, in timer ticks; last one, with no channels, is period end
+			 */
+			struct Event {
+				unsigned long int at;
+				uint16_t mask;
+			};
+
+			// Double buffer: interrupt uses _front list; the other one is built by _build() and taken at period start if _swap is set,
+			// published with release and read with acquire order
+			Event _events[2][UTIMERLIB_PWM_MAX_CHANNELS + 1];
+			uint16_t _high[2] = {0, 0};	// Channels going high at period start
+			volatile uint8_t _front = 0;
+			volatile bool _swap = false;
+
+			Edges _due = {0, 0, 0, 0, false};	// Planned for compare timer is counting to
+			uint8_t _next = 0;			// Next event of _front list not planned yet
+			long int _at = 0;			// Time of last planned compare, in ticks from its period start
+			unsigned long int _periodTicks = 0;
+			unsigned long int _gap = 0;		// UTIMERLIB_PWM_MIN_GAP_US in timer ticks
+	};
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * \class uTimerLibStream
+ * \brief Timer-paced DMA streaming for uTimerLib: one sample written to a peripheral each timer period, with no interrupt per sample.
+ *
+ * @file uTimerLibStream.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#include "uTimerLibStream.h"
+
+#if defined(UTIMERLIB_USE_DMA) && (defined(_SAMD21_) || defined(__SAMD51__))
+
+	uTimerLibStream *uTimerLibStream::_instance = NULL;
+
+	// DMAC channel 0 descriptor (first of BASEADDR table) and the one linked to it, one for each half; 128 bit aligned
+	__attribute__((__aligned__(16))) static DmacDescriptor _uTimerLibStreamDescriptors[2];
+	__attribute__((__aligned__(16))) static DmacDescriptor _uTimerLibStreamWriteback[1];
+
+	/**
+	 * \brief Constructor
+	 *
+	 * @param	dst		Peripheral register to write to
+	 * @param	size	Sample size in bytes: 1, 2 or 4
+	 */
+	uTimerLibStream::uTimerLibStream(volatile void *dst, uint8_t size) {
+		_dst = dst;
+		_size = size;
+	}
+
+	/**
+	 * \brief Starts sending buffer circularly, one sample each us microseconds
+	 *
+	 * @param	buffer	Samples buffer, both halves
+	 * @param	samples	Number of samples in buffer; even, each half has samples / 2
+	 * @param	us		Sample period in microseconds
+	 * @param	cb		Callback function called with 0 or 1 when that half has been sent (can be NULL)
+	 * @return	false if samples or sample size are not valid or period doesn't fit in a single compare
+	 */
+	bool uTimerLibStream::begin(const void *buffer, uint16_t samples, unsigned long int us, void (* cb)(uint8_t)) {
+		if (samples < 2 || (samples & 1) || (_size != 1 && _size != 2 && _size != 4)) {
+			return false;
+		}
+		end();
+		_cb = cb;
+		_half = 0;
+		_instance = this;
+
+		uint16_t count = samples >> 1;
+		uint32_t bytes = (uint32_t) count * _size;
+		for (uint8_t i = 0; i < 2; i++) {
+			// Source address is the end of the block when it's incremented
+			_uTimerLibStreamDescriptors[i].BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BLOCKACT_INT | DMAC_BTCTRL_BEATSIZE(_size >> 1) | DMAC_BTCTRL_SRCINC;
+			_uTimerLibStreamDescriptors[i].BTCNT.reg = count;
+			_uTimerLibStreamDescriptors[i].SRCADDR.reg = (uint32_t) buffer + bytes * (i + 1);
+			_uTimerLibStreamDescriptors[i].DSTADDR.reg = (uint32_t) _dst;
+			_uTimerLibStreamDescriptors[i].DESCADDR.reg = (uint32_t) &_uTimerLibStreamDescriptors[1 - i];
+		}
+
+		#ifdef _SAMD21_
+			PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+			PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+		#else
+			MCLK->AHBMASK.reg |= MCLK_AHBMASK_DMAC;
+		#endif
+
+		DMAC->CTRL.bit.DMAENABLE = 0;
+		DMAC->BASEADDR.reg = (uint32_t) _uTimerLibStreamDescriptors;
+		DMAC->WRBADDR.reg = (uint32_t) _uTimerLibStreamWriteback;
+		DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+
+		// One beat each timer overflow
+		#ifdef _SAMD21_
+			DMAC->CHID.reg = DMAC_CHID_ID(0);
+			DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+			while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST);
+			DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(TC3_DMAC_ID_OVF) | DMAC_CHCTRLB_TRIGACT_BEAT;
+			DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+			#if defined(UTIMERLIB_DMA_HANDLER)
+				NVIC_ClearPendingIRQ(DMAC_IRQn);
+				NVIC_EnableIRQ(DMAC_IRQn);
+			#endif
+			DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+		#else
+			DMAC->Channel[0].CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+			while (DMAC->Channel[0].CHCTRLA.reg & DMAC_CHCTRLA_SWRST);
+			DMAC->Channel[0].CHCTRLA.reg = DMAC_CHCTRLA_TRIGSRC(TC1_DMAC_ID_OVF) | DMAC_CHCTRLA_TRIGACT_BURST | DMAC_CHCTRLA_BURSTLEN_SINGLE;
+			DMAC->Channel[0].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+			#if defined(UTIMERLIB_DMA_HANDLER)
+				NVIC_ClearPendingIRQ(DMAC_0_IRQn);
+				NVIC_EnableIRQ(DMAC_0_IRQn);
+			#endif
+			DMAC->Channel[0].CHCTRLA.bit.ENABLE = 1;
+		#endif
+
+		TimerLib.setInterval_us(NULL, us);
+		if (!TimerLib._freeRun()) {
+			end();
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * \brief Stops streaming and timer
+	 */
+	void uTimerLibStream::end() {
+		if (_instance != this) {
+			return;
+		}
+		TimerLib.clearTimer();
+		#ifdef _SAMD21_
+			DMAC->CHID.reg = DMAC_CHID_ID(0);
+			DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+		#else
+			DMAC->Channel[0].CHCTRLA.bit.ENABLE = 0;
+		#endif
+		_instance = NULL;
+	}
+
+	/**
+	 * \brief Internal function called on each half transfer completion
+	 *
+	 * Halves are sent alternately, so a counter tells which one has been completed.
+	 */
+	void uTimerLibStream::_interrupt() {
+		if (_instance == NULL) {
+			return;
+		}
+		uint8_t half = _instance->_half;
+		_instance->_half = 1 - half;
+		if (_instance->_cb != NULL) {
+			_instance->_cb(half);
+		}
+	}
+
+	/**
+	 * \brief DMAC interrupt hook: checks channel 0 block transfer complete and calls stream callback
+	 *
+	 * Defined as DMAC interrupt handler with UTIMERLIB_DMA_HANDLER; otherwise call it from your DMAC_Handler (SAMD21)
+	 * or DMAC_0_Handler (SAMD51). Other channels flags are not touched, and SAMD21 channel selection is restored.
+	 */
+	void uTimerLibStream::dmaHandler() {
+		#ifdef _SAMD21_
+			uint8_t chid = DMAC->CHID.reg;
+			DMAC->CHID.reg = DMAC_CHID_ID(0);
+			bool done = DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL;
+			if (done) {
+				DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+			}
+			DMAC->CHID.reg = chid;
+		#else
+			bool done = DMAC->Channel[0].CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL;
+			if (done) {
+				DMAC->Channel[0].CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+			}
+		#endif
+		if (done) {
+			_interrupt();
+		}
+	}
+
+	#if defined(UTIMERLIB_DMA_HANDLER)
+		#ifdef _SAMD21_
+			/**
+			 * \brief DMAC interrupt: channel 0 block transfer complete
+			 */
+			void DMAC_Handler() {
+				uTimerLibStream::dmaHandler();
+			}
+		#else
+			/**
+			 * \brief DMAC channel 0 interrupt: block transfer complete
+			 */
+			void DMAC_0_Handler() {
+				uTimerLibStream::dmaHandler();
+			}
+		#endif
+	#endif
+
+#endif
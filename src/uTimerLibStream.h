@@ -0,0 +1,62 @@
+/**
+ * \class uTimerLibStream
+ * \brief Timer-paced DMA streaming for uTimerLib: one sample written to a peripheral each timer period, with no interrupt per sample.
+ *
+ * Only for SAMD21 and SAMD51, and only when UTIMERLIB_USE_DMA is defined (see uTimerLib.h).
+ * Timer overflow triggers a DMAC beat transfer from a circular buffer to a peripheral register (DAC, PORT...).
+ * Buffer is split in two halves (double-buffering): callback is called when each half has been sent,
+ * so it can be refilled while the other one is being sent.
+ *
+ * It uses TimerLib, so any setXXX call on TimerLib will stop the timing of the stream; call end() before.
+ *
+ * Usage:
+ *		* uint16_t samples[256]; uTimerLibStream stream(&DAC->DATA.reg, 2);* : destination register and sample size (1, 2 or 4 bytes).
+ *		* stream.begin(samples, 256, 23, callback_function);* : sends one sample each 23us; callback_function(half) is called when half 0 or 1 has been sent.
+ *		* stream.end();* : stops streaming.
+ *
+ * Timer period must fit in a single compare (SAMD21: up to 1.39s; SAMD51: up to 0.55s).
+ *
+ * Callbacks are called from DMAC interrupt. Its handler is defined only with UTIMERLIB_DMA_HANDLER; otherwise call
+ * uTimerLibStream::dmaHandler() from your DMAC_Handler (SAMD21) or DMAC_0_Handler (SAMD51) and enable its NVIC interrupt.
+ *
+ * SAM (Due) is not supported: its PDC is tied to each peripheral and can't be paced by TC3, the timer used by uTimerLib.
+ *
+ * @file uTimerLibStream.h
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uTimerLib">https://github.com/Naguissa/uTimerLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 1.7.1
+ */
+#ifndef _uTimerLibStream_
+	/**
+	 * \brief Prevent multiple inclussion
+	 */
+	#define _uTimerLibStream_
+
+	#include "uTimerLib.h"
+
+	#if defined(UTIMERLIB_USE_DMA) && (defined(_SAMD21_) || defined(__SAMD51__))
+		class uTimerLibStream {
+			public:
+				uTimerLibStream(volatile void *, uint8_t);
+				bool begin(const void *, uint16_t, unsigned long int, void (*) (uint8_t));
+				void end();
+				static void dmaHandler();
+
+				/**
+				 * \brief Internal function called on each half transfer completion
+				 */
+				static void _interrupt();
+
+			private:
+				static uTimerLibStream *_instance;
+
+				volatile void *_dst;
+				uint8_t _size;
+				void (*_cb)(uint8_t) = NULL;
+				volatile uint8_t _half = 0;
+		};
+	#endif
+
+#endif